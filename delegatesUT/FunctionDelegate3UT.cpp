@@ -82,6 +82,29 @@ namespace ffscriptUT
 		EXPECT_EQ(sum(p1, p2), returnVal);
 	}
 
+	TEST(FunctionDelegate3, testFunction3_thunk)
+	{
+		int p1 = 123;
+		float p2 = 456.0f;
+		FunctionDelegate3<double, int, float> cdelFunction(sum);
+		DFunction2* nativeFunction2 = &cdelFunction;
+
+		void* target = nullptr;
+		DFunctionThunk thunk = nativeFunction2->getThunk(target);
+		ASSERT_NE(nullptr, thunk);
+		EXPECT_NE(nullptr, target);
+
+		char paramData[sizeof(void*) * 2];
+		// argument 1
+		*((int*)&paramData[0]) = p1;
+		// argument 2
+		*((float*)&paramData[sizeof(void*)]) = p2;
+
+		double returnVal;
+		thunk(target, &returnVal, &paramData[0]);
+		EXPECT_EQ(sum(p1, p2), returnVal);
+	}
+
 	TEST(FunctionDelegate3, testFunction3_2)
 	{
 		SampleStruct p1 = { 456, 789.0f };
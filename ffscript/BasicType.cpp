@@ -22,7 +22,13 @@
 #include "Utils.h"
 
 namespace ffscript {
-	static BasicTypes* s_basicType = nullptr;
+	// compilers of different threads have their own basic types
+#if _WIN32 || _WIN64
+	static __declspec(thread) BasicTypes* s_basicType = nullptr;
+// Check GCC
+#elif __GNUC__
+	static __thread BasicTypes* s_basicType = nullptr;
+#endif
 
 	BasicTypes* BasicTypes::getBasicTypes() {
 		return s_basicType;
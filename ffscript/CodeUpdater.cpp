@@ -18,9 +18,17 @@
 #include "Program.h"
 #include "ScriptScope.h"
 #include "GlobalScope.h"
+#include "FunctionScope.h"
 
 namespace ffscript {
 
+#if _WIN32 || _WIN64
+	__declspec(thread) CodeUpdater::DeferredUpdate* _threadDeferredUpdate = nullptr;
+// Check GCC
+#elif __GNUC__
+	__thread CodeUpdater::DeferredUpdate* _threadDeferredUpdate = nullptr;
+#endif
+
 	CodeUpdater::CodeUpdater(ScriptScope* ownerScope) : _ownerScope(ownerScope) {
 	}
 
@@ -28,12 +36,24 @@ namespace ffscript {
 	}
 
 	void CodeUpdater::addUpdateLaterTask(const DelegateRef& task) {
+		if (_threadDeferredUpdate) {
+			_threadDeferredUpdate->updateLaterList.push_back(task);
+			return;
+		}
 		_updateLaterList.push_back(task);
 	}
 
 	void CodeUpdater::clear() {
 		_updateLaterList.clear();
 		_commandExecutorMap.clear();
+		_referencedFunctions.clear();
+		_functionTargetMap.clear();
+		_functionCallMap.clear();
+	}
+
+	void CodeUpdater::clearExtractionTasks() {
+		_updateLaterList.clear();
+		_commandExecutorMap.clear();
 	}
 
 	void CodeUpdater::runUpdate() {
@@ -43,10 +63,25 @@ namespace ffscript {
 	}
 
 	void CodeUpdater::setUpdateInfo(CommandUnitBuilder* commandUnit, Executor* executor) {
+		if (_threadDeferredUpdate) {
+			_threadDeferredUpdate->commandExecutorMap.insert(std::make_pair(commandUnit, executor));
+			return;
+		}
 		_commandExecutorMap.insert(std::make_pair(commandUnit, executor));
 	}
 
 	void CodeUpdater::saveUpdateInfo(CommandUnitBuilder* commandUnit, Executor* executor) {
+		if (_threadDeferredUpdate) {
+			auto& deferredMap = _threadDeferredUpdate->commandExecutorMap;
+			auto it = deferredMap.find(commandUnit);
+			if (it != deferredMap.end()) {
+				it->second = executor;
+			}
+			else if (_commandExecutorMap.find(commandUnit) != _commandExecutorMap.end()) {
+				deferredMap.insert(std::make_pair(commandUnit, executor));
+			}
+			return;
+		}
 		auto it = _commandExecutorMap.find(commandUnit);
 		if (it != _commandExecutorMap.end()) {
 			it->second = executor;
@@ -54,6 +89,13 @@ namespace ffscript {
 	}
 
 	Executor* CodeUpdater::findUpdateInfo(CommandUnitBuilder* commandUnit) const{
+		if (_threadDeferredUpdate) {
+			auto& deferredMap = _threadDeferredUpdate->commandExecutorMap;
+			auto it = deferredMap.find(commandUnit);
+			if (it != deferredMap.end()) {
+				return it->second;
+			}
+		}
 		auto it = _commandExecutorMap.find(commandUnit);
 		if (it != _commandExecutorMap.end()) {
 			return it->second;
@@ -61,6 +103,93 @@ namespace ffscript {
 		return nullptr;
 	}
 
+	bool CodeUpdater::hasUpdateInfo(CommandUnitBuilder* commandUnit) const {
+		if (_threadDeferredUpdate && _threadDeferredUpdate->commandExecutorMap.find(commandUnit) != _threadDeferredUpdate->commandExecutorMap.end()) {
+			return true;
+		}
+		return _commandExecutorMap.find(commandUnit) != _commandExecutorMap.end();
+	}
+
+	void CodeUpdater::addReferencedFunction(int functionId) {
+		if (_threadDeferredUpdate) {
+			_threadDeferredUpdate->referencedFunctions.insert(functionId);
+			return;
+		}
+		_referencedFunctions.insert(functionId);
+	}
+
+	bool CodeUpdater::isFunctionReferenced(int functionId) const {
+		return _referencedFunctions.find(functionId) != _referencedFunctions.end();
+	}
+
+	void CodeUpdater::addFunctionTargetTask(int functionId, const DelegateRef& task) {
+		if (_threadDeferredUpdate) {
+			_threadDeferredUpdate->functionTargetList.push_back(std::make_pair(functionId, task));
+			return;
+		}
+		_functionTargetMap[functionId].push_back(task);
+	}
+
+	void CodeUpdater::updateFunctionTargets(int functionId) {
+		auto it = _functionTargetMap.find(functionId);
+		if (it == _functionTargetMap.end()) {
+			return;
+		}
+		for (const DelegateRef& task : it->second) {
+			task->call();
+		}
+	}
+
+	void CodeUpdater::addFunctionCall(const ScriptScope* callerScope, int calleeId, int extraSize) {
+		const FunctionScope* functionScope = nullptr;
+		for (auto scope = callerScope; scope && functionScope == nullptr; scope = scope->getParent()) {
+			functionScope = dynamic_cast<const FunctionScope*>(scope);
+		}
+		if (functionScope == nullptr) {
+			return;
+		}
+		FunctionCall functionCall = { calleeId, extraSize };
+		if (_threadDeferredUpdate) {
+			_threadDeferredUpdate->functionCallList.push_back(std::make_pair(functionScope->getFunctionId(), functionCall));
+			return;
+		}
+		_functionCallMap[functionScope->getFunctionId()].push_back(functionCall);
+	}
+
+	const std::list<FunctionCall>* CodeUpdater::getFunctionCalls(int functionId) const {
+		auto it = _functionCallMap.find(functionId);
+		if (it == _functionCallMap.end()) {
+			return nullptr;
+		}
+		return &it->second;
+	}
+
+	void CodeUpdater::clearFunctionCalls(int functionId) {
+		_functionCallMap.erase(functionId);
+	}
+
+	void CodeUpdater::mergeDeferredUpdate(DeferredUpdate& deferredUpdate) {
+		_updateLaterList.splice(_updateLaterList.end(), deferredUpdate.updateLaterList);
+		for (auto& elm : deferredUpdate.commandExecutorMap) {
+			_commandExecutorMap[elm.first] = elm.second;
+		}
+		_referencedFunctions.insert(deferredUpdate.referencedFunctions.begin(), deferredUpdate.referencedFunctions.end());
+		deferredUpdate.commandExecutorMap.clear();
+		for (auto& elm : deferredUpdate.functionTargetList) {
+			_functionTargetMap[elm.first].push_back(elm.second);
+		}
+		for (auto& elm : deferredUpdate.functionCallList) {
+			_functionCallMap[elm.first].push_back(elm.second);
+		}
+		deferredUpdate.referencedFunctions.clear();
+		deferredUpdate.functionTargetList.clear();
+		deferredUpdate.functionCallList.clear();
+	}
+
+	void CodeUpdater::setDeferredUpdate(DeferredUpdate* deferredUpdate) {
+		_threadDeferredUpdate = deferredUpdate;
+	}
+
 	CodeUpdater* CodeUpdater::getInstance(const ScriptScope* scope) {
 		if (scope == nullptr) return nullptr;
 		return ((GlobalScope*)scope->getRoot())->getCodeUpdater();
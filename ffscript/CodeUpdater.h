@@ -16,7 +16,9 @@
 #include <list>
 #include <memory>
 #include <map>
+#include <set>
 #include "ffscript.h"
+#include "Program.h"
 
 namespace ffscript {
 
@@ -31,8 +33,22 @@ namespace ffscript {
 	
 	class CodeUpdater
 	{
+	public:
+		// update infos collected by a thread which extracts code in parallel with the others,
+		// they are merged into the code updater after all threads complete
+		struct DeferredUpdate {
+			std::list<DelegateRef> updateLaterList;
+			std::map<CommandUnitBuilder*, Executor*> commandExecutorMap;
+			std::set<int> referencedFunctions;
+			std::list<std::pair<int, DelegateRef>> functionTargetList;
+			std::list<std::pair<int, FunctionCall>> functionCallList;
+		};
+	private:
 		std::list<DelegateRef> _updateLaterList;
 		std::map<CommandUnitBuilder*, Executor*> _commandExecutorMap;
+		std::set<int> _referencedFunctions;
+		std::map<int, std::list<DelegateRef>> _functionTargetMap;
+		std::map<int, std::list<FunctionCall>> _functionCallMap;
 		ScriptScope* _ownerScope;
 	public:
 		CodeUpdater(ScriptScope* ownerScope);
@@ -40,11 +56,32 @@ namespace ffscript {
 		void addUpdateLaterTask(const DelegateRef& task);
 		void runUpdate();
 		void clear();
+		// clear the tasks which are used only while the code is extracted,
+		// the function targets and calls are kept to reload the functions
+		void clearExtractionTasks();
 		void setUpdateInfo(CommandUnitBuilder* commandUnit, Executor* executor);
 		void saveUpdateInfo(CommandUnitBuilder* commandUnit, Executor* executor);
 		Executor* findUpdateInfo(CommandUnitBuilder* commandUnit) const;
+		bool hasUpdateInfo(CommandUnitBuilder* commandUnit) const;
+		void addReferencedFunction(int functionId);
+		bool isFunctionReferenced(int functionId) const;
+		// the task sets the code of a script function to a command which uses it,
+		// run the tasks of a function again to make the commands use its new code
+		void addFunctionTargetTask(int functionId, const DelegateRef& task);
+		void updateFunctionTargets(int functionId);
+		// record a call made by the script function which owns the scope, the calls made
+		// by the global code are not recorded because it does not run on the task contexts
+		void addFunctionCall(const ScriptScope* callerScope, int calleeId, int extraSize);
+		const std::list<FunctionCall>* getFunctionCalls(int functionId) const;
+		void clearFunctionCalls(int functionId);
+		// merge update infos collected in deferred mode, the merging order
+		// must be the same as the order of sequential code extraction
+		void mergeDeferredUpdate(DeferredUpdate& deferredUpdate);
 
 		static CodeUpdater* getInstance(const ScriptScope* scope);
+		// update infos are put to the deferred update instead of the code updater
+		// while it is set for current thread
+		static void setDeferredUpdate(DeferredUpdate* deferredUpdate);
 
 	public:
 		static void updateScriptFunction(Program* program, CallScriptFuntion* command, int functionId);
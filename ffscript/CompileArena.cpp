@@ -0,0 +1,204 @@
+/******************************************************************
+* File:        CompileArena.cpp
+* Description: implement CompileArena and CompileSession classes.
+*              A compile arena is a set of bump regions that serves
+*              the short lived objects of a compiling progress, such
+*              as expression units and candidate lists. A freed block
+*              is reused by the next allocation of the same size, the
+*              regions are released in one step when the compile
+*              session ends and all objects allocated from it are
+*              destroyed.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "CompileArena.h"
+#include <stdlib.h>
+
+namespace ffscript {
+
+#if _WIN32 || _WIN64
+	__declspec(thread) CompileArena* _threadArena = nullptr;
+// Check GCC
+#elif __GNUC__
+	__thread CompileArena* _threadArena = nullptr;
+#endif
+
+	// every block served by the arena is aligned to this size
+	static const size_t ARENA_ALIGNMENT = alignof(std::max_align_t);
+
+	static inline size_t alignSize(size_t size) {
+		return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+	}
+
+	// header of the objects allocated by CompileArena::allocateObject,
+	// it keeps the arena and the size of the object to release it later
+	struct ObjectHeader {
+		CompileArena* arena;
+		size_t size;
+	};
+	static const size_t OBJECT_HEADER_SIZE = alignSize(sizeof(ObjectHeader));
+
+	CompileArena::CompileArena(size_t regionSize) :
+		_regions(nullptr),
+		_regionSize(regionSize),
+		_refCount(1),
+		_allocationCount(0),
+		_allocatedBytes(0),
+		_reusedCount(0),
+		_regionCount(0) {
+		for (int i = 0; i < FREE_LIST_COUNT; i++) {
+			_freeBlocks[i] = nullptr;
+		}
+	}
+
+	CompileArena::~CompileArena() {
+		while (_regions) {
+			Region* next = _regions->next;
+			::free(_regions);
+			_regions = next;
+		}
+	}
+
+	CompileArena::Region* CompileArena::newRegion(size_t capacity) {
+		Region* region = (Region*)malloc(alignSize(sizeof(Region)) + capacity);
+		if (region == nullptr) {
+			throw std::bad_alloc();
+		}
+		region->capacity = capacity;
+		region->used = 0;
+		_regionCount++;
+		return region;
+	}
+
+	void* CompileArena::allocate(size_t size) {
+		size = alignSize(size);
+		size_t sizeClass = size / ARENA_ALIGNMENT - 1;
+		if (sizeClass < (size_t)FREE_LIST_COUNT && _freeBlocks[sizeClass]) {
+			FreeBlock* block = _freeBlocks[sizeClass];
+			_freeBlocks[sizeClass] = block->next;
+			_allocationCount++;
+			_reusedCount++;
+			return block;
+		}
+
+		Region* region = _regions;
+		if (region == nullptr || region->capacity - region->used < size) {
+			if (size > _regionSize / 4) {
+				// a big block has its own region, it is put behind the current region
+				// so the free space of the current region can still be used
+				region = newRegion(size);
+				if (_regions) {
+					region->next = _regions->next;
+					_regions->next = region;
+				}
+				else {
+					region->next = nullptr;
+					_regions = region;
+				}
+			}
+			else {
+				region = newRegion(_regionSize);
+				region->next = _regions;
+				_regions = region;
+			}
+		}
+
+		void* p = (char*)region + alignSize(sizeof(Region)) + region->used;
+		region->used += size;
+		_allocationCount++;
+		_allocatedBytes += size;
+		return p;
+	}
+
+	void CompileArena::free(void* p, size_t size) {
+		// the blocks freed by other threads or after the session are released with the regions
+		if (_threadArena != this) return;
+
+		size_t sizeClass = alignSize(size) / ARENA_ALIGNMENT - 1;
+		if (sizeClass < (size_t)FREE_LIST_COUNT) {
+			FreeBlock* block = (FreeBlock*)p;
+			block->next = _freeBlocks[sizeClass];
+			_freeBlocks[sizeClass] = block;
+		}
+	}
+
+	void CompileArena::addRef() {
+		_refCount++;
+	}
+
+	void CompileArena::release() {
+		if (--_refCount == 0) {
+			delete this;
+		}
+	}
+
+	size_t CompileArena::getAllocationCount() const {
+		return _allocationCount;
+	}
+
+	size_t CompileArena::getAllocatedBytes() const {
+		return _allocatedBytes;
+	}
+
+	size_t CompileArena::getReusedCount() const {
+		return _reusedCount;
+	}
+
+	int CompileArena::getRegionCount() const {
+		return _regionCount;
+	}
+
+	CompileArena* CompileArena::getCurrent() {
+		return _threadArena;
+	}
+
+	void* CompileArena::allocateObject(size_t size) {
+		CompileArena* arena = _threadArena;
+		char* p;
+		if (arena) {
+			arena->addRef();
+			p = (char*)arena->allocate(OBJECT_HEADER_SIZE + size);
+		}
+		else {
+			p = (char*)::operator new(OBJECT_HEADER_SIZE + size);
+		}
+		ObjectHeader* header = (ObjectHeader*)p;
+		header->arena = arena;
+		header->size = size;
+		return p + OBJECT_HEADER_SIZE;
+	}
+
+	void CompileArena::freeObject(void* p) {
+		if (p == nullptr) return;
+
+		char* block = (char*)p - OBJECT_HEADER_SIZE;
+		ObjectHeader* header = (ObjectHeader*)block;
+		CompileArena* arena = header->arena;
+		if (arena) {
+			arena->free(block, OBJECT_HEADER_SIZE + header->size);
+			arena->release();
+		}
+		else {
+			::operator delete(block);
+		}
+	}
+
+	CompileSession::CompileSession(size_t regionSize) : _arena(new CompileArena(regionSize)), _previousArena(_threadArena) {
+		_threadArena = _arena;
+	}
+
+	CompileSession::~CompileSession() {
+		_threadArena = _previousArena;
+		// objects which are still alive keep the arena until they are destroyed
+		_arena->release();
+	}
+
+	CompileArena* CompileSession::getArena() const {
+		return _arena;
+	}
+}
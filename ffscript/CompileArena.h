@@ -0,0 +1,138 @@
+/******************************************************************
+* File:        CompileArena.h
+* Description: declare CompileArena and CompileSession classes.
+*              A compile arena is a set of bump regions that serves
+*              the short lived objects of a compiling progress, such
+*              as expression units and candidate lists. A freed block
+*              is reused by the next allocation of the same size, the
+*              regions are released in one step when the compile
+*              session ends and all objects allocated from it are
+*              destroyed.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <memory>
+
+namespace ffscript {
+
+	class FFSCRIPT_API CompileArena
+	{
+		struct Region {
+			Region* next;
+			size_t capacity;
+			size_t used;
+		};
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+		// number of the size classes of the freed blocks, a class is a multiple of the alignment
+		static const int FREE_LIST_COUNT = 32;
+
+		Region* _regions;
+		size_t _regionSize;
+		// freed blocks indexed by their size class, they are only touched by the thread of the session
+		FreeBlock* _freeBlocks[FREE_LIST_COUNT];
+		// number of alive objects allocated from the arena plus one for the owner session
+		std::atomic<int> _refCount;
+		size_t _allocationCount;
+		size_t _allocatedBytes;
+		size_t _reusedCount;
+		int _regionCount;
+	private:
+		Region* newRegion(size_t capacity);
+	public:
+		CompileArena(size_t regionSize);
+		~CompileArena();
+
+		void* allocate(size_t size);
+		// give back a block of the given size, it is reused by the next allocation of the same size
+		// if it is freed in the thread of the session while the session is running
+		void free(void* p, size_t size);
+		void addRef();
+		// release one reference and free all regions when there is no reference left
+		void release();
+
+		size_t getAllocationCount() const;
+		size_t getAllocatedBytes() const;
+		// number of allocations served by the freed blocks
+		size_t getReusedCount() const;
+		int getRegionCount() const;
+
+		// get the arena of the compile session running in current thread, nullptr if there is no session
+		static CompileArena* getCurrent();
+
+		// allocate an object from the current arena or from the heap if there is no compile session.
+		// Memory allocated by this function must be freed by freeObject.
+		static void* allocateObject(size_t size);
+		static void freeObject(void* p);
+	};
+
+	class FFSCRIPT_API CompileSession
+	{
+		CompileArena* _arena;
+		CompileArena* _previousArena;
+	public:
+		CompileSession(size_t regionSize = 64 * 1024);
+		~CompileSession();
+
+		CompileArena* getArena() const;
+	};
+
+	// allocator used by the containers which only live in a compiling progress
+	template <class T>
+	class CompileAllocator
+	{
+		template <class U> friend class CompileAllocator;
+		CompileArena* _arena;
+	public:
+		typedef T value_type;
+
+		CompileAllocator() : _arena(CompileArena::getCurrent()) {}
+		template <class U>
+		CompileAllocator(const CompileAllocator<U>& other) : _arena(other._arena) {}
+
+		T* allocate(size_t n) {
+			if (_arena) {
+				_arena->addRef();
+				return (T*)_arena->allocate(n * sizeof(T));
+			}
+			return (T*)::operator new(n * sizeof(T));
+		}
+
+		void deallocate(T* p, size_t n) {
+			if (_arena) {
+				_arena->free(p, n * sizeof(T));
+				_arena->release();
+			}
+			else {
+				::operator delete(p);
+			}
+		}
+
+		template <class U>
+		bool operator==(const CompileAllocator<U>& other) const {
+			return _arena == other._arena;
+		}
+
+		template <class U>
+		bool operator!=(const CompileAllocator<U>& other) const {
+			return _arena != other._arena;
+		}
+	};
+
+	// create a shared object in the arena of the current compile session
+	template <class T, class... Args>
+	std::shared_ptr<T> makeCompileShared(Args&&... args) {
+		return std::allocate_shared<T>(CompileAllocator<T>(), std::forward<Args>(args)...);
+	}
+}
@@ -11,10 +11,25 @@
 **********************************************************************/
 
 #include "CompilerSuite.h"
+#include "CompileArena.h"
 #include "ExpresionParser.h"
+#include "DebugInfo.h"
+#include <functional>
 
 namespace ffscript{
-	CompilerSuite::CompilerSuite()
+	static void resolveSourcePositions(DebugInfo* debugInfo, const Preprocessor* sourceMap, const wchar_t* codeStart, const wchar_t* codeEnd) {
+		if (debugInfo == nullptr) return;
+		debugInfo->resolveSourcePositions([&](int charIndex, int& line, int& column) {
+			if (sourceMap) {
+				sourceMap->getOriginalPosition(charIndex, line, column);
+			}
+			else {
+				DebugInfo::getTextPosition(codeStart, codeEnd, charIndex, line, column);
+			}
+		});
+	}
+
+	CompilerSuite::CompilerSuite() : _debugInfoEnabled(false)
 	{
 		_pCompiler = (ScriptCompilerRef)(new ScriptCompiler());
 	}
@@ -24,35 +39,40 @@ namespace ffscript{
 	}
 
 	void CompilerSuite::initialize(int globalMemSize) {
-		_globalScopeRef = (GlobalScopeRef)(new GlobalScope(globalMemSize, _pCompiler.get()));
-
-		FunctionRegisterHelper funcLibHelper(_pCompiler.get());
-		
-		auto& typeManager = _pCompiler->getTypeManager();
-
-		typeManager->registerBasicTypes(_pCompiler.get());
-		typeManager->registerBasicTypeCastFunctions(_pCompiler.get(), funcLibHelper);
-		typeManager->registerConstants(_pCompiler.get());
+		// the basic library is registered once, then each suite gets a copy of it
+		initialize(globalMemSize, SystemLibrary::getBasicLibrary());
+	}
 
-		importBasicfunction(funcLibHelper);
+	void CompilerSuite::initialize(int globalMemSize, const SystemLibraryRef& systemLibrary) {
+		_pCompiler = systemLibrary->createCompiler();
+		_globalScopeRef = (GlobalScopeRef)(new GlobalScope(globalMemSize, _pCompiler.get()));
 
 		_pCompiler->beginUserLib();
 	}
 
 	Program* CompilerSuite::compileProgram(const wchar_t* codeStart, const wchar_t* codeEnd) {
 		_pCompiler->clearUserLib();
+		// temporary objects of the compiling progress are allocated from the session's arena
+		CompileSession compileSession;
+		// the units kept by the scopes are released before the session ends, so the arena is freed with it
+		unique_ptr<GlobalScope, std::function<void(GlobalScope*)>> compileUnitsScope(_globalScopeRef.get(), [](GlobalScope* globalScope) {
+			globalScope->releaseCompileUnits();
+		});
+
+		std::shared_ptr<std::wstring> newCode;
+		if (_preprocessor) {
+			newCode = _preprocessor->preprocess(codeStart, codeEnd);
+			codeStart = newCode->c_str();
+			codeEnd = codeStart + newCode->size();
+		}
 
 		Program* program = new Program();
+		if (_debugInfoEnabled) {
+			program->enableDebugInfo();
+		}
 		_pCompiler->bindProgram(program);
 
-		if (_preprocessor) {
-			auto newCode = _preprocessor->preprocess(codeStart, codeEnd);
-
-			if (_globalScopeRef->parse(newCode->c_str(), newCode->c_str() + newCode->size()) == nullptr) {
-				return nullptr;
-			}
-		}
-		else if (_globalScopeRef->parse(codeStart, codeEnd) == nullptr) {
+		if (_globalScopeRef->parse(codeStart, codeEnd) == nullptr) {
 			return nullptr;
 		}
 
@@ -64,11 +84,34 @@ namespace ffscript{
 			delete program;
 			return nullptr;
 		}
+		// the positions in the preprocessed code are mapped to the original code by the preprocessor
+		resolveSourcePositions(program->getDebugInfo(), _preprocessor.get(), codeStart, codeEnd);
 
 		return program;
 	}
 
+	bool CompilerSuite::reloadFunction(Program* program, const wchar_t* codeStart, const wchar_t* codeEnd) {
+		CompileSession compileSession;
+		unique_ptr<GlobalScope, std::function<void(GlobalScope*)>> compileUnitsScope(_globalScopeRef.get(), [](GlobalScope* globalScope) {
+			globalScope->releaseCompileUnits();
+		});
+		bool res;
+		if (_preprocessor) {
+			auto newCode = _preprocessor->preprocess(codeStart, codeEnd);
+			res = _globalScopeRef->reloadFunction(program, newCode->c_str(), newCode->c_str() + newCode->size());
+		}
+		else {
+			res = _globalScopeRef->reloadFunction(program, codeStart, codeEnd);
+		}
+		if (res) {
+			// the positions of the new code are in the reloaded code
+			resolveSourcePositions(program->getDebugInfo(), _preprocessor.get(), codeStart, codeEnd);
+		}
+		return res;
+	}
+
 	ExpUnitExecutor* CompilerSuite::compileExpression(const wchar_t* expression) {
+		CompileSession compileSession;
 		ExpressionParser parser(_pCompiler.get());
 		_pCompiler->pushScope(_globalScopeRef.get());
 
@@ -128,4 +171,12 @@ namespace ffscript{
 			_preprocessor->getOriginalPosition((int)(lastCompileChar - beginCompileChar), line, column);
 		}
 	}
-}
\ No newline at end of file
+
+	void CompilerSuite::setDebugInfoEnabled(bool enabled) {
+		_debugInfoEnabled = enabled;
+	}
+
+	bool CompilerSuite::isDebugInfoEnabled() const {
+		return _debugInfoEnabled;
+	}
+}
@@ -25,6 +25,7 @@
 #include "BasicType.h"
 #include "ExpUnitExecutor.h"
 #include "Preprocessor.h"
+#include "SystemLibrary.h"
 
 namespace ffscript {
 	class CompilerSuite
@@ -33,12 +34,19 @@ namespace ffscript {
 		ScriptCompilerRef _pCompiler;
 		GlobalScopeRef _globalScopeRef;
 		PreprocessorRef _preprocessor;
+		bool _debugInfoEnabled;
 	public:
 		CompilerSuite();
 		virtual void initialize(int globalMemSize);
+		// initialize the suite with a compiler shares the given frozen system library
+		void initialize(int globalMemSize, const SystemLibraryRef& systemLibrary);
 		virtual ~CompilerSuite();
 
 		Program* compileProgram(const wchar_t* codeStart, const wchar_t* codeEnd);
+		// compile a new definition of a function of a program compiled by this suite,
+		// the tasks of the program call the new code from their next call of the function.
+		// It fails if a task is running the program
+		bool reloadFunction(Program* program, const wchar_t* codeStart, const wchar_t* codeEnd);
 		ExpUnitExecutor* compileExpression(const wchar_t* expression);
 		const GlobalScopeRef& getGlobalScope() const;
 		const TypeManagerRef& getTypeManager() const;
@@ -46,5 +54,8 @@ namespace ffscript {
 		void setPreprocessor(const PreprocessorRef& preprocessor);
 		const PreprocessorRef getPreprocessor() const;
 		void getLastCompliedPosition(int& line, int& column);
+		// the programs compiled after it is set have a debug info table, it is off by default
+		void setDebugInfoEnabled(bool enabled);
+		bool isDebugInfoEnabled() const;
 	};
 }
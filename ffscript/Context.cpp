@@ -14,6 +14,9 @@
 #include <stdlib.h>
 #include "InstructionCommand.h"
 #include "ScopeRuntimeData.h"
+#include "GlobalDataView.h"
+#include "ScriptProfiler.h"
+#include "Instrumentation.h"
 
 #include <iomanip>
 #include <sstream>
@@ -48,10 +51,20 @@ namespace ffscript {
 		_endCommand(nullptr),
 		_beforeJump(nullptr),
 		_allocatedStack(RaiseStackOverflow),
+		_stackHighWaterMark(0),
 #ifdef REDUCE_SCOPE_ALLOCATING_MEM
 		_scopeCodeSize(RaiseStackOverflow),
 #endif
-		_contextStack(RaiseStackOverflow)
+		_contextStack(RaiseStackOverflow),
+		_globalImageBegin(nullptr),
+		_globalImageSize(0),
+		_globalViewDistance(0),
+		_profiler(nullptr)
+#if FFSCRIPT_INSTRUMENTATION
+		, _callFrames(RaiseStackOverflow)
+		, _sampleRequested(false)
+		, _instrumentation(new Instrumentation())
+#endif
 	{
 		Context::makeCurrent(this);
 		_threadData = (unsigned char*)malloc(_dataSize);
@@ -65,10 +78,20 @@ namespace ffscript {
 		_dataSize(bufferSize), _threadData(threadData), _currentOffset(0), _allocatedBuffer(false),
 		_currentCommand(nullptr), _endCommand(nullptr),
 		_allocatedStack(RaiseStackOverflow),
+		_stackHighWaterMark(0),
 #ifdef REDUCE_SCOPE_ALLOCATING_MEM
 		_scopeCodeSize(RaiseStackOverflow),
 #endif
-		_contextStack(RaiseStackOverflow)
+		_contextStack(RaiseStackOverflow),
+		_globalImageBegin(nullptr),
+		_globalImageSize(0),
+		_globalViewDistance(0),
+		_profiler(nullptr)
+#if FFSCRIPT_INSTRUMENTATION
+		, _callFrames(RaiseStackOverflow)
+		, _sampleRequested(false)
+		, _instrumentation(new Instrumentation())
+#endif
 	{
 		Context::makeCurrent(this);
 		_isError = false;
@@ -77,6 +100,13 @@ namespace ffscript {
 
 	Context::~Context()
 	{
+		auto profiler = getProfiler();
+		if (profiler) {
+			profiler->detach(this);
+		}
+#if FFSCRIPT_INSTRUMENTATION
+		delete _instrumentation;
+#endif
 		_threadContext = nullptr;
 		if (_allocatedBuffer) {
 			free(_threadData);
@@ -131,6 +161,14 @@ namespace ffscript {
 			RAISE_STACK_OVERFLOW_ERROR();
 			return;
 		}
+		unsigned int stackSize = _currentOffset +
+#ifdef REDUCE_SCOPE_ALLOCATING_MEM
+			scopeCodeSize +
+#endif
+			_allocatedStack.front();
+		if (stackSize > _stackHighWaterMark) {
+			_stackHighWaterMark = stackSize;
+		}
 #ifdef REDUCE_SCOPE_ALLOCATING_MEM
 		_scopeCodeSize.push_front(scopeCodeSize);
 #endif
@@ -154,6 +192,12 @@ namespace ffscript {
 	void Context::pushContext(unsigned int scopeParam) {
 		ScopeRuntimeData* scopeData = ScopeRuntimeData::createRuntimeData(scopeParam);
 		_contextStack.push_front({_beforeJump, scopeData });
+		INSTRUMENT_CONTEXT(this, onScopeEnter());
+#if FFSCRIPT_INSTRUMENTATION
+		if (scopeData) {
+			_instrumentation->onHeapAllocation(scopeData, scopeData->getAllocatedSize());
+		}
+#endif
 	}
 	
 	void Context::popContext() {
@@ -164,6 +208,7 @@ namespace ffscript {
 		}
 
 		_contextStack.pop_front();
+		INSTRUMENT_CONTEXT(this, onScopeExit());
 	}
 	
 	ScopeRuntimeData* Context::getScopeRuntimeData() const {
@@ -184,10 +229,32 @@ namespace ffscript {
 		return size;
 	}
 
+	void Context::setGlobalDataView(const GlobalDataView* globalDataView) {
+		if (globalDataView) {
+			auto& image = globalDataView->getImage();
+			_globalImageBegin = image->getImageBegin();
+			_globalImageSize = image->getImageSize();
+			_globalViewDistance = globalDataView->getData() - _globalImageBegin;
+		}
+		else {
+			_globalImageBegin = nullptr;
+			_globalImageSize = 0;
+			_globalViewDistance = 0;
+		}
+	}
+
 	int Context::getMemCapacity() const {
 		return _dataSize;
 	}
 
+	unsigned int Context::getStackHighWaterMark() const {
+		return _stackHighWaterMark;
+	}
+
+	void Context::resetStackHighWaterMark() {
+		_stackHighWaterMark = 0;
+	}
+
 	void Context::write(unsigned int offset, const void* data, unsigned int size) {
 		if ( offset + size > _dataSize) {
 			RAISE_STACK_OVERFLOW_ERROR();
@@ -215,7 +282,11 @@ namespace ffscript {
 	}
 
 	void Context::lea(unsigned int offset, void* value) {
-		//if (offset + sizeof(value) > _dataSize) return -1;
+		// a function call stores its return address before the function allocates its scope
+		if (offset + sizeof(value) > _dataSize) {
+			RAISE_STACK_OVERFLOW_ERROR();
+			return;
+		}
 		size_t* pointer = (size_t*)getAbsoluteAddress(offset);
 		*pointer = (size_t) value;
 	}
@@ -255,14 +326,41 @@ namespace ffscript {
 		return stream.str();
 	}
 
+#if FFSCRIPT_INSTRUMENTATION
+	// keep the first command of a running script function in the call frames of the context
+	class CallFrame {
+		Context* _context;
+	public:
+		CallFrame(Context* context) : _context(context) {
+			context->_callFrames.push_front(context->_currentCommand);
+		}
+		~CallFrame() {
+			_context->_callFrames.pop_front();
+			// a sample requested while the context is idle is dropped
+			if (_context->_callFrames.getSize() == 0) {
+				_context->_sampleRequested.store(false, std::memory_order_relaxed);
+			}
+		}
+	};
+#endif
+
 	void Context::runFunctionScript() {
 #ifndef THROW_EXCEPTION_ON_ERROR
 		if (_isError) return;
 #endif
 		int stackLevel = _allocatedStack.getSize();
+#if FFSCRIPT_INSTRUMENTATION
+		CallFrame callFrame(this);
+#endif
 		while (_currentCommand != _endCommand) {
 			//const std::string& commandText = (*_currentCommand)->toString();
 			//Logger::WriteMessage((int_to_hex((size_t)_currentCommand) + " " + commandText).c_str());
+			INSTRUMENT_CONTEXT(this, onCommand(*_currentCommand));
+#if FFSCRIPT_INSTRUMENTATION
+			if (_sampleRequested.load(std::memory_order_relaxed)) {
+				takeSample();
+			}
+#endif
 			(*_currentCommand)->execute();
 
 			if (_allocatedStack.getSize() != stackLevel
@@ -286,6 +384,12 @@ namespace ffscript {
 			while (_currentCommand != _endCommand) {
 				//const std::string& commandText = (*_currentCommand)->toString();
 				//Logger::WriteMessage((int_to_hex((size_t)_currentCommand) + " " + commandText).c_str());
+				INSTRUMENT_CONTEXT(this, onCommand(*_currentCommand));
+#if FFSCRIPT_INSTRUMENTATION
+				if (_sampleRequested.load(std::memory_order_relaxed)) {
+					takeSample();
+				}
+#endif
 				(*_currentCommand)->execute();
 #ifndef THROW_EXCEPTION_ON_ERROR
 				if (_isError) {
@@ -296,4 +400,39 @@ namespace ffscript {
 			}
 		}
 	}
+
+#if FFSCRIPT_INSTRUMENTATION
+	const CallFrameStack& Context::getCallFrames() const {
+		return _callFrames;
+	}
+#endif
+
+	void Context::setProfiler(ScriptProfiler* profiler) {
+		std::lock_guard<std::mutex> lock(_profilerLock);
+		_profiler = profiler;
+#if FFSCRIPT_INSTRUMENTATION
+		_sampleRequested = false;
+#endif
+	}
+
+	ScriptProfiler* Context::getProfiler() const {
+		std::lock_guard<std::mutex> lock(_profilerLock);
+		return _profiler;
+	}
+
+	void Context::requestSample() {
+#if FFSCRIPT_INSTRUMENTATION
+		_sampleRequested.store(true, std::memory_order_relaxed);
+#endif
+	}
+
+#if FFSCRIPT_INSTRUMENTATION
+	void Context::takeSample() {
+		_sampleRequested.store(false, std::memory_order_relaxed);
+		std::lock_guard<std::mutex> lock(_profilerLock);
+		if (_profiler) {
+			_profiler->recordSample(this);
+		}
+	}
+#endif
 }
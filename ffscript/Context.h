@@ -14,6 +14,8 @@
 #include "ffscript.h"
 #include "SingleList.h"
 #include "FFStack.h"
+#include <atomic>
+#include <mutex>
 class DFunction;
 
 #define THROW_EXCEPTION_ON_ERROR
@@ -22,6 +24,9 @@ class DFunction;
 namespace ffscript {
 
 	class ScopeRuntimeData;
+	class GlobalDataView;
+	class ScriptProfiler;
+	class Instrumentation;
 
 	struct ContextInfo {
 		CommandPointer _command;
@@ -33,6 +38,9 @@ namespace ffscript {
 
 	typedef FFStack<unsigned int, 4096> ScopeAllocatedStack;
 	typedef FFStack<ContextInfo, 4096> ContextStack;
+#if FFSCRIPT_INSTRUMENTATION
+	typedef FFStack<CommandPointer, 4096> CallFrameStack;
+#endif
 
 	class Context
 	{
@@ -46,10 +54,31 @@ namespace ffscript {
 		CommandPointer _beforeJump;
 		CommandPointer _endCommand;
 		ScopeAllocatedStack _allocatedStack;
+		// the largest stack size allocated by the scopes since the context is created or the mark is reset,
+		// it is updated when a scope allocates its data instead of on every write
+		unsigned int _stackHighWaterMark;
 #ifdef REDUCE_SCOPE_ALLOCATING_MEM
 		ScopeAllocatedStack _scopeCodeSize;
 #endif
 		ContextStack _contextStack;
+		// the global memory which the code is compiled with and its distance to the global data view of the context
+		unsigned char* _globalImageBegin;
+		size_t _globalImageSize;
+		ptrdiff_t _globalViewDistance;
+		// a sample is recorded while the lock is held, so the profiler can be detached
+		// from another thread without destroying it under a running sample
+		ScriptProfiler* _profiler;
+		mutable std::mutex _profilerLock;
+#if FFSCRIPT_INSTRUMENTATION
+		// first commands of the script functions which are running, the last one is the innermost function
+		CallFrameStack _callFrames;
+		std::atomic<bool> _sampleRequested;
+		Instrumentation* _instrumentation;
+
+		friend class CallFrame;
+	private:
+		void takeSample();
+#endif
 	public:
 		Context(unsigned char* threadData, unsigned int bufferSize);
 		Context(unsigned int stackSize);
@@ -59,6 +88,8 @@ namespace ffscript {
 		int getCurrentScopeSize() const;
 		unsigned int getTotalAllocatedSize() const;
 		int getMemCapacity() const;
+		unsigned int getStackHighWaterMark() const;
+		void resetStackHighWaterMark();
 		bool isError() const;
 		void moveOffset(int size);
 		void pushScope();
@@ -73,6 +104,12 @@ namespace ffscript {
 		void lea(unsigned int offset, void* value);
 		bool prepareWrite(unsigned int offset, unsigned int size);
 		inline void* getAbsoluteAddress(unsigned int offset) { return (void*)(_threadData + offset); }
+		// the global variables are accessed through the view instead of the global memory of the program
+		void setGlobalDataView(const GlobalDataView* globalDataView);
+		// address of a global variable in the global data view, other addresses are not changed
+		inline void* getGlobalAddress(void* address) const {
+			return (size_t)((unsigned char*)address - _globalImageBegin) < _globalImageSize ? (unsigned char*)address + _globalViewDistance : address;
+		}
 		CommandPointer getCurrentCommand() const;
 		CommandPointer getEndCommand() const;
 		void jump(CommandPointer commandPointer);
@@ -82,6 +119,23 @@ namespace ffscript {
 		virtual void run();
 		virtual void runFunctionScript();
 
+#if FFSCRIPT_INSTRUMENTATION
+		const CallFrameStack& getCallFrames() const;
+#endif
+		// the profiler is notified when the context is deleted
+		void setProfiler(ScriptProfiler* profiler);
+		ScriptProfiler* getProfiler() const;
+		// the context records a sample to its profiler before it runs the next command.
+		// The call frames are tracked only if the library is built with FFSCRIPT_INSTRUMENTATION,
+		// otherwise the request is ignored
+		void requestSample();
+		// counters and trace of the context, it is null if the library is built without FFSCRIPT_INSTRUMENTATION
+#if FFSCRIPT_INSTRUMENTATION
+		inline Instrumentation* getInstrumentation() const { return _instrumentation; }
+#else
+		inline Instrumentation* getInstrumentation() const { return nullptr; }
+#endif
+
 		static Context* getCurrent();
 		static void makeCurrent(Context* context);
 	};
@@ -590,11 +590,25 @@ namespace ffscript {
 
 		auto updateLaterMan = CodeUpdater::getInstance(this);
 
+		// statements after a return, break or continue command in the same scope are never run
+		bool unreachable = false;
+		// executors of the scope in order, the controller executors get the source position of the expressions near them
+		std::vector<Executor*> scopeExecutors;
+
 		int expressionCount = this->getCommandUnitCount();
 		for (auto it = getFirstCommandUnitRefIter(); expressionCount > 0; ++it, --expressionCount) {
 			const CommandUnitRef& commandUnit = *it;
 			const ExecutableUnitRef& extUnit = dynamic_pointer_cast<ExecutableUnit>(commandUnit);
 
+			if (commandUnit.get() == _beginExitScopeUnit) {
+				// the exit scope code is the target of return, break and continue commands
+				unreachable = false;
+			}
+			else if (unreachable && extUnit.get() && updateLaterMan->hasUpdateInfo(extUnit.get()) == false) {
+				// the expression is not referenced by any other command, so it can be eliminated
+				continue;
+			}
+
 			if (extUnit.get()) {
 				//ExecutorRef pExecutor = (ExecutorRef)(new ExpUnitExecutor(_functionScope));
 				ExecutorRef pExecutor = (ExecutorRef)(new ExpUnitExecutor(this));
@@ -613,6 +627,12 @@ namespace ffscript {
 				ExecutorRef pExecutor = (ExecutorRef)(controllerUnit->buildNativeCommand());
 				program->addExecutor((ExecutorRef)(pExecutor));
 
+				if (dynamic_cast<ReturnCommandBuilder*>(controllerUnit) ||
+					dynamic_cast<ReturnCommandBuilder2*>(controllerUnit) ||
+					dynamic_cast<BreakCommandBuilder*>(controllerUnit)) {
+					unreachable = true;
+				}
+
 				if (_beginExecutor == nullptr) {
 					_beginExecutor = pExecutor;
 				}
@@ -620,6 +640,17 @@ namespace ffscript {
 			}
 			//save the link between expression unit and its executor
 			updateLaterMan->saveUpdateInfo(commandUnit.get(), _endExecutor.get());
+			scopeExecutors.push_back(_endExecutor.get());
+		}
+
+		int nearCharIndex = -1;
+		for (auto it = scopeExecutors.rbegin(); it != scopeExecutors.rend(); ++it) {
+			if ((*it)->getSourceCharIndex() >= 0) nearCharIndex = (*it)->getSourceCharIndex();
+			else (*it)->setSourceCharIndex(nearCharIndex);
+		}
+		for (auto it = scopeExecutors.begin(); it != scopeExecutors.end(); ++it) {
+			if ((*it)->getSourceCharIndex() >= 0) nearCharIndex = (*it)->getSourceCharIndex();
+			else (*it)->setSourceCharIndex(nearCharIndex);
 		}
 
 		int childrenBaseOffset = getBaseOffset() + getDataSize();
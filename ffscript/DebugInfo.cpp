@@ -0,0 +1,121 @@
+/******************************************************************
+* File:        DebugInfo.cpp
+* Description: implement DebugInfo class. A side table of a program
+*              keeps the debug metadata of its commands: names of
+*              the called functions, source positions of the plain
+*              code and the text of the commands. The commands do not
+*              carry any string, so the table is created only when
+*              the debug info is required.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "DebugInfo.h"
+#include "InstructionCommand.h"
+#include "ScriptCompiler.h"
+#include "Program.h"
+
+namespace ffscript {
+
+#if _WIN32 || _WIN64
+	__declspec(thread) const DebugInfo* _threadDebugInfo = nullptr;
+// Check GCC
+#elif __GNUC__
+	__thread const DebugInfo* _threadDebugInfo = nullptr;
+#endif
+
+	DebugInfo::DebugInfo() {}
+	DebugInfo::~DebugInfo() {}
+
+	void DebugInfo::setCommandName(const InstructionCommand* command, const std::string& name) {
+		std::unique_lock<std::mutex> lk(_mutex);
+		_commandNames[command] = name;
+	}
+
+	const std::string* DebugInfo::getCommandName(const InstructionCommand* command) const {
+		std::unique_lock<std::mutex> lk(_mutex);
+		auto it = _commandNames.find(command);
+		if (it == _commandNames.end()) {
+			return nullptr;
+		}
+		return &it->second;
+	}
+
+	void DebugInfo::addSourceRange(CommandPointer begin, CommandPointer end, int charIndex) {
+		SourceRange& sourceRange = _sourceRanges[begin];
+		sourceRange.end = end;
+		sourceRange.position = { charIndex, -1, -1 };
+		sourceRange.resolved = false;
+	}
+
+	void DebugInfo::resolveSourcePositions(const std::function<void(int charIndex, int& line, int& column)>& getPosition) {
+		for (auto it = _sourceRanges.begin(); it != _sourceRanges.end(); ++it) {
+			if (!it->second.resolved) {
+				SourcePosition& position = it->second.position;
+				getPosition(position.charIndex, position.line, position.column);
+				it->second.resolved = true;
+			}
+		}
+	}
+
+	const SourcePosition* DebugInfo::getSourcePosition(CommandPointer command) const {
+		auto it = _sourceRanges.upper_bound(command);
+		if (it == _sourceRanges.begin()) {
+			return nullptr;
+		}
+		--it;
+		return command <= it->second.end ? &it->second.position : nullptr;
+	}
+
+	int DebugInfo::getSourceRangeCount() const {
+		return (int)_sourceRanges.size();
+	}
+
+	void DebugInfo::buildCommandText(CommandPointer begin, CommandPointer end, std::list<std::string>& strCommands) const {
+		auto previousDebugInfo = _threadDebugInfo;
+		_threadDebugInfo = this;
+		try {
+			for (auto it = begin; it != end; ++it) {
+				(*it)->buildCommandText(strCommands);
+			}
+		}
+		catch (...) {
+			_threadDebugInfo = previousDebugInfo;
+			throw;
+		}
+		_threadDebugInfo = previousDebugInfo;
+	}
+
+	void DebugInfo::recordCommandName(ScriptCompiler* scriptCompiler, const InstructionCommand* command, const std::string& name) {
+		Program* program = scriptCompiler->getProgram();
+		if (program && program->getDebugInfo()) {
+			program->getDebugInfo()->setCommandName(command, name);
+		}
+	}
+
+	const DebugInfo* DebugInfo::getCurrent() {
+		return _threadDebugInfo;
+	}
+
+	void DebugInfo::getTextPosition(const wchar_t* begin, const wchar_t* end, int charIndex, int& line, int& column) {
+		line = -1;
+		column = -1;
+		if (charIndex < 0 || charIndex >= (int)(end - begin)) return;
+
+		const wchar_t* lineStart = begin;
+		const wchar_t* c = begin;
+		const wchar_t* target = begin + charIndex;
+		line = 0;
+		for (; c < target; c++) {
+			if (*c == '\n') {
+				line++;
+				lineStart = c + 1;
+			}
+		}
+		column = (int)(target - lineStart);
+	}
+}
@@ -0,0 +1,77 @@
+/******************************************************************
+* File:        DebugInfo.h
+* Description: declare DebugInfo class. A side table of a program
+*              keeps the debug metadata of its commands: names of
+*              the called functions, source positions of the plain
+*              code and the text of the commands. The commands do not
+*              carry any string, so the table is created only when
+*              the debug info is required.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <functional>
+#include <mutex>
+
+namespace ffscript {
+
+	class ScriptCompiler;
+
+	struct SourcePosition {
+		// index of the first char of the expression in the compiled code
+		int charIndex;
+		// line and column in the original code, they are -1 if they are not resolved
+		int line;
+		int column;
+	};
+
+	class FFSCRIPT_API DebugInfo
+	{
+		struct SourceRange {
+			CommandPointer end;
+			SourcePosition position;
+			bool resolved;
+		};
+
+		// names of the call commands, the names are added by the extraction threads
+		std::unordered_map<const InstructionCommand*, std::string> _commandNames;
+		// source position of the plain code of each expression by its first command
+		std::map<CommandPointer, SourceRange> _sourceRanges;
+		mutable std::mutex _mutex;
+	public:
+		DebugInfo();
+		virtual ~DebugInfo();
+
+		void setCommandName(const InstructionCommand* command, const std::string& name);
+		// the name of the command or null if the command has no name
+		const std::string* getCommandName(const InstructionCommand* command) const;
+
+		// the commands from begin to end, end included, are compiled from the expression at the char index
+		void addSourceRange(CommandPointer begin, CommandPointer end, int charIndex);
+		// set the line and column of the source positions which are not resolved yet
+		void resolveSourcePositions(const std::function<void(int charIndex, int& line, int& column)>& getPosition);
+		// the source position of the expression which the command is compiled from,
+		// null if the command is not a command of the plain code
+		const SourcePosition* getSourcePosition(CommandPointer command) const;
+		int getSourceRangeCount() const;
+
+		// text of the commands from begin to end, end excluded, the call commands are named by this table
+		void buildCommandText(CommandPointer begin, CommandPointer end, std::list<std::string>& strCommands) const;
+
+		// keep the name of a command in the debug info of the program bound to the compiler, if it has one
+		static void recordCommandName(ScriptCompiler* scriptCompiler, const InstructionCommand* command, const std::string& name);
+		// the table used to name the commands while their texts are built on the current thread
+		static const DebugInfo* getCurrent();
+		// line and column of a char of a text, both are zero based and they are -1 if the char is not in the text
+		static void getTextPosition(const wchar_t* begin, const wchar_t* end, int charIndex, int& line, int& column);
+	};
+}
@@ -13,9 +13,12 @@
 #include "Context.h"
 #include "ffscript.h"
 #include "ScopeRuntimeData.h"
+#include "Instrumentation.h"
 #include "ScriptCompiler.h"
 #include "Program.h"
 #include "ScriptScope.h"
+#include "CodeUpdater.h"
+#include "DebugInfo.h"
 
 #include <sstream>
 
@@ -384,16 +387,25 @@ namespace ffscript {
 
 				auto callScriptFunctionFunc = new CallScriptFuntion3();
 				callScriptFunctionFunc->setCommandData(beginOffset + maxParamSize, beginOffset, returnSize);
-				callScriptFunctionFunc->setFunctionName(operatorFunction->toString());
+				DebugInfo::recordCommandName(scriptCompiler, callScriptFunctionFunc, operatorFunction->toString());
 				callScriptFunctionFunc->setTargetCommand(pFunctionCode->first);
 
 				itemConstructor = callScriptFunctionFunc;
 			}
+			delete operatorFunction;
 
 			constructorItems.push_back(itemConstructor);
 			_itemOffsets.push_back(buildItemInfo.itemOffset);
 		}
 
+		// the operators run after the code space of current scope and their operator context
+		auto updateLaterMan = CodeUpdater::getInstance(currentScope);
+		if (updateLaterMan) {
+			for (auto it = operatorInfoList.begin(); it != operatorInfoList.end(); it++) {
+				updateLaterMan->addFunctionCall(currentScope, it->functionId, maxReturnSize + maxParamSize);
+			}
+		}
+
 		enterOperatorContext->setScopeInfo(0, maxReturnSize + maxParamSize, 0);
 
 		ExitContextScope* exitOperatorConext = new ExitContextScope();
@@ -483,8 +495,10 @@ namespace ffscript {
 	void runtimeFunctionInfoCopyConstructor(RuntimeFunctionInfo* obj1, RuntimeFunctionInfo* obj2) {
 		memcpy_s(obj1, sizeof(RuntimeFunctionInfo), obj2, sizeof(RuntimeFunctionInfo));
 		auto& anoynymousInfo = obj2->anoynymousInfo;
-		if (anoynymousInfo.data && anoynymousInfo.dataSize) {
+		// inline captured data is already copied with the object
+		if (!isInlineAnoynymousData(anoynymousInfo) && anoynymousInfo.data) {
 			obj1->anoynymousInfo.data = malloc(anoynymousInfo.dataSize);
+			INSTRUMENT_CONTEXT(Context::getCurrent(), onHeapAllocation(obj1->anoynymousInfo.data, (unsigned int)anoynymousInfo.dataSize));
 			memcpy_s(obj1->anoynymousInfo.data, anoynymousInfo.dataSize, anoynymousInfo.data, anoynymousInfo.dataSize);
 		}
 	}
@@ -494,7 +508,7 @@ namespace ffscript {
 	}
 
 	void runtimeFunctionInfoDestructor(RuntimeFunctionInfo* obj) {
-		if (obj->anoynymousInfo.data) {
+		if (!isInlineAnoynymousData(obj->anoynymousInfo) && obj->anoynymousInfo.data) {
 			free(obj->anoynymousInfo.data);
 			obj->anoynymousInfo.data = nullptr;
 		}
@@ -538,7 +552,7 @@ namespace ffscript {
 				int allocatedSize = _returnSize + paramSize;
 				context.scopeAllocate(allocatedSize, 0);
 
-				if (runtimeInfo->anoynymousInfo.data == nullptr || runtimeInfo->anoynymousInfo.dataSize == 0) {
+				if (runtimeInfo->anoynymousInfo.dataSize == 0) {
 					CallScriptFuntion3 callScriptFunction;
 					callScriptFunction.setTargetCommand(targetCommand);
 					callScriptFunction.setCommandData(returnOffset, paramOffset, paramSize);
@@ -554,6 +568,7 @@ namespace ffscript {
 				context.scopeUnallocate(allocatedSize, 0);
 			}
 		});
+		INSTRUMENT_CONTEXT(Context::getCurrent(), onHeapAllocation(pThread, (unsigned int)sizeof(std::thread)));
 
 		*(THREAD_HANDLE*)pReturnVal = pThread;
 	}
@@ -658,7 +673,7 @@ namespace ffscript {
 
 		_indexCommand->execute();
 		int indexOffset = currentOffset + _indexCommand->getTargetOffset();
-		char* returnAdress = (char*)_arrayData;
+		char* returnAdress = (char*)context->getGlobalAddress(_arrayData);
 		int index;
 		context->read(indexOffset, &index, sizeof(index));
 
@@ -12,8 +12,10 @@
 #include "DefaultPreprocessor.h"
 #include <list>
 #include <algorithm>
+#include "ScriptLexer.h"
 
 using namespace std;
+using namespace ffscript;
 
 DefaultPreprocessor::DefaultPreprocessor()
 {
@@ -48,11 +50,16 @@ shared_ptr<wstring> DefaultPreprocessor::preprocess(const wchar_t* begin, const
 
 	while (c < end)
 	{
+		// only comments and new lines need to be processed
+		c = ScriptLexer::findEither(c, end, '/', '\n');
+		if (c == end) {
+			break;
+		}
 		if (*c == '/' && (c + 1) < end && *(c + 1) == '/') {
 			strRef->append(subStart, c - subStart);
 
 			auto d = c;
-			for (c += 2; c < end && *c != '\n'; c++);
+			c = ScriptLexer::findChar(c + 2, end, '\n');
 
 			totalSkipChar += (int)(c - d);
 
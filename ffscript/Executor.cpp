@@ -25,7 +25,7 @@
 
 namespace ffscript {
 
-	Executor::Executor(){}
+	Executor::Executor() : _sourceCharIndex(-1) {}
 	Executor::~Executor(){}	
 
 	void Executor::runCode() {
@@ -48,4 +48,12 @@ namespace ffscript {
 		_commandList.push_back(commandEntry);
 		_commandContainer.push_back(CommandRef(commandEntry));
 	}
+
+	void Executor::setSourceCharIndex(int charIndex) {
+		_sourceCharIndex = charIndex;
+	}
+
+	int Executor::getSourceCharIndex() const {
+		return _sourceCharIndex;
+	}
 }
\ No newline at end of file
@@ -27,6 +27,7 @@ namespace ffscript {
 		std::list<CommandRef> _commandContainer;
 		std::list<MemoryBlockRef> _memoryBlocks;
 		CommandList _commandList;
+		int _sourceCharIndex;
 	public:
 		Executor();
 		virtual ~Executor();
@@ -34,6 +35,9 @@ namespace ffscript {
 		virtual CommandList* getCode();
 		void addCommand(InstructionCommand*);
 		void runCode();
+		// index of the first char of the code which the commands are compiled from, -1 if it is unknown
+		void setSourceCharIndex(int charIndex);
+		int getSourceCharIndex() const;
 	};
 
 	typedef std::shared_ptr<Executor> ExecutorRef;
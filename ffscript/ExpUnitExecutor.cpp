@@ -25,22 +25,25 @@
 #include "RefFunction.h"
 #include "ScriptFunction.h"
 #include "CodeUpdater.h"
+#include "DebugInfo.h"
 #include "ObjectBlock.hpp"
 #include "InstructionCommand.h"
+#include "MemberVariableAccessors.h"
 
 namespace ffscript {	
 	ExpUnitExecutor::ExpUnitExecutor(ScriptScope* scope) :
 		_currentScope(scope),
 		_returnOffset(0),
 		_localOffset(0),
-		_localSize(0){
+		_localSize(0),
+		_maxLocalSize(0){
 	}
 
 	ExpUnitExecutor::~ExpUnitExecutor() {
 	}
 
 	int ExpUnitExecutor::getCurrentLocalOffset() const {
-		return _localOffset + getLocalSize();
+		return _localOffset + _localSize;
 	}
 
 	int ExpUnitExecutor::getReturnOffset() const {
@@ -49,10 +52,15 @@ namespace ffscript {
 
 	void ExpUnitExecutor::moveLocalOffset(int size) {
 		_localSize += size;
+		if (_localSize > _maxLocalSize) {
+			_maxLocalSize = _localSize;
+		}
 	}
 
 	int ExpUnitExecutor::getLocalSize() const {
-		return _localSize;
+		// the space need to run the expression is the peak of local space,
+		// the current local size may be lower because of reused param spaces
+		return _maxLocalSize;
 	}
 
 	void ExpUnitExecutor::resetLocalOffset() {
@@ -89,6 +97,8 @@ namespace ffscript {
 			updateScriptFunctionFunc->setArgs(program, usedRuntimeInfoObject, functionId);
 
 			updateLaterMan->addUpdateLaterTask(updateScriptFunctionFunc);
+			updateLaterMan->addReferencedFunction(functionId);
+			updateLaterMan->addFunctionTargetTask(functionId, updateScriptFunctionFunc);
 		}
 		else if (usedRuntimeInfoObject->info.type == RuntimeFunctionType::NativeFunction) {
 			auto nativeFunction = (NativeFunction*)scriptCompiler->createFunctionFromId(functionId);
@@ -129,11 +139,27 @@ namespace ffscript {
 				}
 			}
 			else {
-				auto accessors = extractParamForMemberVariableOperand(pMemberVariable);
-				auto pushParamRefFunc = new PushMemberVariableParamRef();
-				pushParamRefFunc->setCommandData(accessors, returnOffset);
+				auto accessPlan = extractParamForMemberVariableOperand(pMemberVariable);
+				if (accessPlan->getDereferenceCount() == 0) {
+					// the member is stored inside its root variable, so it can be accessed as a normal variable
+					if (accessPlan->getGlobalAddress()) {
+						auto pushParamRefFunc = new PushParamRef();
+						pushParamRefFunc->setCommandData((char*)accessPlan->getGlobalAddress() + accessPlan->getBaseOffset(), returnOffset);
+						assitFunction = pushParamRefFunc;
+					}
+					else {
+						auto pushParamRefFunc = new PushParamRefOffset();
+						pushParamRefFunc->setCommandData(accessPlan->getBaseOffset(), returnOffset);
+						assitFunction = pushParamRefFunc;
+					}
+					delete accessPlan;
+				}
+				else {
+					auto pushParamRefFunc = new PushMemberVariableParamRef();
+					pushParamRefFunc->setCommandData(accessPlan, returnOffset);
 
-				assitFunction = pushParamRefFunc;
+					assitFunction = pushParamRefFunc;
+				}
 			}
 		}
 		else if (node->getReturnType().isFunctionType()) {
@@ -311,7 +337,7 @@ namespace ffscript {
 					auto callScriptFunctionFunc = new CallScriptFuntion();
 					callScriptFunctionFunc->setCommandData(resultSize, beginParamOffset, paramSize);
 #endif
-					callScriptFunctionFunc->setFunctionName(node->toString());
+					DebugInfo::recordCommandName(scriptCompiler, callScriptFunctionFunc, node->toString());
 
 					Program* program = scriptCompiler->getProgram();
 					bool found = false;
@@ -368,6 +394,7 @@ namespace ffscript {
 	bool ExpUnitExecutor::extractCode(ScriptCompiler* compiler, const ExecutableUnitRef& rootUnit) {
 		resetLocalOffset();
 		this->getCode()->clear();
+		setSourceCharIndex(rootUnit->getSourceCharIndex());
 		_returnOffset = this->getCurrentLocalOffset();
 		ScriptScope* scope = getScope();
 		int returnDataSize = compiler->getTypeSize(rootUnit->getReturnType());
@@ -376,8 +403,8 @@ namespace ffscript {
 		if (scope) {
 
 			int memToRunCode = scope->getScopeSize() - scope->getDataSize();
-			if (_localSize > memToRunCode) {
-				scope->allocate(_localSize - memToRunCode);
+			if (getLocalSize() > memToRunCode) {
+				scope->allocate(getLocalSize() - memToRunCode);
 			}
 		}
 		return (_returnOffset >= 0);
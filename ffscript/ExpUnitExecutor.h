@@ -28,10 +28,11 @@ namespace ffscript {
 	class Variable;
 	class CommandTree;
 	class FunctionCommand;
-	class MemberVariableAccessor;
+	class MemberVariableAccessPlan;
 	class ScriptFunction;
 	class TargetedCommand;
 	class OptimizedLogicCommand;
+	class CallScriptFuntion2;
 
 	class ExpUnitExecutor :
 		public Executor
@@ -41,11 +42,13 @@ namespace ffscript {
 		ScriptScope* _currentScope;		
 		int _localOffset;
 		int _localSize;
+		int _maxLocalSize;
 		int _returnOffset;
 		std::map<ExecutableUnit*, int> _unitOffsetMap;
 	private:
 		void moveLocalOffset(int size);
 		void resetLocalOffset();
+		bool isLocalSpaceReusable(const ExecutableUnitRef& node) const;
 
 	public:
 		ExpUnitExecutor(ScriptScope* scope);
@@ -70,8 +73,10 @@ namespace ffscript {
 		void extractParamForDynamicFunction(ScriptCompiler* scriptCompiler, FunctionCommand* commander, NativeFunction* expFunctionUnit, int beginParamOffset, int returnOffset);
 		void extractParamScriptFunction(ScriptCompiler* scriptCompiler, FunctionCommand* commander, ScriptFunction* expFunctionUnit, int beginParamOffset, int returnOffset);
 		TargetedCommand* extractParamForForwardFunction(ScriptCompiler* scriptCompiler, Function* expFunctionUnit, int beginParamOffset, int returnOffset);
+		TargetedCommand* extractParamForKnownFunctionTarget(ScriptCompiler* scriptCompiler, Function* expFunctionUnit, RuntimeFunctionType targetType, int targetId, int beginParamOffset, int returnOffset);
+		void setScriptFunctionTarget(ScriptCompiler* scriptCompiler, CallScriptFuntion2* command, int functionId);
 		TargetedCommand* extractParamForCreateLambdaFunction(ScriptCompiler* scriptCompiler, Function* expFunctionUnit, int beginParamOffset, int returnOffset);
-		std::vector<MemberVariableAccessor*>* extractParamForMemberVariableOperand(MemberVariable* pMemberVariable);
+		MemberVariableAccessPlan* extractParamForMemberVariableOperand(MemberVariable* pMemberVariable);
 		TargetedCommand* extractParamConditionalOperator(ScriptCompiler* scriptCompiler, Function* functionUnit, int beginParamOffset, int returnOffset);
 		TargetedCommand* extractParamDefaultCopyOperator(ScriptCompiler* scriptCompiler, Function* functionUnit, int beginParamOffset, int returnOffset);
 		TargetedCommand* extractParamDefaultCopyOperatorRef(ScriptCompiler* scriptCompiler, Function* functionUnit, int beginParamOffset, int returnOffset);
@@ -26,6 +26,8 @@
 #include "RefFunction.h"
 #include "ScriptFunction.h"
 #include "CodeUpdater.h"
+#include "DebugInfo.h"
+#include "FunctionObjectAnalyzer.h"
 #include "ObjectBlock.hpp"
 #include "InstructionCommand.h"
 #include "CommandTree.h"
@@ -38,7 +40,7 @@
 
 namespace ffscript {	
 	
-	std::vector<MemberVariableAccessor*>* ExpUnitExecutor::extractParamForMemberVariableOperand(MemberVariable* pMemberVariable) {
+	MemberVariableAccessPlan* ExpUnitExecutor::extractParamForMemberVariableOperand(MemberVariable* pMemberVariable) {
 		list<Variable*> parents;
 		MemberVariable* pMemberVariableTmp = pMemberVariable;
 		ScriptScope* ownerScope = pMemberVariableTmp->getScope();
@@ -51,31 +53,29 @@ namespace ffscript {
 		}
 		int offset = 0;
 
-		vector<MemberVariableAccessor*>* accessors = new vector<MemberVariableAccessor*>();
+		MemberVariableAccessPlan* accessPlan = new MemberVariableAccessPlan();
 
 		GlobalScope* globalScope = dynamic_cast<GlobalScope*>(ownerScope);
 		if (globalScope) {
 			void* address = globalScope->getGlobalAddress(pVariable->getOffset());
-			accessors->push_back(new MVGlobalAccessor(address));
-		}
-		else {
-			accessors->push_back(new MVContextAccessor());
+			accessPlan->setGlobalAddress(address);
 		}
 
+		// consecutive offsets are folded into one, only references need a dereference step
 		for (auto var : parents) {
 			auto& type = var->getDataType();
 			offset = var->getOffset() - offset;
 
-			accessors->push_back(new MVOffsetAccessor(offset));
+			accessPlan->addOffset(offset);
 
-			if (type.isRefType() || type.isRefType()) {
-				accessors->push_back(new MVPointerAccessor());
+			if (type.isRefType()) {
+				accessPlan->addDereference();
 			}
 		}
 
 		offset = pMemberVariable->getOffset() - offset;
-		accessors->push_back(new MVOffsetAccessor(offset));
-		return accessors;
+		accessPlan->addOffset(offset);
+		return accessPlan;
 	}
 
 	TargetedCommand* ExpUnitExecutor::extractCodeForOperand(ScriptCompiler* scriptCompiler, const ExecutableUnitRef& node, int returnOffset) {
@@ -105,12 +105,28 @@ namespace ffscript {
 				}
 			}
 			else {
-				vector<MemberVariableAccessor*>* accessors = extractParamForMemberVariableOperand(pMemberVariable);
-
-				auto pushParamFunc = new PushMemberVariableParam();
-				pushParamFunc->setCommandData(accessors, dataSize, returnOffset);
+				MemberVariableAccessPlan* accessPlan = extractParamForMemberVariableOperand(pMemberVariable);
+
+				if (accessPlan->getDereferenceCount() == 0) {
+					// the member is stored inside its root variable, so it can be accessed as a normal variable
+					if (accessPlan->getGlobalAddress()) {
+						auto pushParamFunc = new PushParam();
+						pushParamFunc->setCommandData((char*)accessPlan->getGlobalAddress() + accessPlan->getBaseOffset(), dataSize, returnOffset);
+						assitFunction = pushParamFunc;
+					}
+					else {
+						auto pushParamFunc = new PushParamOffset();
+						pushParamFunc->setCommandData(accessPlan->getBaseOffset(), dataSize, returnOffset);
+						assitFunction = pushParamFunc;
+					}
+					delete accessPlan;
+				}
+				else {
+					auto pushParamFunc = new PushMemberVariableParam();
+					pushParamFunc->setCommandData(accessPlan, dataSize, returnOffset);
 
-				assitFunction = pushParamFunc;
+					assitFunction = pushParamFunc;
+				}
 			}
 		}
 		else /*EXP_UNIT_ID_CONST*/ {
@@ -197,7 +213,7 @@ namespace ffscript {
 		else {
 			runNativeFuncFunc->setCommandData(returnOffset, beginParamOffset, nativeFunction);
 		}
-		runNativeFuncFunc->setFunctionName(expFunctionUnit->getName());
+		DebugInfo::recordCommandName(scriptCompiler, runNativeFuncFunc, expFunctionUnit->getName());
 		originCommand = runNativeFuncFunc;
 		functionCommandTree->setCommand(originCommand);		
 	}
@@ -228,39 +244,58 @@ namespace ffscript {
 
 		auto callScriptFunctionFunc = new CallScriptFuntion3();
 		callScriptFunctionFunc->setCommandData(returnOffset, beginParamOffset, paramSize);
-		callScriptFunctionFunc->setFunctionName(scriptFunction->toString());
+		DebugInfo::recordCommandName(scriptCompiler, callScriptFunctionFunc, scriptFunction->toString());
 
+		setScriptFunctionTarget(scriptCompiler, callScriptFunctionFunc, scriptFunction->getId());
+
+		originCommand = callScriptFunctionFunc;
+		functionCommandTree->setCommand(originCommand);
+	}
+
+	void ExpUnitExecutor::setScriptFunctionTarget(ScriptCompiler* scriptCompiler, CallScriptFuntion2* command, int functionId) {
 		Program* program = scriptCompiler->getProgram();
+		auto updateLaterMan = CodeUpdater::getInstance(this->getScope());
+		if (updateLaterMan) {
+			// the called function is reachable from the code being extracted
+			updateLaterMan->addReferencedFunction(functionId);
+			updateLaterMan->addFunctionCall(getScope(), functionId, 0);
+		}
+
 		bool found = false;
 		if (program) {
-			CodeSegmentEntry* pFunctionCode = program->getFunctionPlainCode(scriptFunction->getId());
+			CodeSegmentEntry* pFunctionCode = program->getFunctionPlainCode(functionId);
 			if (pFunctionCode) {
-				callScriptFunctionFunc->setTargetCommand(pFunctionCode->first);
+				command->setTargetCommand(pFunctionCode->first);
 				found = true;
 			}
 		}
 
-		if (!found) {
-			auto updateLaterMan = CodeUpdater::getInstance(this->getScope());
-			if (updateLaterMan) {
+		if (updateLaterMan) {
+			auto updateScriptFunctionFunc = new FT::CachedFunctionDelegate<void, Program*, CallScriptFuntion2*, int>(CodeUpdater::updateScriptFunction);
+			updateScriptFunctionFunc->setArgs(program, command, functionId);
+			DelegateRef updateScriptFunctionRef(updateScriptFunctionFunc);
+			if (!found) {
 				////when this function is called, the command pointer of the script function is not determine yet
 				////so we need to add to update later list of program to complete the arguments.
-
-				auto updateScriptFunctionFunc = new FT::CachedFunctionDelegate<void, Program*, CallScriptFuntion2*, int>(CodeUpdater::updateScriptFunction);
-				updateScriptFunctionFunc->setArgs(program, callScriptFunctionFunc, scriptFunction->getId());
-
-				updateLaterMan->addUpdateLaterTask((DelegateRef)updateScriptFunctionFunc);
-			}
-			else {
-				callScriptFunctionFunc->setTargetCommand(nullptr);
+				updateLaterMan->addUpdateLaterTask(updateScriptFunctionRef);
 			}
+			// the target is updated again if the function is reloaded
+			updateLaterMan->addFunctionTargetTask(functionId, updateScriptFunctionRef);
+		}
+		else if (!found) {
+			command->setTargetCommand(nullptr);
 		}
-
-		originCommand = callScriptFunctionFunc;
-		functionCommandTree->setCommand(originCommand);
 	}
 
 	TargetedCommand* ExpUnitExecutor::extractParamForForwardFunction(ScriptCompiler* scriptCompiler, Function* expFunctionUnit, int beginParamOffset, int returnOffset) {
+#if DEVIRTUALIZE_FUNCTION_OBJECT
+		auto functionObjectAnalyzer = FunctionObjectAnalyzer::getInstance(getScope());
+		RuntimeFunctionType targetType;
+		int targetId;
+		if (functionObjectAnalyzer && functionObjectAnalyzer->findKnownTarget(expFunctionUnit->getChild(0), targetType, targetId)) {
+			return extractParamForKnownFunctionTarget(scriptCompiler, expFunctionUnit, targetType, targetId, beginParamOffset, returnOffset);
+		}
+#endif
 		int n = expFunctionUnit->getChildCount();
 		TargetedCommand* paramCommand;
 		TargetedCommand* originCommand;
@@ -302,6 +337,12 @@ namespace ffscript {
 		auto& functionType = paramUnit->getReturnType();
 		auto functionInfoSize = scriptCompiler->getTypeSizeInStack(functionType.iType());
 
+		// the stack used by the callee cannot be determined at compile time
+		auto updateLaterMan = CodeUpdater::getInstance(getScope());
+		if (updateLaterMan) {
+			updateLaterMan->addFunctionCall(getScope(), DYNAMIC_CALLEE_ID, 0);
+		}
+
 		auto runForwader = new FunctionForwarder();
 		runForwader->setCommandData(beginParamOffset, returnOffset, beginParamOffset + functionInfoSize, paramSize - functionInfoSize,
 			(functionType.isSemiRefType()|| functionType.isRefType()));
@@ -311,6 +352,69 @@ namespace ffscript {
 		return functionCommandTree;
 	}
 
+	TargetedCommand* ExpUnitExecutor::extractParamForKnownFunctionTarget(ScriptCompiler* scriptCompiler, Function* expFunctionUnit, RuntimeFunctionType targetType, int targetId, int beginParamOffset, int returnOffset) {
+		// the first child is the function object, the others are arguments of the function
+		int n = expFunctionUnit->getChildCount() - 1;
+		TargetedCommand* paramCommand;
+		TargetedCommand* originCommand;
+		int currentOffset = beginParamOffset;
+
+		int paramSize = 0;
+		int i;
+		for (i = 1; i <= n; i++) {
+			ExecutableUnitRef& paramUnit = expFunctionUnit->getChild(i);
+			paramSize += scriptCompiler->getTypeSizeInStack(paramUnit->getReturnType().iType());
+		}
+		moveLocalOffset(paramSize);
+
+		FunctionCommand* functionCommandTree;
+		switch (n)
+		{
+		case 0:
+			functionCommandTree = new FunctionCommand0P();
+			break;
+		case 1:
+			functionCommandTree = new FunctionCommand1P();
+			break;
+		case 2:
+			functionCommandTree = new FunctionCommand2P();
+			break;
+		default:
+			functionCommandTree = new FunctionCommandNP(n);
+			break;
+		}
+
+		//follow is offset of params
+		for (i = 1; i <= n; i++) {
+			ExecutableUnitRef& paramUnit = expFunctionUnit->getChild(i);
+			paramCommand = convert2Code2(scriptCompiler, paramUnit, currentOffset);
+			currentOffset += scriptCompiler->getTypeSizeInStack(paramUnit->getReturnType().iType());
+
+			functionCommandTree->pushCommandParam(paramCommand);
+		}
+
+		if (targetType == RuntimeFunctionType::NativeFunction) {
+			auto nativeFunction = (NativeFunction*)scriptCompiler->createFunctionFromId(targetId);
+			auto runNativeFuncFunc = new CallNativeFuntion();
+			runNativeFuncFunc->setCommandData(returnOffset, beginParamOffset, nativeFunction->getNative());
+			DebugInfo::recordCommandName(scriptCompiler, runNativeFuncFunc, expFunctionUnit->getChild(0)->toString());
+			delete nativeFunction;
+
+			originCommand = runNativeFuncFunc;
+		}
+		else {
+			auto callScriptFunctionFunc = new CallScriptFuntion3();
+			callScriptFunctionFunc->setCommandData(returnOffset, beginParamOffset, paramSize);
+			DebugInfo::recordCommandName(scriptCompiler, callScriptFunctionFunc, expFunctionUnit->getChild(0)->toString());
+			setScriptFunctionTarget(scriptCompiler, callScriptFunctionFunc, targetId);
+
+			originCommand = callScriptFunctionFunc;
+		}
+
+		functionCommandTree->setCommand(originCommand);
+		return functionCommandTree;
+	}
+
 	TargetedCommand* ExpUnitExecutor::extractParamForCreateLambdaFunction(ScriptCompiler* scriptCompiler, Function* expFunctionUnit, int beginParamOffset, int returnOffset) {
 		int n = expFunctionUnit->getChildCount() - 1;
 		TargetedCommand* paramCommand;
@@ -361,6 +465,7 @@ namespace ffscript {
 		auto updateCreateLambdaFunctionFunc = std::make_shared<FT::CachedFunctionDelegate<void, Program*, CallCreateLambda*, int>>(CodeUpdater::updateLamdaScriptFunctionObject);
 		updateCreateLambdaFunctionFunc->setArgs(program,callCreateLambda,functionId);
 		updateLaterMan->addUpdateLaterTask(updateCreateLambdaFunctionFunc);
+		updateLaterMan->addReferencedFunction(functionId);
 		//////////////////////////
 
 		originCommand = callCreateLambda;
@@ -486,7 +591,7 @@ namespace ffscript {
 		runNativeFuncFunc->setCommandData(returnOffset, beginParamOffset, nativeFunction);
 		runNativeFuncFunc->initAssitInfo(n, assitParamsInfo);
 		runNativeFuncFunc->setParamsType(scriptTypes, typeNames, sizes);
-		runNativeFuncFunc->setFunctionName(expFunctionUnit->getName());
+		DebugInfo::recordCommandName(scriptCompiler, runNativeFuncFunc, expFunctionUnit->getName());
 		originCommand = runNativeFuncFunc;
 
 		functionCommandTree->setCommand(originCommand);
@@ -775,17 +880,15 @@ namespace ffscript {
 
 		auto typeVoid = scriptCompiler->getTypeManager()->getBasicTypes().TYPE_VOID;
 
-		MemberInfo memberInfo;
-		string memberName;
+		std::vector<MemberInfo> memberInfos;
+		pStruct->getMemberInfos(memberInfos);
 		
 		FunctionCommandNP* functionCommand = new FunctionCommandNP(functionUnit->getChildCount() - 1);
 
-		auto res = pStruct->getMemberFirst(&memberName, &memberInfo);
 		// break assigment for each member of the struct
-		for (int i = 1; res; i ++) {
-			auto paramUnit = functionUnit->getChild(i);
-			auto targetCommand = convert2Code2(scriptCompiler, paramUnit, variableOffset + memberInfo.offset);
-			res = pStruct->getMemberNext(nullptr, &memberInfo);
+		for (int i = 0; i < (int)memberInfos.size(); i++) {
+			auto paramUnit = functionUnit->getChild(i + 1);
+			auto targetCommand = convert2Code2(scriptCompiler, paramUnit, variableOffset + memberInfos[i].offset);
 
 			functionCommand->pushCommandParam(targetCommand);
 		}
@@ -1093,10 +1196,55 @@ namespace ffscript {
 		return assitFunction;
 	}
 
+	bool ExpUnitExecutor::isLocalSpaceReusable(const ExecutableUnitRef& node) const {
+		//constructor, destructor and temporary object units keep their data or
+		//their param offsets until the end of the expression
+		if (node->getUserData()) {
+			return false;
+		}
+		if (_currentScope && _currentScope->findTempVariable(node.get())) {
+			return false;
+		}
+		if (ISFUNCTION(node)) {
+			//a reference returned by a function may point to the param space
+			auto& returnType = node->getReturnType();
+			if (returnType.isRefType() || returnType.isSemiRefType()) {
+				return false;
+			}
+
+			Function* function = (Function*)node.get();
+			int n = function->getChildCount();
+			for (int i = 0; i < n; i++) {
+				if (!isLocalSpaceReusable(function->getChild(i))) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
 #if USE_FUNCTION_TREE
+	// the units made by the compiler have no position in the source, the first position of their children is used
+	static int getFirstSourceCharIndex(const ExecutableUnitRef& unit) {
+		if (!unit) return -1;
+		int charIndex = unit->getSourceCharIndex();
+		if (ISFUNCTION(unit)) {
+			Function* function = (Function*)unit.get();
+			int n = function->getChildCount();
+			for (int i = 0; i < n; i++) {
+				int childCharIndex = getFirstSourceCharIndex(function->getChild(i));
+				if (childCharIndex >= 0 && (charIndex < 0 || childCharIndex < charIndex)) {
+					charIndex = childCharIndex;
+				}
+			}
+		}
+		return charIndex;
+	}
+
 	bool ExpUnitExecutor::extractCode(ScriptCompiler* compiler, const ExecutableUnitRef& rootUnit) {
 		resetLocalOffset();
 		this->getCode()->clear();
+		setSourceCharIndex(getFirstSourceCharIndex(rootUnit));
 		_unitOffsetMap.clear();
 
 		_returnOffset = this->getCurrentLocalOffset();
@@ -1107,8 +1255,8 @@ namespace ffscript {
 		if (scope) {
 
 			int memToRunCode = scope->getScopeSize() - scope->getDataSize();
-			if (_localSize > memToRunCode) {
-				scope->allocate(_localSize - memToRunCode);
+			if (getLocalSize() > memToRunCode) {
+				scope->allocate(getLocalSize() - memToRunCode);
 			}
 		}
 		addCommand(assitFunction);
@@ -1127,6 +1275,7 @@ namespace ffscript {
 
 		if (ISFUNCTION(node)) {
 			int beginParamOffset = getCurrentLocalOffset();
+			int localSizeBeforeFunction = _localSize;
 			assitFunction = extractCodeForFunction(scriptCompiler, node, returnOffset);
 
 			if (node->getUserData()) {
@@ -1201,6 +1350,9 @@ namespace ffscript {
 						constructorUpdater->setArgs(scriptCompiler,getScope(),buildInfo->buildItems);
 
 						codeUpdateLater->addUpdateLaterTask(constructorUpdater);
+						for (auto& buildItem : buildInfo->buildItems) {
+							codeUpdateLater->addReferencedFunction(buildItem.functionId);
+						}
 					}
 
 					assitFunction = triggerCommand;
@@ -1238,11 +1390,21 @@ namespace ffscript {
 						destructorUpdater->setArgs(scriptCompiler, getScope(), buildInfo->buildItems);
 
 						codeUpdateLater->addUpdateLaterTask(destructorUpdater);
+						for (auto& buildItem : buildInfo->buildItems) {
+							codeUpdateLater->addReferencedFunction(buildItem.functionId);
+						}
 					}
 
 					assitFunction = triggerCommand;
 				}
 			}
+#if REUSE_EXPRESSION_LOCAL_SPACE
+			//the function writes its result to return offset, so its param space is free
+			//after it run and the next sibling expressions can use the space again
+			if (isLocalSpaceReusable(node)) {
+				_localSize = localSizeBeforeFunction;
+			}
+#endif
 		}
 		else {
 			assitFunction = extractCodeForOperand(scriptCompiler, node, returnOffset);
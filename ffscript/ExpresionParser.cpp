@@ -30,6 +30,7 @@
 #include "DefaultCommands.h"
 #include "FunctionScope.h"
 #include "ScriptFunction.h"
+#include <mutex>
 
 #define DBG_PRINT_FUNTION()
 #define DBG_INFO(x)
@@ -42,6 +43,8 @@ namespace ffscript {
 
 	using namespace std;
 
+	static std::mutex _constantFactoryLock;
+
 	bool IsDisgit(const wchar_t* sNumber)
 	{
 		const wchar_t* pChar = sNumber;
@@ -324,7 +327,7 @@ namespace ffscript {
 		for (auto it = params.begin(); it != params.end() ; it++) {
 			createLambdaFunction->pushParam(*it);
 		}
-		auto unitIdRef = make_shared<CConstOperand<int>>(lambaFunctionId, "int");
+		auto unitIdRef = makeCompileShared<CConstOperand<int>>(lambaFunctionId, "int");
 		createLambdaFunction->pushParam(unitIdRef);
 
 		// keep origin source char in new expression unit
@@ -829,6 +832,9 @@ namespace ffscript {
 						//try search constant name first
 						auto createConstantFunction = scriptCompiler->findConstantMap(stdtoken);
 						if (createConstantFunction) {
+							// constant factories keep the created object until the next call and
+							// they are shared by compilers which share a system library
+							std::lock_guard<std::mutex> lock(_constantFactoryLock);
 							createConstantFunction->call();
 							pExpUnit = (ExecutableUnit*)createConstantFunction->getReturnValAsVoidPointer();
 						}
@@ -1180,7 +1186,7 @@ namespace ffscript {
 		EExpressionResult eResult = EE_SUCCESS;
 		//find if clause expression
 		//use dummy function to collect the unit for if clause
-		DynamicParamFunctionRef dummyFuncion = std::make_shared<DynamicParamFunction>(":", EXP_UNIT_ID_FUNC_CHOICE, FUNCTION_PRIORITY_CONDITIONAL, 1);
+		DynamicParamFunctionRef dummyFuncion = makeCompileShared<DynamicParamFunction>(":", EXP_UNIT_ID_FUNC_CHOICE, FUNCTION_PRIORITY_CONDITIONAL, 1);
 		// keep origin source char in new expression unit
 		dummyFuncion->setSourceCharIndex(it->get()->getSourceCharIndex());
 
@@ -1467,7 +1473,7 @@ namespace ffscript {
 					previousUnit->getType() == EXP_UNIT_ID_OPERATOR_SUBSCRIPT)) {
 				//collect param inside brackets () for user functions like sin(a), sum(...)
 				//Ex: 1 + 2 * sum(3,4,5)
-				auto functionOperator = make_shared<DynamicParamFunction>(FUNCTION_OPERATOR, EXP_UNIT_ID_OPERATOR_FUNCTIONCALL, FUNCTION_PRIORITY_FUNCTIONCALL, 2);
+				auto functionOperator = makeCompileShared<DynamicParamFunction>(FUNCTION_OPERATOR, EXP_UNIT_ID_OPERATOR_FUNCTIONCALL, FUNCTION_PRIORITY_FUNCTIONCALL, 2);
 				// keep origin source char in new expression unit
 				functionOperator->setSourceCharIndex(iter->get()->getSourceCharIndex());
 
@@ -1561,7 +1567,7 @@ namespace ffscript {
 
 			//replace unit '[' by subscript operator
 			pOperatorStack->pop();
-			auto subscriptOperator = make_shared<DynamicParamFunction>(SUBSCRIPT_OPERATOR, EXP_UNIT_ID_OPERATOR_SUBSCRIPT, FUNCTION_PRIORITY_SUBSCRIPT, 2);
+			auto subscriptOperator = makeCompileShared<DynamicParamFunction>(SUBSCRIPT_OPERATOR, EXP_UNIT_ID_OPERATOR_SUBSCRIPT, FUNCTION_PRIORITY_SUBSCRIPT, 2);
 
 			// set true source char index of operator '[]' is source char index of open bracket
 			subscriptOperator->setSourceCharIndex(paramCollectionUnit->getSourceCharIndex());
@@ -1719,7 +1725,7 @@ namespace ffscript {
 		listPaths<ExecutableUnitRef, CandidateCollection, ExecutableUnitRef>(candidatesForParams, paramPaths);
 
 		auto& basicTypes = scriptCompiler->getTypeManager()->getBasicTypes();
-		CandidateCollectionRef defaultOperators = std::make_shared<CandidateCollection>();
+		CandidateCollectionRef defaultOperators = makeCompileShared<CandidateCollection>();
 
 		//CandidateCollectionRef defaultMemberAssigmentOperators1;
 		//CandidateCollectionRef defaultMemberAssigmentOperators2;
@@ -1815,7 +1821,7 @@ namespace ffscript {
 					
 						RuntimeFunctionInfo nullValueOfRuntimeFunctionInfo;
 						defaultRuntimeFunctionInfoConstructor(&nullValueOfRuntimeFunctionInfo);
-						auto nullValueRef = make_shared<CConstOperand<RuntimeFunctionInfo>>(nullValueOfRuntimeFunctionInfo, param1Type);
+						auto nullValueRef = makeCompileShared<CConstOperand<RuntimeFunctionInfo>>(nullValueOfRuntimeFunctionInfo, param1Type);
 						// keep origin source char in new expression unit
 						nullValueRef->setSourceCharIndex(param2->getSourceCharIndex());
 
@@ -2244,7 +2250,7 @@ namespace ffscript {
 					items.push_back(&*it);
 				}
 			}
-			unitCandidate = std::make_shared<CandidateCollection>();
+			unitCandidate = makeCompileShared<CandidateCollection>();
 			for (auto it = items.begin(); it != items.end(); it++) {
 				auto item = *it;
 				int type = scriptCompiler->buildFunctionType(*item);
@@ -2272,7 +2278,7 @@ namespace ffscript {
 					return nullptr;
 				}
 			}
-			unitCandidate = std::make_shared<CandidateCollection>();
+			unitCandidate = makeCompileShared<CandidateCollection>();
 			unitCandidate->push_back(unit);
 		}
 		else {
@@ -2400,7 +2406,7 @@ namespace ffscript {
 							}
 						}
 						if (processAndMethodCalling) {
-							auto methodUnitRef = make_shared<IncompletedUserFunctionUnit>(memberName);
+							auto methodUnitRef = makeCompileShared<IncompletedUserFunctionUnit>(memberName);
 							methodUnitRef->setSourceCharIndex(functionUnit->getSourceCharIndex());
 							// replace the member access unit by the new function
 							pExeUnit1 = methodUnitRef;
@@ -2420,7 +2426,7 @@ namespace ffscript {
 				}
 				if (pExeUnit1->getReturnType().isFunctionType()) {
 					candidatesForParams.resize(1 + params.size());
-					auto forwardCallUnitRef = make_shared<DynamicParamFunction>(FUNCTION_OPERATOR, EXP_UNIT_ID_FORWARD_CALL, FUNCTION_PRIORITY_FUNCTIONCALL, 1 + (int)params.size());
+					auto forwardCallUnitRef = makeCompileShared<DynamicParamFunction>(FUNCTION_OPERATOR, EXP_UNIT_ID_FORWARD_CALL, FUNCTION_PRIORITY_FUNCTIONCALL, 1 + (int)params.size());
 					// keep origin source char in new expression unit
 					forwardCallUnitRef->setSourceCharIndex(function->getSourceCharIndex());
 
@@ -2441,7 +2447,7 @@ namespace ffscript {
 					// first check the candidate is a function type...
 					if (param1CandidatesTmp->size() == 1 && param1CandidatesTmp->front()->getReturnType().isFunctionType()) {
 						candidatesForParams.resize(1 + params.size());
-						auto forwardCallUnitRef = make_shared<DynamicParamFunction>(FUNCTION_OPERATOR, EXP_UNIT_ID_FORWARD_CALL, FUNCTION_PRIORITY_FUNCTIONCALL, 1 + (int)params.size());
+						auto forwardCallUnitRef = makeCompileShared<DynamicParamFunction>(FUNCTION_OPERATOR, EXP_UNIT_ID_FORWARD_CALL, FUNCTION_PRIORITY_FUNCTIONCALL, 1 + (int)params.size());
 						// keep origin source char in new expression unit
 						forwardCallUnitRef->setSourceCharIndex(function->getSourceCharIndex());
 
@@ -2455,7 +2461,7 @@ namespace ffscript {
 					else {
 						// ... or not, then check function operator for type
 						int functionOperator = -1;
-						functionCandidates = make_shared<CandidateCollection>();
+						functionCandidates = makeCompileShared<CandidateCollection>();
 						for (auto it = param1CandidatesTmp->begin(); it != param1CandidatesTmp->end(); it++) {
 							auto& param1Type = (*it)->getReturnType();
 							if (param1Type.refLevel() == 0) {
@@ -2537,7 +2543,7 @@ namespace ffscript {
 				return nullptr;
 			}
 
-			functionCandidates = make_shared<CandidateCollection>();
+			functionCandidates = makeCompileShared<CandidateCollection>();
 			
 			auto it = param1Candidates->begin();
 			auto& param1Type = (*it)->getReturnType();
@@ -2549,7 +2555,7 @@ namespace ffscript {
 			functionCandidates->push_back(function);
 			for (it++; it != param1Candidates->end(); it++) {
 				auto& param1TypeN = (*it)->getReturnType();
-				auto newCandidate = make_shared<FixParamFunction<1>>(MAKING_SEMI_REF_FUNC, EXP_UNIT_ID_SEMI_REF, FUNCTION_PRIORITY_UNARY_PREFIX, param1TypeN.makeSemiRef());
+				auto newCandidate = makeCompileShared<FixParamFunction<1>>(MAKING_SEMI_REF_FUNC, EXP_UNIT_ID_SEMI_REF, FUNCTION_PRIORITY_UNARY_PREFIX, param1TypeN.makeSemiRef());
 
 				// keep origin source char in new expression unit
 				newCandidate->setSourceCharIndex(it->get()->getSourceCharIndex());
@@ -2580,7 +2586,7 @@ namespace ffscript {
 				return nullptr;
 			}
 
-			functionCandidates = make_shared<CandidateCollection>();
+			functionCandidates = makeCompileShared<CandidateCollection>();
 
 			ScriptType typeLong(basicType.TYPE_LONG, scriptCompiler->getType(basicType.TYPE_LONG));
 			ScriptType typeInt(basicType.TYPE_INT, scriptCompiler->getType(basicType.TYPE_INT));
@@ -2600,7 +2606,7 @@ namespace ffscript {
 						if (basicType.TYPE_INT == param1TypeNOriginType.iType() || basicType.TYPE_LONG == param1TypeNOriginType.iType()) {
 							auto param1TypeNOriginSize = scriptCompiler->getTypeSize(param1TypeNOriginType.iType());
 
-							auto derRefUnit = make_shared<FixParamFunction<1>>(DEREF_OPERATOR, EXP_UNIT_ID_DEREF, FUNCTION_PRIORITY_UNARY_PREFIX, param1TypeNOriginType);
+							auto derRefUnit = makeCompileShared<FixParamFunction<1>>(DEREF_OPERATOR, EXP_UNIT_ID_DEREF, FUNCTION_PRIORITY_UNARY_PREFIX, param1TypeNOriginType);
 							derRefUnit->pushParam(unit);
 							derRefUnit->setNative(make_shared<DeRefCommand>(param1TypeNOriginSize));
 
@@ -2675,7 +2681,7 @@ namespace ffscript {
 					auto param1TypeNOriginType = param1TypeN.deSemiRef();
 
 					auto param1TypeNOriginSize = scriptCompiler->getTypeSize(param1TypeNOriginType.iType());
-					auto derRefUnit = make_shared<FixParamFunction<1>>(DEREF_OPERATOR, EXP_UNIT_ID_DEREF, FUNCTION_PRIORITY_UNARY_PREFIX, param1TypeNOriginType);
+					auto derRefUnit = makeCompileShared<FixParamFunction<1>>(DEREF_OPERATOR, EXP_UNIT_ID_DEREF, FUNCTION_PRIORITY_UNARY_PREFIX, param1TypeNOriginType);
 					derRefUnit->pushParam(unit);
 					derRefUnit->setNative(make_shared<DeRefCommand>(param1TypeNOriginSize));
 
@@ -2708,7 +2714,7 @@ namespace ffscript {
 					}
 				}
 				if (!newCandidate) {
-					newCandidate = make_shared<FixParamFunction<1>>(function->getName(), function->getType(), function->getPriority(), returnType);
+					newCandidate = makeCompileShared<FixParamFunction<1>>(function->getName(), function->getType(), function->getPriority(), returnType);
 					// keep origin source char in new expression unit
 					newCandidate->setSourceCharIndex(function->getSourceCharIndex());
 				}
@@ -2746,7 +2752,7 @@ namespace ffscript {
 			if (param1Candidates && param1Candidates->size() && eResult == EE_SUCCESS) {
 				auto param2Candidates = linkForUnit(scriptCompiler, pExeUnit2, eResult);
 				if (param2Candidates && param2Candidates->size() && eResult == EE_SUCCESS) {
-					functionCandidates = make_shared<CandidateCollection>();
+					functionCandidates = makeCompileShared<CandidateCollection>();
 					
 					candidatesForParams[0] = param1Candidates;
 					candidatesForParams[1] = param2Candidates;
@@ -2787,7 +2793,7 @@ namespace ffscript {
 							acurative2 = 0;
 						}
 						acurative = acurative1 + acurative2;
-						auto functionCandidate = make_shared<FixParamFunction<2>>(function->getName(), function->getType(), function->getPriority(), typeBool);
+						auto functionCandidate = makeCompileShared<FixParamFunction<2>>(function->getName(), function->getType(), function->getPriority(), typeBool);
 						functionCandidate->pushParam(param1);
 						functionCandidate->pushParam(param2);
 						functionCandidate->setMask(function->getMask());
@@ -2836,7 +2842,7 @@ namespace ffscript {
 
 					MaskType mask = (pExeUnit1->getMask() | UMASK_DECLAREINEXPRESSION);
 
-					param1Candidates = std::make_shared<CandidateCollection>();
+					param1Candidates = makeCompileShared<CandidateCollection>();
 					pExeUnit1->setReturnType(param2Candidates->front()->getReturnType());
 					variable->setDataType(pExeUnit1->getReturnType());
 					pExeUnit1->setMask(mask);
@@ -2925,7 +2931,7 @@ namespace ffscript {
 				listPaths<ExecutableUnitRef, CandidateCollection, ExecutableUnitRef>(candidatesForParams, paramPaths);
 
 				string error;
-				functionCandidates = std::make_shared<CandidateCollection>();
+				functionCandidates = makeCompileShared<CandidateCollection>();
 				for (auto pit = paramPaths.begin(); pit != paramPaths.end(); pit++) {
 					auto conditionUnit = pit->at(0);
 					auto ifUnit = pit->at(1);
@@ -2984,7 +2990,7 @@ namespace ffscript {
 #pragma region linking for ref operator
 			if (n == 1 && function->getType() == EXP_UNIT_ID_MAKE_REF) {
 				choosedFunctionId = scriptCompiler->getMakingRefFunction();
-				functionCandidates = std::make_shared<CandidateCollection>();
+				functionCandidates = makeCompileShared<CandidateCollection>();
 				auto& paramCandidates = candidatesForParams.front();
 				for(auto pit = paramCandidates->begin(); pit != paramCandidates->end(); pit++) {
 					auto& makeRefParamUnit = (*pit);
@@ -3038,7 +3044,7 @@ namespace ffscript {
 			listPaths<ExecutableUnitRef, CandidateCollection, ExecutableUnitRef>(candidatesForParams, paramPaths);
 
 			string error;
-			functionCandidates = std::make_shared<CandidateCollection>();
+			functionCandidates = makeCompileShared<CandidateCollection>();
 			bool needToCallConstructor = false;
 
 			if (paramPaths.size()) {
@@ -3206,7 +3212,7 @@ namespace ffscript {
 				std::list<std::vector<ExecutableUnitRef>> paramPaths;
 				listPaths<ExecutableUnitRef, CandidateCollection, ExecutableUnitRef>(candidatesForParams, paramPaths);
 				list<std::pair<ExecutableUnit*, int>> paramPathCandidate;
-				functionCandidates = make_shared<CandidateCollection>();
+				functionCandidates = makeCompileShared<CandidateCollection>();
 				param1Candidates = candidatesForParams[0];
 				for (auto it = param1Candidates->begin(); it != param1Candidates->end(); it++) {
 					auto& functionPointerUnit = *it;
@@ -3380,7 +3386,7 @@ namespace ffscript {
 						dynamicFunction->pushParam(*pit);
 					}
 				}
-				functionCandidates = std::make_shared<CandidateCollection>();
+				functionCandidates = makeCompileShared<CandidateCollection>();
 				functionCandidates->push_back(ExecutableUnitRef(dynamicFunction));
 				eResult = EE_SUCCESS;
 #pragma endregion
@@ -3437,7 +3443,7 @@ namespace ffscript {
 
 			functionCandidates = scriptCompiler->filterCandidate(function->getName(), function->getType(), &candidatesInfo, candidatesForParams, eResult);
 			if (functionCandidates.get() == nullptr && dynamicFunctionCandidates.size()) {
-				functionCandidates = std::make_shared<CandidateCollection>();
+				functionCandidates = makeCompileShared<CandidateCollection>();
 			}
 #pragma region linking for dynamic function
 			if (dynamicFunctionCandidates.size()) {
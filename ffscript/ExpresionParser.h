@@ -19,6 +19,7 @@
 #include <string>
 #include "Expression.h"
 #include "ScriptType.h"
+#include "CompileArena.h"
 
 namespace ffscript {
 
@@ -30,7 +31,7 @@ namespace ffscript {
 	typedef stack<DynamicParamFunctionRef> OperatorStack;
 	typedef std::pair<OutputStack*, OperatorStack*> ExpressionEntry;
 	typedef list<ExpressionEntry> ExpressionInputList;
-	typedef list<ExecutableUnitRef> CandidateCollection;
+	typedef list<ExecutableUnitRef, CompileAllocator<ExecutableUnitRef>> CandidateCollection;
 	typedef std::shared_ptr<CandidateCollection> CandidateCollectionRef;
 
 	struct OverLoadingItem {
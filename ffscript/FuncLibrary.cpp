@@ -17,12 +17,32 @@
 using namespace std;
 namespace ffscript {
 
-	extern bool parseArgumentTypes(ScriptCompiler* scriptCompiler, const std::string& sargs, vector<ScriptType>& args);
-	
 	FuncLibrary::FuncLibrary()
 	{
 	}
 
+	FuncLibrary::FuncLibrary(const FuncLibrary& other) :
+		_memoryBlocks(other._memoryBlocks),
+		_functionsMap(other._functionsMap),
+		_dynamicFunctionMap(other._dynamicFunctionMap),
+		_overLoadingContainer(other._overLoadingContainer)
+	{
+		for (auto& functionGroup : _functionsMap) {
+			for (auto& item : functionGroup.second) {
+				// parameter types are never changed after they are mapped, so they are shared
+				item.itemName = &functionGroup.first;
+				_overloadingIdMap[item.functionId] = &item;
+			}
+		}
+		for (auto& item : _overLoadingContainer) {
+			auto it = _dynamicFunctionMap.find(*item.itemName);
+			if (it != _dynamicFunctionMap.end()) {
+				item.itemName = &it->first;
+			}
+			_overloadingIdMap[item.functionId] = &item;
+		}
+	}
+
 	FuncLibrary::~FuncLibrary()
 	{
 	}
@@ -67,11 +87,11 @@ namespace ffscript {
 		if (overloadingItems == nullptr) {
 			return -1;
 		}
-		std::vector<ScriptType> args;
-		if (!parseArgumentTypes(scriptCompiler, sargs, args)) {
+		auto args = scriptCompiler->getArgumentTypes(sargs);
+		if (args == nullptr) {
 			return -1;
 		}
-		auto fit = findOverloadingItem(*overloadingItems, args);
+		auto fit = findOverloadingItem(*overloadingItems, *args);
 		if (fit != overloadingItems->end()) {
 			return fit->functionId;
 		}
@@ -88,6 +108,9 @@ namespace ffscript {
 		list<OverLoadingItem> overloadingTemp;
 		list<OverLoadingItem>* pOverloadingFuncs;
 		auto it = _functionsMap.insert(std::make_pair(name, overloadingTemp));
+		if (it.second && _systemLibMarkEnd) {
+			_systemLibMarkEnd->functionGroups.push_back(name);
+		}
 
 		pOverloadingFuncs = &(it.first->second);
 
@@ -111,6 +134,9 @@ namespace ffscript {
 			*ait = std::make_shared<ScriptType>(*pit);
 		}
 		_overloadingIdMap[functionId] = &factoryItem;
+		if (_systemLibMarkEnd) {
+			_systemLibMarkEnd->functions.push_back(std::make_pair(name, functionId));
+		}
 
 		return true;
 	}
@@ -121,6 +147,9 @@ namespace ffscript {
 			//a function has same name is already exist
 			return false;
 		}
+		if (_systemLibMarkEnd) {
+			_systemLibMarkEnd->dynamicFunctions.push_back(name);
+		}
 		OverLoadingItem factoryItem;
 		factoryItem.functionId = functionId;
 		//factoryItem.paramCount = -1; //-1 is the mark of dynamic functions
@@ -146,6 +175,9 @@ namespace ffscript {
 		auto rmIt = std::remove_if(pOverloadingFuncs->begin(), pOverloadingFuncs->end(), [functionIdTemp, &allocatedMem](const OverLoadingItem& item) ->bool {
 			return item.functionId == functionIdTemp;
 		});
+		if (rmIt != pOverloadingFuncs->end()) {
+			_overloadingIdMap.erase(functionId);
+		}
 		pOverloadingFuncs->erase(rmIt, pOverloadingFuncs->end());
 	}
 
@@ -168,14 +200,34 @@ namespace ffscript {
 
 	void FuncLibrary::beginUserLib() {
 		_systemLibMarkEnd = (LibraryMarkInfoRef)(new LibraryMarkInfo);
-		_systemLibMarkEnd->dynamicFuncIter = _dynamicFunctionMap.end();
-		_systemLibMarkEnd->funcFactoryIter = _functionsMap.end();
 	}
 
 	void FuncLibrary::clearUserLib() {
 		if (_systemLibMarkEnd) {
-			_dynamicFunctionMap.erase(_systemLibMarkEnd->dynamicFuncIter, _dynamicFunctionMap.end());
-			_functionsMap.erase(_systemLibMarkEnd->funcFactoryIter, _functionsMap.end());
+			for (auto& name : _systemLibMarkEnd->dynamicFunctions) {
+				auto it = _dynamicFunctionMap.find(name);
+				if (it != _dynamicFunctionMap.end()) {
+					int functionId = it->second;
+					_overloadingIdMap.erase(functionId);
+					_overLoadingContainer.remove_if([functionId](const OverLoadingItem& item) {
+						return item.functionId == functionId;
+					});
+					_dynamicFunctionMap.erase(it);
+				}
+			}
+			// user overloads of the names in the system library are removed from their groups
+			for (auto& function : _systemLibMarkEnd->functions) {
+				unmapFunction(function.first, function.second);
+			}
+			for (auto& name : _systemLibMarkEnd->functionGroups) {
+				auto it = _functionsMap.find(name);
+				if (it != _functionsMap.end()) {
+					for (auto& item : it->second) {
+						_overloadingIdMap.erase(item.functionId);
+					}
+					_functionsMap.erase(it);
+				}
+			}
 			_systemLibMarkEnd.reset();
 		}
 	}
@@ -18,6 +18,7 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <unordered_map>
 #include <string>
 
 namespace ffscript {
@@ -26,19 +27,24 @@ namespace ffscript {
 	class FuncLibrary
 	{
 		std::list<MemoryBlockRef> _memoryBlocks;
-		std::map<std::string, std::list<OverLoadingItem>> _functionsMap; /*map function name to list of overloading functions*/
-		std::map<std::string, int> _dynamicFunctionMap; /* map for dynamic funtions, are functions can accept what ever parameter count, map function name to function factory id*/
+		std::unordered_map<std::string, std::list<OverLoadingItem>> _functionsMap; /*map function name to list of overloading functions*/
+		std::unordered_map<std::string, int> _dynamicFunctionMap; /* map for dynamic funtions, are functions can accept what ever parameter count, map function name to function factory id*/
 		std::list<OverLoadingItem> _overLoadingContainer;
 		std::map<int, OverLoadingItem*> _overloadingIdMap;
 		struct LibraryMarkInfo {
-			decltype(_dynamicFunctionMap.begin()) dynamicFuncIter;
-			decltype(_functionsMap.begin()) funcFactoryIter;
+			// names are added to the hash maps in any order, so the names added after the mark are stored here
+			std::list<std::string> dynamicFunctions;
+			std::list<std::string> functionGroups;
+			// functions mapped after the mark, they may overload the functions of the system library
+			std::list<std::pair<std::string, int>> functions;
 		};
 		typedef std::shared_ptr<LibraryMarkInfo> LibraryMarkInfoRef;
 		LibraryMarkInfoRef _systemLibMarkEnd;
 
 	public:
 		FuncLibrary();
+		// copy the function maps, the copied items refer to names stored in the new library
+		FuncLibrary(const FuncLibrary& other);
 		~FuncLibrary();
 		const std::list<OverLoadingItem>* findOverloadingFuncRoot(const std::string& name) const;
 		int findFunction(ScriptCompiler* scriptCompiler, const std::string& name, const std::string& sargs);
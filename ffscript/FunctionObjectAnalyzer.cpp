@@ -0,0 +1,221 @@
+/******************************************************************
+* File:        FunctionObjectAnalyzer.cpp
+* Description: implement FunctionObjectAnalyzer class. A class used to
+*              find function object variables which always refer to
+*              one known function, so calling them can be done
+*              directly without forwarding through function info.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "FunctionObjectAnalyzer.h"
+#include "ScriptScope.h"
+#include "GlobalScope.h"
+#include "Variable.h"
+#include "RefFunction.h"
+
+namespace ffscript {
+
+	FunctionObjectAnalyzer::FunctionObjectAnalyzer(ScriptScope* ownerScope) : _ownerScope(ownerScope) {
+	}
+
+	FunctionObjectAnalyzer::~FunctionObjectAnalyzer() {
+	}
+
+	bool FunctionObjectAnalyzer::getVariableKey(const ExecutableUnitRef& unit, VariableKey& key) const {
+		if (unit->getType() != EXP_UNIT_ID_XOPERAND) {
+			return false;
+		}
+		Variable* pVariable = ((CXOperand*)unit.get())->getVariable();
+		if (pVariable == nullptr || pVariable->getScope() == nullptr || pVariable->getName().empty()) {
+			return false;
+		}
+		// member variables are accessed through their parent object
+		if (dynamic_cast<MemberVariable*>(pVariable)) {
+			return false;
+		}
+		auto& type = pVariable->getDataType();
+		if (!type.isFunctionType() || type.isRefType() || type.isSemiRefType()) {
+			return false;
+		}
+
+		// variable copies share name and owner scope of the origin variable
+		key.first = pVariable->getScope();
+		key.second = pVariable->getName();
+		return true;
+	}
+
+	bool FunctionObjectAnalyzer::getKnownTarget(ExecutableUnitRef unit, RuntimeFunctionType& type, int& functionId) const {
+		RefFunction* refFunction = dynamic_cast<RefFunction*>(unit.get());
+		if (refFunction) {
+			unit = refFunction->getValueOfVariable();
+		}
+
+		auto& returnType = unit->getReturnType();
+		if (unit->getType() == EXP_UNIT_ID_CONST && returnType.isFunctionType() && !returnType.isRefType()) {
+			RuntimeFunctionInfo* runtimeInfo = (RuntimeFunctionInfo*)unit->Execute();
+			if (runtimeInfo->info.type != RuntimeFunctionType::NativeFunction && runtimeInfo->info.type != RuntimeFunctionType::ScriptFunction) {
+				return false;
+			}
+			type = runtimeInfo->info.type;
+			functionId = (int)(size_t)runtimeInfo->address;
+			return true;
+		}
+
+		// a lambda without capture list has only one child, it is the function id
+		if (unit->getType() == EXP_UNIT_ID_CREATE_LAMBDA && ((Function*)unit.get())->getChildCount() == 1) {
+			type = RuntimeFunctionType::ScriptFunction;
+			functionId = *((int*)((Function*)unit.get())->getChild(0)->Execute());
+			return true;
+		}
+
+		return false;
+	}
+
+	FunctionObjectAnalyzer::VariableUsage& FunctionObjectAnalyzer::getUsage(const VariableKey& key) {
+		auto it = _variableUsages.find(key);
+		if (it == _variableUsages.end()) {
+			VariableUsage usage;
+			usage.declared = false;
+			usage.escaped = false;
+			usage.targetType = RuntimeFunctionType::Null;
+			usage.targetId = -1;
+			it = _variableUsages.insert(std::make_pair(key, usage)).first;
+		}
+		return it->second;
+	}
+
+	void FunctionObjectAnalyzer::setWrite(const VariableKey& key, const ExecutableUnitRef& sourceUnit) {
+		VariableUsage& usage = getUsage(key);
+		RuntimeFunctionType type;
+		int functionId;
+		if (getKnownTarget(sourceUnit, type, functionId) == false) {
+			usage.escaped = true;
+		}
+		else if (usage.targetType == RuntimeFunctionType::Null) {
+			usage.targetType = type;
+			usage.targetId = functionId;
+		}
+		else if (usage.targetType != type || usage.targetId != functionId) {
+			// the variable is assigned to more than one function
+			usage.escaped = true;
+		}
+	}
+
+	void FunctionObjectAnalyzer::analyzeUnit(const ExecutableUnitRef& unit) {
+		VariableKey key;
+		if (getVariableKey(unit, key)) {
+			// the variable is used in an unknown way
+			getUsage(key).escaped = true;
+			return;
+		}
+
+		Function* function = dynamic_cast<Function*>(unit.get());
+		if (function == nullptr) {
+			return;
+		}
+
+		int n = function->getChildCount();
+		const ExecutableUnitRef* objectUnit = nullptr;
+		if (n > 0) {
+			auto& firstChild = function->getChild(0);
+			RefFunction* refFunction = dynamic_cast<RefFunction*>(firstChild.get());
+			objectUnit = refFunction ? &refFunction->getValueOfVariable() : &firstChild;
+		}
+
+		if (objectUnit && getVariableKey(*objectUnit, key)) {
+			auto& name = function->getName();
+			if (unit->getType() == EXP_UNIT_ID_FORWARD_CALL && objectUnit == &function->getChild(0)) {
+				// calling the function object does not change it
+			}
+			else if (name == SYSTEM_FUNCTION_CONSTRUCTOR && n == 1) {
+				getUsage(key).declared = true;
+			}
+			else if (name == SYSTEM_FUNCTION_DESTRUCTOR && n == 1) {
+			}
+			else if (name == SYSTEM_FUNCTION_COPY_CONSTRUCTOR && n == 2) {
+				getUsage(key).declared = true;
+				setWrite(key, function->getChild(1));
+			}
+			else if (unit->getType() == EXP_UNIT_ID_DEFAULT_COPY_CONTRUCTOR && n == 2) {
+				if ((*objectUnit)->getMask() & UMASK_DECLAREINEXPRESSION) {
+					getUsage(key).declared = true;
+				}
+				setWrite(key, function->getChild(1));
+			}
+			else {
+				getUsage(key).escaped = true;
+			}
+
+			for (int i = 1; i < n; i++) {
+				analyzeUnit(function->getChild(i));
+			}
+			return;
+		}
+
+		for (int i = 0; i < n; i++) {
+			analyzeUnit(function->getChild(i));
+		}
+	}
+
+	void FunctionObjectAnalyzer::analyzeScope(ScriptScope* scope) {
+		int unitCount = scope->getCommandUnitCount();
+		for (auto it = scope->getFirstCommandUnitRefIter(); unitCount > 0; ++it, --unitCount) {
+			auto extUnit = dynamic_pointer_cast<ExecutableUnit>(*it);
+			if (extUnit) {
+				analyzeUnit(extUnit);
+			}
+		}
+
+		auto destructorUnits = scope->getDestructorList();
+		for (auto it = destructorUnits->begin(); it != destructorUnits->end(); it++) {
+			auto extUnit = dynamic_pointer_cast<ExecutableUnit>(*it);
+			if (extUnit) {
+				analyzeUnit(extUnit);
+			}
+		}
+
+		const ScopeRefList& children = scope->getChildren();
+		for (auto it = children.begin(); it != children.end(); ++it) {
+			analyzeScope(it->get());
+		}
+	}
+
+	void FunctionObjectAnalyzer::analyze() {
+		_variableUsages.clear();
+		analyzeScope(_ownerScope);
+	}
+
+	void FunctionObjectAnalyzer::clear() {
+		_variableUsages.clear();
+	}
+
+	bool FunctionObjectAnalyzer::findKnownTarget(const ExecutableUnitRef& functionObjectUnit, RuntimeFunctionType& type, int& functionId) const {
+		VariableKey key;
+		if (getVariableKey(functionObjectUnit, key) == false) {
+			return false;
+		}
+
+		auto it = _variableUsages.find(key);
+		if (it == _variableUsages.end()) {
+			return false;
+		}
+
+		auto& usage = it->second;
+		if (!usage.declared || usage.escaped || usage.targetType == RuntimeFunctionType::Null) {
+			return false;
+		}
+		type = usage.targetType;
+		functionId = usage.targetId;
+		return true;
+	}
+
+	FunctionObjectAnalyzer* FunctionObjectAnalyzer::getInstance(const ScriptScope* scope) {
+		if (scope == nullptr) return nullptr;
+		return ((GlobalScope*)scope->getRoot())->getFunctionObjectAnalyzer();
+	}
+}
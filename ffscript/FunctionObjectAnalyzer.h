@@ -0,0 +1,58 @@
+/******************************************************************
+* File:        FunctionObjectAnalyzer.h
+* Description: declare FunctionObjectAnalyzer class. A class used to
+*              find function object variables which always refer to
+*              one known function, so calling them can be done
+*              directly without forwarding through function info.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include <map>
+#include <string>
+#include "ffscript.h"
+#include "expressionunit.h"
+
+namespace ffscript {
+
+	class ScriptScope;
+
+	class FunctionObjectAnalyzer
+	{
+		struct VariableUsage {
+			// the variable is declared in script code, not a parameter or a captured variable
+			bool declared;
+			// the variable is used in an expression that may change its value
+			bool escaped;
+			RuntimeFunctionType targetType;
+			int targetId;
+		};
+		typedef std::pair<const ScriptScope*, std::string> VariableKey;
+
+		std::map<VariableKey, VariableUsage> _variableUsages;
+		ScriptScope* _ownerScope;
+	private:
+		bool getVariableKey(const ExecutableUnitRef& unit, VariableKey& key) const;
+		bool getKnownTarget(ExecutableUnitRef unit, RuntimeFunctionType& type, int& functionId) const;
+		VariableUsage& getUsage(const VariableKey& key);
+		void setWrite(const VariableKey& key, const ExecutableUnitRef& sourceUnit);
+		void analyzeUnit(const ExecutableUnitRef& unit);
+		void analyzeScope(ScriptScope* scope);
+	public:
+		FunctionObjectAnalyzer(ScriptScope* ownerScope);
+		virtual ~FunctionObjectAnalyzer();
+
+		// analyze all expressions of the owner scope and its children
+		void analyze();
+		void clear();
+		// check if the unit is a function object variable which is always assigned to a function
+		bool findKnownTarget(const ExecutableUnitRef& functionObjectUnit, RuntimeFunctionType& type, int& functionId) const;
+
+		static FunctionObjectAnalyzer* getInstance(const ScriptScope* scope);
+	};
+}
@@ -203,6 +203,44 @@ namespace ffscript {
 		);
 	}
 
+	// function object that invokes a native function which receives dynamic params
+	// as a list of variants. The variants are passed directly from the param array
+	// built by the caller, no copy is needed.
+	template <class Rt>
+	class VariadicFunctionDelegate : public DFunction2 {
+	public:
+		typedef Rt(*Fx)(const SimpleVariant* params, int paramCount);
+	private:
+		Fx _fx;
+	public:
+		VariadicFunctionDelegate(Fx fx) : _fx(fx) {}
+
+		static void thunk(void* target, void* pReturnVal, char* params);
+
+		void call(void* pReturnVal, void* params[]) {
+			thunk((void*)_fx, pReturnVal, (char*)params);
+		}
+		DFunction2* clone() {
+			return new VariadicFunctionDelegate<Rt>(_fx);
+		}
+		DFunctionThunk getThunk(void*& target) {
+			target = (void*)_fx;
+			return thunk;
+		}
+	};
+
+	template <class Rt>
+	void VariadicFunctionDelegate<Rt>::thunk(void* target, void* pReturnVal, char* params) {
+		SimpleVariantArray* paramArray = *((SimpleVariantArray**)params);
+		*((Rt*)pReturnVal) = ((Fx)target)(paramArray->elems, paramArray->size);
+	}
+
+	template <>
+	inline void VariadicFunctionDelegate<void>::thunk(void* target, void* /*pReturnVal*/, char* params) {
+		SimpleVariantArray* paramArray = *((SimpleVariantArray**)params);
+		((Fx)target)(paramArray->elems, paramArray->size);
+	}
+
 	template<class Rt>
 	int registerDynamicFunction(FunctionRegisterHelper& fb, Rt(*nativeFunction)(SimpleVariantArray*), const std::string& scriptFunction, const std::string& returnType) {
 		auto functionObj = createFunctionDelegate(nativeFunction);
@@ -210,6 +248,13 @@ namespace ffscript {
 		return fb.registDynamicFunction(scriptFunction, functionUnitFactory);
 	}
 
+	template<class Rt>
+	int registerDynamicFunction(FunctionRegisterHelper& fb, Rt(*nativeFunction)(const SimpleVariant*, int), const std::string& scriptFunction, const std::string& returnType) {
+		auto functionObj = new VariadicFunctionDelegate<Rt>(nativeFunction);
+		auto functionUnitFactory = new DynamicFunctionFactory(returnType, functionObj, fb.getSriptCompiler());
+		return fb.registDynamicFunction(scriptFunction, functionUnitFactory);
+	}
+
 	template<class Class, class Rt>
 	int registerDynamicFunction(FunctionRegisterHelper& fb, Class* obj, Rt(Class::*nativeFunction)(SimpleVariantArray*), const std::string& scriptFunction, const std::string& returnType) {
 		auto functionObj = createMethodDelegate(obj, nativeFunction);
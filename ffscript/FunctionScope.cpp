@@ -22,7 +22,8 @@ namespace ffscript {
 	FunctionScope::FunctionScope(ScriptScope* parent, const std::string& name, const ScriptType& returnType) :
 		ContextScope(parent, this),
 		_name(name),
-		_returnType(returnType) {
+		_returnType(returnType),
+		_functionId(-1) {
 	}
 
 	FunctionScope::~FunctionScope() {
@@ -158,10 +159,14 @@ namespace ffscript {
 		return c;
 	}
 
-	const wchar_t* FunctionScope::parseBody(const wchar_t* text, const wchar_t* end, const ScriptType& returnType, const std::vector<ScriptType>& paramTypes) {
+	bool FunctionScope::registFunction(const ScriptType& returnType, const std::vector<ScriptType>& paramTypes) {
 		_functionId = ((GlobalScope*)getParent())->registScriptFunction(_name, returnType, paramTypes);
+		return _functionId >= 0;
+	}
 
-		if (_functionId < 0) {
+	const wchar_t* FunctionScope::parseBody(const wchar_t* text, const wchar_t* end, const ScriptType& returnType, const std::vector<ScriptType>& paramTypes) {
+		// the function is already registered if its body is parsed lazily
+		if (_functionId < 0 && registFunction(returnType, paramTypes) == false) {
 			return nullptr;
 		}
 
@@ -194,6 +199,10 @@ namespace ffscript {
 		return _functionId;
 	}
 
+	void FunctionScope::setFunctionId(int functionId) {
+		_functionId = functionId;
+	}
+
 	const std::string& FunctionScope::getName() const {
 		return _name;
 	}
@@ -37,6 +37,10 @@ namespace ffscript {
 		const wchar_t* parseFunctionParameters(const wchar_t* text, const wchar_t* end, std::vector<ScriptType>& paramTypes);
 		virtual const wchar_t* parse(const wchar_t* text, const wchar_t* end);
 		virtual const wchar_t* parseHeader(const wchar_t* text, const wchar_t* end, std::vector<ScriptType>& paramTypes);
+		// register the function by its header, parseBody registers it if it is not registered yet
+		bool registFunction(const ScriptType& returnType, const std::vector<ScriptType>& paramTypes);
+		// parse the body for a function which is already registered
+		void setFunctionId(int functionId);
 		const wchar_t* parseBody(const wchar_t* text, const wchar_t* end, const ScriptType& returnType, const std::vector<ScriptType>& paramTypes);
 		virtual bool extractCode(Program* program);
 	protected:
@@ -0,0 +1,155 @@
+/******************************************************************
+* File:        GlobalDataView.cpp
+* Description: implement GlobalDataImage and GlobalDataView classes.
+*              A global data image is a read-only snapshot of the
+*              global memory of a program. A global data view is a
+*              private copy-on-write copy of an image, it lets tasks
+*              run the same program in parallel without sharing their
+*              global variables.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "GlobalDataView.h"
+#include "GlobalScope.h"
+#include "StaticContext.h"
+#include "Variable.h"
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+
+#if _WIN32 || _WIN64
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ffscript {
+
+	GlobalDataImage::GlobalDataImage(GlobalScope* globalScope) :
+		_imageBegin((unsigned char*)globalScope->getGlobalContext()->getAbsoluteAddress(0)),
+		_imageSize(globalScope->getGlobalContext()->getMemCapacity()),
+#if _WIN32 || _WIN64
+		_mappingHandle(nullptr),
+#else
+		_fd(-1),
+#endif
+		_data(nullptr)
+	{
+		if (_imageSize == 0) {
+			throw std::runtime_error("global memory of the program is empty");
+		}
+		auto variable = globalScope->findNonCopyableVariable();
+		if (variable) {
+			throw std::runtime_error("global variable '" + variable->getName() + "' cannot be copied to a global data view");
+		}
+#if _WIN32 || _WIN64
+		_mappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)_imageSize, nullptr);
+		if (_mappingHandle) {
+			_data = (unsigned char*)MapViewOfFile(_mappingHandle, FILE_MAP_WRITE, 0, 0, _imageSize);
+			if (_data == nullptr) {
+				CloseHandle(_mappingHandle);
+				_mappingHandle = nullptr;
+			}
+		}
+#elif defined(__linux__)
+		_fd = memfd_create("ffscript_global_data", 0);
+		if (_fd >= 0) {
+			if (ftruncate(_fd, _imageSize) == 0) {
+				void* data = mmap(nullptr, _imageSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+				_data = data == MAP_FAILED ? nullptr : (unsigned char*)data;
+			}
+			if (_data == nullptr) {
+				close(_fd);
+				_fd = -1;
+			}
+		}
+#endif
+		// the views copy the whole image if the memory cannot be shared
+		if (_data == nullptr) {
+			_data = (unsigned char*)malloc(_imageSize);
+		}
+		memcpy(_data, _imageBegin, _imageSize);
+	}
+
+	GlobalDataImage::~GlobalDataImage() {
+#if _WIN32 || _WIN64
+		if (_mappingHandle) {
+			UnmapViewOfFile(_data);
+			CloseHandle(_mappingHandle);
+			return;
+		}
+#else
+		if (_fd >= 0) {
+			munmap(_data, _imageSize);
+			close(_fd);
+			return;
+		}
+#endif
+		free(_data);
+	}
+
+	unsigned char* GlobalDataImage::getImageBegin() const {
+		return _imageBegin;
+	}
+
+	size_t GlobalDataImage::getImageSize() const {
+		return _imageSize;
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	GlobalDataView::GlobalDataView(const GlobalDataImageRef& image) : _image(image), _data(nullptr), _mapped(false) {
+		size_t size = image->_imageSize;
+#if _WIN32 || _WIN64
+		if (image->_mappingHandle) {
+			_data = (unsigned char*)MapViewOfFile(image->_mappingHandle, FILE_MAP_COPY, 0, 0, size);
+		}
+#else
+		if (image->_fd >= 0) {
+			void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, image->_fd, 0);
+			_data = data == MAP_FAILED ? nullptr : (unsigned char*)data;
+		}
+#endif
+		if (_data) {
+			_mapped = true;
+		}
+		else {
+			_data = (unsigned char*)malloc(size);
+			memcpy(_data, image->_data, size);
+		}
+	}
+
+	GlobalDataView::~GlobalDataView() {
+		if (_mapped) {
+#if _WIN32 || _WIN64
+			UnmapViewOfFile(_data);
+#else
+			munmap(_data, _image->_imageSize);
+#endif
+		}
+		else {
+			free(_data);
+		}
+	}
+
+	const GlobalDataImageRef& GlobalDataView::getImage() const {
+		return _image;
+	}
+
+	unsigned char* GlobalDataView::getData() const {
+		return _data;
+	}
+
+	void* GlobalDataView::getAddress(void* imageAddress) const {
+		size_t offset = (unsigned char*)imageAddress - _image->_imageBegin;
+		if (offset < _image->_imageSize) {
+			return _data + offset;
+		}
+		return imageAddress;
+	}
+}
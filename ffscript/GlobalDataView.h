@@ -0,0 +1,69 @@
+/******************************************************************
+* File:        GlobalDataView.h
+* Description: declare GlobalDataImage and GlobalDataView classes.
+*              A global data image is a read-only snapshot of the
+*              global memory of a program. A global data view is a
+*              private copy-on-write copy of an image, it lets tasks
+*              run the same program in parallel without sharing their
+*              global variables.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+#include <memory>
+
+namespace ffscript {
+
+	class GlobalScope;
+
+	class FFSCRIPT_API GlobalDataImage
+	{
+		unsigned char* _imageBegin;
+		size_t _imageSize;
+		// the snapshot data, it is a shared memory object if copy-on-write views are supported
+#if _WIN32 || _WIN64
+		void* _mappingHandle;
+#else
+		int _fd;
+#endif
+		unsigned char* _data;
+	public:
+		// take a snapshot of the global memory of the scope, the global code must be run before.
+		// The views copy the image byte by byte, so it throws an exception if a global variable
+		// owns heap memory, such as a string or a lambda with captured data, or refers to other data
+		GlobalDataImage(GlobalScope* globalScope);
+		virtual ~GlobalDataImage();
+
+		// the address range of the global memory, it is the range of addresses used by the compiled code
+		unsigned char* getImageBegin() const;
+		size_t getImageSize() const;
+
+		friend class GlobalDataView;
+	};
+
+	typedef std::shared_ptr<GlobalDataImage> GlobalDataImageRef;
+
+	class FFSCRIPT_API GlobalDataView
+	{
+		GlobalDataImageRef _image;
+		unsigned char* _data;
+		bool _mapped;
+	public:
+		// the pages of the view are shared with the image until they are written
+		GlobalDataView(const GlobalDataImageRef& image);
+		virtual ~GlobalDataView();
+
+		const GlobalDataImageRef& getImage() const;
+		unsigned char* getData() const;
+		// address of the global data in this view, the address of the image is returned if it is not a global address
+		void* getAddress(void* imageAddress) const;
+	};
+
+	typedef std::shared_ptr<GlobalDataView> GlobalDataViewRef;
+}
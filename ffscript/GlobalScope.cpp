@@ -16,22 +16,26 @@
 #include "Program.h"
 #include "ScriptFunction.h"
 #include "CodeUpdater.h"
+#include "FunctionObjectAnalyzer.h"
 #include "ScriptRunner.h"
 #include "CLamdaProg.h"
+#include "StructClass.h"
 
 namespace ffscript {
 	GlobalScope::GlobalScope(StaticContext* staticContext, ScriptCompiler* scriptCompiler):
-		ScriptScope(scriptCompiler), _errorCompiledChar(nullptr), _beginCompileChar(nullptr)
+		ScriptScope(scriptCompiler), _errorCompiledChar(nullptr), _beginCompileChar(nullptr), _extractionThreadCount(1), _skippedFunctionBodyCount(0), _lazyFunctionBody(false), _plainCodeOptimization(true)
 	{
 		_updateLaterMan = new CodeUpdater(this);
+		_functionObjectAnalyzer = new FunctionObjectAnalyzer(this);
 		_refContext = false;
 		_staticContextRef.reset(staticContext);
 	}
 
-	GlobalScope::GlobalScope(int globalMemSize, ScriptCompiler* scriptCompiler) : ScriptScope(scriptCompiler), _errorCompiledChar(nullptr), _beginCompileChar(nullptr) {
+	GlobalScope::GlobalScope(int globalMemSize, ScriptCompiler* scriptCompiler) : ScriptScope(scriptCompiler), _errorCompiledChar(nullptr), _beginCompileChar(nullptr), _extractionThreadCount(1), _skippedFunctionBodyCount(0), _lazyFunctionBody(false), _plainCodeOptimization(true) {
 		_staticContextRef.reset(new StaticContext(globalMemSize));
 		_refContext = true;
 		_updateLaterMan = new CodeUpdater(this);
+		_functionObjectAnalyzer = new FunctionObjectAnalyzer(this);
 	}
 	
 	GlobalScope::~GlobalScope(){
@@ -43,12 +47,64 @@ namespace ffscript {
 			_staticContextRef.release();
 		}
 		delete _updateLaterMan;
+		delete _functionObjectAnalyzer;
 	}
 
 	void* GlobalScope::getGlobalAddress(int offset) {
 		return _staticContextRef->getAbsoluteAddress(_staticContextRef->getCurrentOffset() + offset);
 	}
 
+	StaticContext* GlobalScope::getGlobalContext() const {
+		return _staticContextRef.get();
+	}
+
+	// the data of a type can be copied byte by byte if it does not refer to other data and it is
+	// not constructed nor destructed by a function, a function object is checked by its value
+	static bool isBitwiseCopyable(ScriptCompiler* scriptCompiler, const ScriptType& type, const void* data) {
+		if (type.isRefType() || type.isSemiRefType()) {
+			return false;
+		}
+		if (type.isFunctionType()) {
+			// only the function objects without captured data can be copied
+			return ((const RuntimeFunctionInfo*)data)->anoynymousInfo.dataSize == 0;
+		}
+		int iType = type.iType();
+		if (scriptCompiler->hasConstructor(iType) || scriptCompiler->getDestructor(iType) >= 0) {
+			return false;
+		}
+		auto structClass = scriptCompiler->getStruct(iType);
+		if (structClass) {
+			std::vector<MemberInfo> memberInfos;
+			structClass->getMemberInfos(memberInfos);
+			for (auto& memberInfo : memberInfos) {
+				if (!isBitwiseCopyable(scriptCompiler, memberInfo.type, (const char*)data + memberInfo.offset)) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	const Variable* GlobalScope::findNonCopyableVariable() {
+		ScriptCompiler* scriptCompiler = getCompiler();
+		auto& variables = getVariables();
+		for (auto it = variables.begin(); it != variables.end(); it++) {
+			// the temporary variables of the global code are not used after it is run
+			if (it->getName().empty()) {
+				continue;
+			}
+			if (!isBitwiseCopyable(scriptCompiler, it->getDataType(), getGlobalAddress(it->getOffset()))) {
+				return &*it;
+			}
+		}
+		return nullptr;
+	}
+
+	void GlobalScope::releaseCompileUnits() {
+		releaseCommandBuilders();
+		_updateLaterMan->clearExtractionTasks();
+	}
+
 	void GlobalScope::runGlobalCode() {
 		int constructorCount = this->getConstructorCommandCount();
 		int dataSize = getDataSize();
@@ -63,6 +119,21 @@ namespace ffscript {
 		//_staticContextRef->popContext();
 	}
 
+	bool GlobalScope::evaluateGlobalData(const std::list<CommandPointer>& commands, const std::vector<std::pair<int, int>>& blocks) {
+		int constructorCount = this->getConstructorCommandCount();
+		int dataSize = getDataSize();
+		int codeSize = getScopeSize() - dataSize;
+
+		_staticContextRef->pushContext(constructorCount);
+		_staticContextRef->scopeAllocate(dataSize, codeSize);
+
+		bool res = _staticContextRef->evaluateInitialData(commands, blocks);
+
+		_staticContextRef->scopeUnallocate(dataSize, codeSize);
+		_staticContextRef->popContext();
+		return res;
+	}
+
 	void GlobalScope::cleanupGlobalMemory() {
 		int dataSize = getDataSize();
 		int codeSize = getScopeSize() - dataSize;
@@ -17,26 +17,40 @@
 #include "StaticContext.h"
 #include <list>
 #include <vector>
+#include <set>
 
 namespace ffscript {
 
 	class Executor;
 	class CodeUpdater;
+	class FunctionObjectAnalyzer;
 	class CLamdaProg;
+	class FunctionScope;
 
 	class GlobalScope : public ScriptScope
 	{
 		unique_ptr<StaticContext> _staticContextRef;
 		std::list<int> _registeredFuntions;
+		std::set<std::string> _entryFunctions;
 		CodeUpdater* _updateLaterMan;
+		FunctionObjectAnalyzer* _functionObjectAnalyzer;
 		bool _refContext;
 		const WCHAR* _errorCompiledChar;
 		const WCHAR* _beginCompileChar;
+		int _extractionThreadCount;
+		int _skippedFunctionBodyCount;
+		bool _lazyFunctionBody;
+		bool _plainCodeOptimization;
+		ScopeRefList _reloadedScopes;
 	public:
 		GlobalScope(StaticContext* staticContext, ScriptCompiler* scriptCompiler);
 		GlobalScope(int globalMemSize, ScriptCompiler* scriptCompiler);
 		virtual ~GlobalScope();
 		void* getGlobalAddress(int offset);
+		StaticContext* getGlobalContext() const;
+		// the first global variable whose data cannot be copied byte by byte to another memory, such as
+		// a variable which owns heap memory or refers to other global data. It is null if there is no such variable
+		const Variable* findNonCopyableVariable();
 		void runGlobalCode();
 		void cleanupGlobalMemory();
 		virtual int correctAndOptimize(Program* program);
@@ -53,7 +67,50 @@ namespace ffscript {
 		virtual bool extractCode(Program* program);		
 		virtual int registScriptFunction(const std::string& name, const ScriptType& returnType, const std::vector<ScriptType>& paramTypes);
 		CodeUpdater* getCodeUpdater() const;
+		FunctionObjectAnalyzer* getFunctionObjectAnalyzer() const;
+
+		// declare a script function the host will look up and run directly.
+		// when at least one entry function is declared, only the entry functions
+		// and the functions reachable from them or from the global code are extracted.
+		void addEntryFunction(const std::string& name);
+		void clearEntryFunctions();
+		const std::set<std::string>& getEntryFunctions() const;
+
+		// number of threads used to extract code of function bodies, the program
+		// is the same as the one extracted by one thread. Default is one thread.
+		void setExtractionThreadCount(int threadCount);
+		int getExtractionThreadCount() const;
+
+		// parse a function body only if the function name is used by the global code, by an entry function
+		// or by other parsed body. It takes effect only when entry functions are declared and it is off by default.
+		// The used names are found by a lexical scan of the code before it is parsed, then the bodies which
+		// are used are parsed in place, so they see the same functions and global variables as they do when
+		// all bodies are parsed. A skipped body is only checked for matching brackets, the other errors
+		// in it are never reported.
+		void setLazyFunctionBody(bool lazy);
+		bool isLazyFunctionBody() const;
+		// number of function bodies which are skipped in last parsing
+		int getSkippedFunctionBodyCount() const;
+
+		// clean up the plain code after the code is extracted. Default is true.
+		void setPlainCodeOptimization(bool optimize);
+		bool isPlainCodeOptimization() const;
+
+		// compile a new definition of a function of the program extracted from this scope.
+		// the function keeps its id and the calls and the function objects built before run the new code.
+		// It fails if a task is running the program, the tasks cannot start while the function is reloaded.
+		// Global variables are not changed.
+		bool reloadFunction(Program* program, const wchar_t* text, const wchar_t* end);
+		// release the expression units and the update tasks which are used only while the code is compiled,
+		// the scopes, the variables and the function targets are kept to compile expressions and reload functions
+		void releaseCompileUnits();
 	protected:
+		// run the constant initializers of global variables and keep the global data they write
+		// as the initial data of the global context
+		bool evaluateGlobalData(const std::list<CommandPointer>& commands, const std::vector<std::pair<int, int>>& blocks);
+		bool extractFunctionsInParallel(Program* program, std::vector<FunctionScope*>& functionScopes);
+		// keep the frame sizes and the calls of the extracted functions in the program for the stack analysis
+		void updateFunctionStackInfo(Program* program, const std::list<ScriptScope*>& scopes);
 		const wchar_t* detectKeyword(const wchar_t* text, const wchar_t* end);
 		const wchar_t* parseStruct(const wchar_t* text, const wchar_t* end);
 	};
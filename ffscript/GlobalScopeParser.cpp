@@ -20,13 +20,22 @@
 #include "Program.h"
 #include "ExpUnitExecutor.h"
 #include "CodeUpdater.h"
+#include "FunctionObjectAnalyzer.h"
 #include "Supportfunctions.h"
 #include "ControllerExecutor.h"
 #include "ContextScope.h"
 #include "StructClass.h"
 #include "ScopedCompilingScope.h"
+#include "ScriptLexer.h"
+#include "ScriptFunction.h"
+#include "CompositeConstrutorUnit.h"
 
 #include <string>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <unordered_set>
 
 namespace ffscript {
 
@@ -34,6 +43,203 @@ namespace ffscript {
 		return _updateLaterMan;
 	}
 
+	FunctionObjectAnalyzer* GlobalScope::getFunctionObjectAnalyzer() const {
+		return _functionObjectAnalyzer;
+	}
+
+	void GlobalScope::addEntryFunction(const std::string& name) {
+		_entryFunctions.insert(name);
+	}
+
+	void GlobalScope::clearEntryFunctions() {
+		_entryFunctions.clear();
+	}
+
+	const std::set<std::string>& GlobalScope::getEntryFunctions() const {
+		return _entryFunctions;
+	}
+
+	void GlobalScope::setExtractionThreadCount(int threadCount) {
+		_extractionThreadCount = threadCount > 1 ? threadCount : 1;
+	}
+
+	int GlobalScope::getExtractionThreadCount() const {
+		return _extractionThreadCount;
+	}
+
+	void GlobalScope::setLazyFunctionBody(bool lazy) {
+		_lazyFunctionBody = lazy;
+	}
+
+	bool GlobalScope::isLazyFunctionBody() const {
+		return _lazyFunctionBody;
+	}
+
+	void GlobalScope::setPlainCodeOptimization(bool optimize) {
+		_plainCodeOptimization = optimize;
+	}
+
+	bool GlobalScope::isPlainCodeOptimization() const {
+		return _plainCodeOptimization;
+	}
+
+	int GlobalScope::getSkippedFunctionBodyCount() const {
+		return _skippedFunctionBodyCount;
+	}
+
+	// return the character after the close bracket of the block begins at text, nullptr if the block is not closed
+	static const wchar_t* findBlockEnd(const wchar_t* text, const wchar_t* end) {
+		const wchar_t* c = trimLeft(text, end);
+		if (c >= end || !ScriptCompiler::isOpenScopeSign(*c)) {
+			return nullptr;
+		}
+		int openBracket = 0;
+		for (; c < end; c++) {
+			if (ScriptCompiler::isOpenScopeSign(*c)) {
+				openBracket++;
+			}
+			else if (ScriptCompiler::isCloseScopeSign(*c)) {
+				if (--openBracket == 0) {
+					return c + 1;
+				}
+			}
+			else if (*c == '\"' || *c == '\'') {
+				// skip string and character literals
+				wchar_t quote = *c;
+				for (c = ScriptLexer::findEither(c + 1, end, quote, '\\'); c < end && *c == '\\'; c = ScriptLexer::findEither(c + 2, end, quote, '\\'));
+				if (c >= end) {
+					return nullptr;
+				}
+			}
+			else if (*c == '/' && c + 1 < end && *(c + 1) == '/') {
+				c = ScriptLexer::findChar(c + 2, end, '\n');
+			}
+		}
+		return nullptr;
+	}
+
+	// return the character after the literal begins at text, end if the literal is not closed
+	static const wchar_t* skipLiteral(const wchar_t* text, const wchar_t* end) {
+		wchar_t quote = *text;
+		const wchar_t* c;
+		for (c = ScriptLexer::findEither(text + 1, end, quote, '\\'); c < end && *c == '\\'; c = ScriptLexer::findEither(c + 2, end, quote, '\\'));
+		return c < end ? c + 1 : end;
+	}
+
+	// find the names used by the global code and the entry functions, then the names used by the bodies
+	// of the functions found so far until there is no more. A function body is a block follows a closed
+	// round bracket in the global code, the function name is the identifier before the open round bracket.
+	// The blocks which are not function bodies, such as structs and lambda functions, are global code.
+	static void collectReachableNames(const wchar_t* text, const wchar_t* end, const std::set<std::string>& entryFunctions, std::unordered_set<std::string>& reachableNames) {
+		static const std::unordered_set<std::string> controlKeywords = { "if", "while", "for", "switch" };
+
+		std::unordered_map<std::string, std::unordered_set<std::string>> bodyNames;
+		std::unordered_set<std::string> globalNames(entryFunctions.begin(), entryFunctions.end());
+		std::unordered_set<std::string>* usedNames = &globalNames;
+		// names before the open round brackets of the global code, empty if it is not an identifier.
+		// A name is not used if the round brackets are followed by a function body, so it is removed
+		// from the used names until the token after the close round bracket is known
+		std::vector<std::pair<std::string, bool>> roundBracketNames;
+		std::string lastIdentifier;
+		bool lastIdentifierInserted = false;
+		std::pair<std::string, bool> functionName;
+		bool afterIdentifier = false;
+		bool afterRoundBracket = false;
+		int depth = 0;
+		bool inBody = false;
+
+		const wchar_t* c = ScriptLexer::skipSpaces(text, end);
+		while (c < end) {
+			bool isIdentifier = false;
+			bool isRoundBracket = false;
+			if (iswalpha(*c) || *c == '_') {
+				auto e = ScriptLexer::skipIdentifier(c, end);
+				lastIdentifier = convertToAscii(c, e - c);
+				lastIdentifierInserted = usedNames->insert(lastIdentifier).second;
+				isIdentifier = true;
+				c = e;
+			}
+			else if (iswdigit(*c)) {
+				c = ScriptLexer::skipIdentifierOrDot(c, end);
+			}
+			else if (*c == '\"' || *c == '\'') {
+				c = skipLiteral(c, end);
+			}
+			else if (*c == '/' && c + 1 < end && *(c + 1) == '/') {
+				// comments do not change the previous token
+				c = ScriptLexer::skipSpaces(ScriptLexer::findChar(c + 2, end, '\n'), end);
+				continue;
+			}
+			else if (*c == '/' && c + 1 < end && *(c + 1) == '*') {
+				for (c = ScriptLexer::findChar(c + 2, end, '*'); c < end && (c + 1 >= end || *(c + 1) != '/'); c = ScriptLexer::findChar(c + 1, end, '*'));
+				c = ScriptLexer::skipSpaces(c < end ? c + 2 : end, end);
+				continue;
+			}
+			else {
+				if (depth == 0 && *c == '(') {
+					if (afterIdentifier) {
+						roundBracketNames.push_back({ lastIdentifier, lastIdentifierInserted });
+						if (lastIdentifierInserted) {
+							globalNames.erase(lastIdentifier);
+						}
+					}
+					else {
+						roundBracketNames.push_back({ std::string(), false });
+					}
+				}
+				else if (depth == 0 && *c == ')' && roundBracketNames.size()) {
+					if (afterRoundBracket && functionName.second) {
+						globalNames.insert(functionName.first);
+					}
+					functionName = roundBracketNames.back();
+					roundBracketNames.pop_back();
+					isRoundBracket = true;
+				}
+				else if (ScriptCompiler::isOpenScopeSign(*c)) {
+					if (depth == 0 && afterRoundBracket && roundBracketNames.empty() && functionName.first.size() &&
+						controlKeywords.find(functionName.first) == controlKeywords.end()) {
+						usedNames = &bodyNames[functionName.first];
+						functionName.second = false;
+						inBody = true;
+					}
+					depth++;
+				}
+				else if (ScriptCompiler::isCloseScopeSign(*c) && depth > 0) {
+					if (--depth == 0 && inBody) {
+						usedNames = &globalNames;
+						inBody = false;
+					}
+				}
+				c++;
+			}
+			// the name before the round brackets is used if they are not followed by a function body
+			if (afterRoundBracket && !isRoundBracket && functionName.second) {
+				globalNames.insert(functionName.first);
+			}
+			afterIdentifier = isIdentifier;
+			afterRoundBracket = isRoundBracket;
+			c = ScriptLexer::skipSpaces(c, end);
+		}
+		if (afterRoundBracket && functionName.second) {
+			globalNames.insert(functionName.first);
+		}
+
+		reachableNames = globalNames;
+		std::vector<std::string> pendingNames(globalNames.begin(), globalNames.end());
+		while (pendingNames.size()) {
+			auto it = bodyNames.find(pendingNames.back());
+			pendingNames.pop_back();
+			if (it == bodyNames.end()) {
+				continue;
+			}
+			for (auto& name : it->second) {
+				if (reachableNames.insert(name).second) {
+					pendingNames.push_back(name);
+				}
+			}
+		}
+	}
+
 	const wchar_t* GlobalScope::parseStruct(const wchar_t* text, const wchar_t* end) {
 		const wchar_t* c;
 		const wchar_t* d;
@@ -177,6 +383,12 @@ namespace ffscript {
 		Program* program = scriptCompiler->getProgram();
 		CodeUpdater* updateLater = getCodeUpdater();
 		updateLater->clear();
+		_skippedFunctionBodyCount = 0;
+		bool lazyFunctionBody = _lazyFunctionBody && _entryFunctions.size();
+		std::unordered_set<std::string> reachableNames;
+		if (lazyFunctionBody) {
+			collectReachableNames(text, end, _entryFunctions, reachableNames);
+		}
 
 		/* int a */
 		/* int sum(int a, int b)*/
@@ -197,6 +409,7 @@ namespace ffscript {
 				continue;
 			}
 
+			const wchar_t* statementBegin = c;
 			ScriptType type;
 			d = this->parseType(c, end, type);
 			if (d != nullptr) {
@@ -290,6 +503,23 @@ namespace ffscript {
 					std::string errorCompileOfFunction;
 					// try to parse the text as a function header ...
 					if ((c = functionScope->parseHeader(d, end, paramTypes))) {
+						// functions named as types may be called implicitly, so their bodies are always parsed
+						if (lazyFunctionBody && IS_UNKNOWN_TYPE(scriptCompiler->getType(token1)) && reachableNames.find(token1) == reachableNames.end()) {
+							auto bodyEnd = findBlockEnd(c, end);
+							if (bodyEnd == nullptr) {
+								scriptCompiler->setErrorText("missing '}'");
+								c = nullptr;
+								break;
+							}
+							if (functionScope->registFunction(functionScope->getReturnType(), paramTypes) == false) {
+								c = nullptr;
+								break;
+							}
+							// the function is never called, it is stripped when the code is extracted
+							_skippedFunctionBodyCount++;
+							c = bodyEnd;
+							continue;
+						}
 						// ...if success, continue to parse body function
 						if ((c = functionScope->parseBody(c, end, functionScope->getReturnType(), paramTypes))) {
 							// parse the body success
@@ -372,6 +602,124 @@ namespace ffscript {
 		return c;
 	}
 
+	// check if a unit is a value of a basic type which can be evaluated at compile time
+	static bool isConstantValue(ScriptCompiler* scriptCompiler, const ExecutableUnitRef& unit) {
+		auto& type = unit->getReturnType();
+		auto& basicTypes = scriptCompiler->getTypeManager()->getBasicTypes();
+		int iType = type.iType();
+		if (iType != basicTypes.TYPE_INT && iType != basicTypes.TYPE_LONG && iType != basicTypes.TYPE_FLOAT &&
+			iType != basicTypes.TYPE_DOUBLE && iType != basicTypes.TYPE_BOOL &&
+			iType != basicTypes.TYPE_CHAR && iType != basicTypes.TYPE_WCHAR) {
+			return false;
+		}
+		auto unitType = unit->getType();
+		if (unitType == EXP_UNIT_ID_CONST) {
+			return true;
+		}
+		// division and modulo are not evaluated because they may raise an error
+		if (unitType != EXP_UNIT_ID_OPERATOR_ADD && unitType != EXP_UNIT_ID_OPERATOR_SUB &&
+			unitType != EXP_UNIT_ID_OPERATOR_MUL && unitType != EXP_UNIT_ID_OPERATOR_NEG &&
+			unitType != EXP_UNIT_ID_OPERATOR_CAST) {
+			return false;
+		}
+		auto function = dynamic_cast<NativeFunction*>(unit.get());
+		if (function == nullptr) {
+			return false;
+		}
+		for (int i = 0; i < function->getChildCount(); i++) {
+			if (!isConstantValue(scriptCompiler, function->getChild(i))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// check if a global command writes constant values only to global variables,
+	// the blocks of global data written by the command are put to the given list
+	static bool isConstantInitializer(ScriptCompiler* scriptCompiler, const ExecutableUnitRef& unit, std::vector<std::pair<int, int>>& blocks) {
+		auto unitType = unit->getType();
+		if (unitType == EXP_UNIT_ID_DEFAULT_COPY_CONTRUCTOR || unitType == EXP_UNIT_ID_OPERATOR_ASSIGNMENT) {
+			auto function = dynamic_cast<NativeFunction*>(unit.get());
+			if (function == nullptr || function->getChildCount() != 2 || !isConstantValue(scriptCompiler, function->getChild(1))) {
+				return false;
+			}
+			auto targetUnit = function->getChild(0).get();
+			if (targetUnit->getType() == EXP_UNIT_ID_MAKE_REF) {
+				targetUnit = ((Function*)targetUnit)->getChild(0).get();
+			}
+			auto variableUnit = dynamic_cast<CXOperand*>(targetUnit);
+			if (variableUnit == nullptr || variableUnit->getReturnType() != function->getChild(1)->getReturnType()) {
+				return false;
+			}
+			auto variable = variableUnit->getVariable();
+			blocks.push_back(std::make_pair(variable->getOffset(), scriptCompiler->getTypeSize(variable->getDataType())));
+			return true;
+		}
+		if (unitType == EXP_UNIT_ID_CONSTRUCTOR_COMPOSITE) {
+			auto compositeConstructorUnit = dynamic_cast<CompositeConstrutorUnit*>(unit.get());
+			if (compositeConstructorUnit == nullptr) {
+				return false;
+			}
+			auto& assigments = compositeConstructorUnit->getAssigments();
+			for (auto it = assigments.begin(); it != assigments.end(); ++it) {
+				auto variable = it->first;
+				if (!isConstantValue(scriptCompiler, it->second) || it->second->getReturnType() != variable->getDataType()) {
+					return false;
+				}
+				blocks.push_back(std::make_pair(variable->getOffset(), scriptCompiler->getTypeSize(variable->getDataType())));
+			}
+			return true;
+		}
+		return false;
+	}
+
+	// collect the blocks of global data used by a global command. It returns false if the command
+	// may use other global data, it is when the command calls a script function, a function
+	// object or a user operator
+	static bool collectDataBlocks(ScriptCompiler* scriptCompiler, const ExecutableUnitRef& unit, std::vector<std::pair<int, int>>& blocks) {
+		auto unitType = unit->getType();
+		auto variableUnit = dynamic_cast<CXOperand*>(unit.get());
+		if (variableUnit) {
+			auto variable = variableUnit->getVariable();
+			blocks.push_back(std::make_pair(variable->getOffset(), scriptCompiler->getTypeSize(variable->getDataType())));
+			return true;
+		}
+		if (!ISFUNCTION(unit)) {
+			return true;
+		}
+		if ((!ISOPERATOR(unit) && unitType != EXP_UNIT_ID_OPERATOR_CAST && unitType != EXP_UNIT_ID_CONSTRUCTOR_COMPOSITE) ||
+			unitType == EXP_UNIT_ID_USER_OPER || unitType == EXP_UNIT_ID_OPERATOR_FUNCTIONCALL || unitType == EXP_UNIT_ID_FORWARD_CALL ||
+			dynamic_cast<ScriptFunction*>(unit.get())) {
+			return false;
+		}
+		auto compositeConstructorUnit = dynamic_cast<CompositeConstrutorUnit*>(unit.get());
+		if (compositeConstructorUnit) {
+			auto& assigments = compositeConstructorUnit->getAssigments();
+			for (auto it = assigments.begin(); it != assigments.end(); ++it) {
+				auto variable = it->first;
+				blocks.push_back(std::make_pair(variable->getOffset(), scriptCompiler->getTypeSize(variable->getDataType())));
+			}
+		}
+		auto function = (Function*)unit.get();
+		for (int i = 0; i < function->getChildCount(); i++) {
+			if (collectDataBlocks(scriptCompiler, function->getChild(i), blocks) == false) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool isOverlapped(const std::vector<std::pair<int, int>>& blocks1, size_t begin1, const std::vector<std::pair<int, int>>& blocks2) {
+		for (size_t i = begin1; i < blocks1.size(); i++) {
+			for (auto& block2 : blocks2) {
+				if (blocks1[i].first < block2.first + block2.second && block2.first < blocks1[i].first + blocks1[i].second) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
 	inline bool extractCodeForUnit(Program* program, GlobalScope* scope, const CommandUnitRef& commandUnit, std::list<Executor*>& excutorContainer) {
 		const ExecutableUnitRef& extUnit = dynamic_pointer_cast<ExecutableUnit>(commandUnit);
 
@@ -393,17 +741,70 @@ namespace ffscript {
 		return true;
 	}
 
+	// the largest offset used by the scope and its sub scopes
+	static int getScopeExtent(const ScriptScope* scope) {
+		int extent = scope->getBaseOffset() + scope->getScopeSize();
+		const ScopeRefList& children = scope->getChildren();
+		for (auto it = children.begin(); it != children.end(); ++it) {
+			int childExtent = getScopeExtent(it->get());
+			if (childExtent > extent) {
+				extent = childExtent;
+			}
+		}
+		return extent;
+	}
+
+	void GlobalScope::updateFunctionStackInfo(Program* program, const std::list<ScriptScope*>& scopes) {
+		for (auto scope : scopes) {
+			auto functionScope = dynamic_cast<FunctionScope*>(scope);
+			if (functionScope == nullptr) continue;
+
+			FunctionStackInfo stackInfo;
+			stackInfo.frameSize = getScopeExtent(functionScope);
+			auto functionCalls = _updateLaterMan->getFunctionCalls(functionScope->getFunctionId());
+			if (functionCalls) {
+				stackInfo.calls = *functionCalls;
+			}
+			program->setFunctionStackInfo(functionScope->getFunctionId(), stackInfo);
+		}
+	}
+
 	bool GlobalScope::extractCode(Program* program) {
 
 		updateVariableOffset();
 
+		// find the function objects which can be called directly
+		_functionObjectAnalyzer->analyze();
+
 		int expressionCount = this->getCommandUnitCount();
 		std::list<Executor*> globalExcutors;
+		// the constant initializers are evaluated at compile time. An initializer is evaluated only if
+		// the data it writes is not used by the commands run before it, so the commands see same data.
+		// It stops at a command which may use any global data.
+		std::set<Executor*> constantExcutors;
+		std::vector<std::pair<int, int>> constantDataBlocks;
+		std::vector<std::pair<int, int>> usedDataBlocks;
+		bool evaluateConstants = true;
 		for (auto it = getFirstCommandUnitRefIter(); expressionCount > 0; ++it, --expressionCount) {
 			const CommandUnitRef& commandUnit = *it;
 			if (extractCodeForUnit(program, this, commandUnit, globalExcutors) == false) {
 				return false;
 			}
+			const ExecutableUnitRef& extUnit = dynamic_pointer_cast<ExecutableUnit>(commandUnit);
+			if (!extUnit) {
+				evaluateConstants = false;
+			}
+			else if (evaluateConstants) {
+				size_t blockCount = constantDataBlocks.size();
+				if (isConstantInitializer(getCompiler(), extUnit, constantDataBlocks) &&
+					isOverlapped(constantDataBlocks, blockCount, usedDataBlocks) == false) {
+					constantExcutors.insert(globalExcutors.back());
+				}
+				else {
+					constantDataBlocks.resize(blockCount);
+					evaluateConstants = collectDataBlocks(getCompiler(), extUnit, usedDataBlocks);
+				}
+			}
 		}
 
 		std::list<Executor*> destructionExcutors;
@@ -416,15 +817,59 @@ namespace ffscript {
 		}
 
 		const ScopeRefList& children = getChildren();
+		std::list<ScriptScope*> extractedScopes;
+		std::list<FunctionScope*> pendingFunctions;
+		std::vector<FunctionScope*> parallelFunctions;
 		for (auto it = children.begin(); it != children.end(); ++it) {
-			if ((*it)->extractCode(program) == false) return false;
+			auto functionScope = dynamic_cast<FunctionScope*>((*it).get());
+			if (functionScope && _entryFunctions.size()) {
+				// extract the function later if it is reachable
+				pendingFunctions.push_back(functionScope);
+				continue;
+			}
+			if (functionScope && _extractionThreadCount > 1) {
+				parallelFunctions.push_back(functionScope);
+			}
+			else {
+				// the functions before this scope must be put to the program first
+				if (extractFunctionsInParallel(program, parallelFunctions) == false) return false;
+				if ((*it)->extractCode(program) == false) return false;
+			}
+			extractedScopes.push_back((*it).get());
+		}
+		if (extractFunctionsInParallel(program, parallelFunctions) == false) return false;
+
+		// extract the entry functions and the functions called by the extracted code
+		// until there is no more reachable function, the others are stripped out of the program
+		bool hasReachableFunction = true;
+		while (hasReachableFunction) {
+			hasReachableFunction = false;
+			for (auto it = pendingFunctions.begin(); it != pendingFunctions.end();) {
+				FunctionScope* functionScope = *it;
+				if (_entryFunctions.find(functionScope->getName()) == _entryFunctions.end() &&
+					_updateLaterMan->isFunctionReferenced(functionScope->getFunctionId()) == false) {
+					++it;
+					continue;
+				}
+				if (functionScope->getCommandUnitCount() == 0) {
+					getCompiler()->setErrorText("body of function '" + functionScope->getName() + "' is not parsed");
+					return false;
+				}
+				if (functionScope->extractCode(program) == false) return false;
+				extractedScopes.push_back(functionScope);
+				it = pendingFunctions.erase(it);
+				hasReachableFunction = true;
+			}
 		}
 
+		// the analyzed result is valid only for the extracted code
+		_functionObjectAnalyzer->clear();
+
 		program->convertToPlainCode();
 
 		ContextScope* contextScope;
-		for (auto it = children.begin(); it != children.end(); ++it) {
-			contextScope = dynamic_cast<ContextScope*>((*it).get());
+		for (auto it = extractedScopes.begin(); it != extractedScopes.end(); ++it) {
+			contextScope = dynamic_cast<ContextScope*>(*it);
 			if (contextScope) {
 				if (contextScope->updateCodeForControllerCommands(program) == false) {
 					return false;
@@ -433,12 +878,32 @@ namespace ffscript {
 		}
 
 		getCodeUpdater()->runUpdate();
+		if (_plainCodeOptimization) {
+			program->optimizePlainCode();
+		}
+		updateFunctionStackInfo(program, extractedScopes);
 
 		CommandPointer beginCommand;
 		CommandPointer endCommand; 
 
 		CodeSegmentEntry* pExcutorCodeEntry;
+		std::list<CommandPointer> constantCommands;
 		for (auto it = globalExcutors.begin(); it != globalExcutors.end(); ++it) {
+			if (constantExcutors.find(*it) == constantExcutors.end()) continue;
+			pExcutorCodeEntry = program->getCode(*it);
+			if (pExcutorCodeEntry) {
+				for (CommandPointer commandPointer = pExcutorCodeEntry->first; commandPointer <= pExcutorCodeEntry->second; ++commandPointer) {
+					constantCommands.push_back(commandPointer);
+				}
+			}
+		}
+		if (constantCommands.size() && evaluateGlobalData(constantCommands, constantDataBlocks) == false) {
+			// run the initializers with the other commands
+			constantExcutors.clear();
+		}
+
+		for (auto it = globalExcutors.begin(); it != globalExcutors.end(); ++it) {
+			if (constantExcutors.find(*it) != constantExcutors.end()) continue;
 			pExcutorCodeEntry = program->getCode(*it);
 			if (pExcutorCodeEntry) {
 				beginCommand = pExcutorCodeEntry->first;
@@ -465,6 +930,63 @@ namespace ffscript {
 		return true;
 	}
 
+	bool GlobalScope::extractFunctionsInParallel(Program* program, std::vector<FunctionScope*>& functionScopes) {
+		int functionCount = (int)functionScopes.size();
+		if (functionCount == 0) {
+			return true;
+		}
+
+		// each function is extracted to its own program and deferred update,
+		// so the threads do not touch the shared ones
+		std::vector<std::unique_ptr<Program>> functionPrograms(functionCount);
+		std::vector<CodeUpdater::DeferredUpdate> deferredUpdates(functionCount);
+		std::vector<char> results(functionCount, 0);
+		std::vector<std::exception_ptr> exceptions(functionCount);
+		std::atomic<int> nextFunction(0);
+
+		auto extractFunctions = [&]() {
+			int i;
+			while ((i = nextFunction++) < functionCount) {
+				functionPrograms[i].reset(new Program());
+				CodeUpdater::setDeferredUpdate(&deferredUpdates[i]);
+				try {
+					results[i] = functionScopes[i]->extractCode(functionPrograms[i].get());
+				}
+				catch (...) {
+					exceptions[i] = std::current_exception();
+				}
+				CodeUpdater::setDeferredUpdate(nullptr);
+			}
+		};
+
+		int threadCount = std::min(_extractionThreadCount, functionCount);
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadCount; i++) {
+			threads.emplace_back(extractFunctions);
+		}
+		extractFunctions();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		// merge the extracted code in the order of the functions,
+		// it is the order of the code extracted by one thread
+		for (int i = 0; i < functionCount; i++) {
+			if (exceptions[i]) {
+				functionScopes.clear();
+				std::rethrow_exception(exceptions[i]);
+			}
+			if (results[i] == 0) {
+				functionScopes.clear();
+				return false;
+			}
+			program->appendExecutors(*functionPrograms[i]);
+			_updateLaterMan->mergeDeferredUpdate(deferredUpdates[i]);
+		}
+		functionScopes.clear();
+		return true;
+	}
+
 	int GlobalScope::correctAndOptimize(Program* program) {
 		const ScopeRefList& children = getChildren();
 		int iRes = 0;
@@ -475,6 +997,151 @@ namespace ffscript {
 		return iRes;
 	}
 
+	bool GlobalScope::reloadFunction(Program* program, const wchar_t* text, const wchar_t* end) {
+		ScriptCompiler* scriptCompiler = getCompiler();
+		// the call targets are patched in place, so no task may run the program meanwhile
+		if (program->beginCodeUpdate() == false) {
+			scriptCompiler->setErrorText("a function cannot be reloaded while a task runs the program");
+			return false;
+		}
+		unique_ptr<Program, std::function<void(Program*)>> codeUpdateScope(program, [](Program* p) {
+			p->endCodeUpdate();
+		});
+		scriptCompiler->bindProgram(program);
+		_beginCompileChar = text;
+
+		// the new function scope and the scopes of its lambda expressions are added after these children
+		const ScopeRefList& children = getChildren();
+		size_t childCount = children.size();
+		std::list<ScriptScope*> newScopes;
+		// the lambda expressions of the new code register their functions while they are parsed
+		size_t registeredFunctionCount = _registeredFuntions.size();
+		auto rollback = [&]() {
+			auto it = children.begin();
+			std::advance(it, childCount);
+			while (it != children.end()) {
+				auto child = (it++)->get();
+				detachChild(child);
+			}
+			while (_registeredFuntions.size() > registeredFunctionCount) {
+				scriptCompiler->unregisterFunction(_registeredFuntions.back());
+				_registeredFuntions.pop_back();
+			}
+			return false;
+		};
+
+		ScriptType returnType;
+		const wchar_t* c = parseType(text, end, returnType);
+		if (c == nullptr || returnType.isUnkownType()) {
+			scriptCompiler->setErrorText("a function definition is expected");
+			setErrorCompilerChar(text);
+			return false;
+		}
+		const wchar_t* d = trimLeft(c, end);
+		c = lastCharInToken(d, end);
+		std::string name = convertToAscii(d, c - d);
+		c = trimLeft(c, end);
+		if (c >= end || *c != '(') {
+			scriptCompiler->setErrorText("a function definition is expected");
+			setErrorCompilerChar(c);
+			return false;
+		}
+
+		FunctionScope* functionScope = new FunctionScope(this, name, returnType);
+		std::vector<ScriptType> paramTypes;
+		if ((c = functionScope->parseHeader(c, end, paramTypes)) == nullptr) {
+			return rollback();
+		}
+
+		int functionId = scriptCompiler->findFunction(name, paramTypes);
+		FunctionScope* oldFunctionScope = nullptr;
+		auto it = children.begin();
+		for (size_t i = 0; i < childCount; ++i, ++it) {
+			auto childFunctionScope = dynamic_cast<FunctionScope*>(it->get());
+			if (childFunctionScope && functionId >= 0 && childFunctionScope->getFunctionId() == functionId) {
+				oldFunctionScope = childFunctionScope;
+				break;
+			}
+		}
+		if (oldFunctionScope == nullptr || program->getFunctionPlainCode(functionId) == nullptr) {
+			scriptCompiler->setErrorText("function '" + name + "' is not a function of the program");
+			return rollback();
+		}
+		if (oldFunctionScope->getReturnType().iType() != returnType.iType()) {
+			scriptCompiler->setErrorText("return type of function '" + name + "' cannot be changed");
+			return rollback();
+		}
+
+		functionScope->setFunctionId(functionId);
+		if (functionScope->parseBody(c, end, returnType, paramTypes) == nullptr) {
+			return rollback();
+		}
+
+		it = children.begin();
+		std::advance(it, childCount);
+		for (; it != children.end(); ++it) {
+			if ((*it)->correctAndOptimize(program) != 0) {
+				return rollback();
+			}
+			newScopes.push_back(it->get());
+		}
+
+		// extract the new code to its own program, the old code is kept in the program
+		// for the calls which are running. The update tasks are collected separately to run only
+		// the tasks of the new code
+		unique_ptr<Program> functionProgram(new Program());
+		CodeUpdater::DeferredUpdate deferredUpdate;
+		CodeUpdater::setDeferredUpdate(&deferredUpdate);
+		unique_ptr<CodeUpdater::DeferredUpdate, std::function<void(CodeUpdater::DeferredUpdate*)>> deferredUpdateScope(&deferredUpdate, [](CodeUpdater::DeferredUpdate*) {
+			CodeUpdater::setDeferredUpdate(nullptr);
+		});
+		for (auto scope : newScopes) {
+			if (scope->extractCode(functionProgram.get()) == false) {
+				return rollback();
+			}
+		}
+		deferredUpdateScope.reset();
+		std::list<DelegateRef> updateLaterList;
+		updateLaterList.swap(deferredUpdate.updateLaterList);
+		// the calls of the old code are replaced by the calls of the new code
+		_updateLaterMan->clearFunctionCalls(functionId);
+		_updateLaterMan->mergeDeferredUpdate(deferredUpdate);
+
+		functionProgram->convertToPlainCode();
+		if (program->getDebugInfo()) {
+			functionProgram->addSourcePositions(program->getDebugInfo());
+		}
+		for (auto scope : newScopes) {
+			auto contextScope = dynamic_cast<ContextScope*>(scope);
+			if (contextScope && contextScope->updateCodeForControllerCommands(functionProgram.get()) == false) {
+				return rollback();
+			}
+		}
+		// the old code is redirected to the new code, so it is replaced only when the new code is complete
+		for (auto scope : newScopes) {
+			auto newFunctionScope = dynamic_cast<FunctionScope*>(scope);
+			if (newFunctionScope) {
+				program->replaceFunctionPlainCode(newFunctionScope->getFunctionId(), *functionProgram->getFunctionPlainCode(newFunctionScope->getFunctionId()));
+			}
+		}
+
+		for (const DelegateRef& task : updateLaterList) {
+			task->call();
+		}
+		if (_plainCodeOptimization) {
+			functionProgram->optimizePlainCode();
+		}
+		updateFunctionStackInfo(program, newScopes);
+
+		// the commands which call the function run the new code from now
+		_updateLaterMan->updateFunctionTargets(functionId);
+		program->attachProgram(functionProgram.release());
+
+		// the old scope is kept because its code is still referred by the function objects built before
+		_reloadedScopes.push_back(detachChild(oldFunctionScope));
+		return true;
+	}
+
 	const WCHAR* GlobalScope::getErrorCompiledChar() const {
 		return _errorCompiledChar;
 	}
@@ -16,6 +16,8 @@
 #include "function/DynamicFunction2.h"
 #include "MemberVariableAccessors.h"
 #include "ScopeRuntimeData.h"
+#include "Instrumentation.h"
+#include "DebugInfo.h"
 
 #include <iomanip>
 #include <sstream>
@@ -162,7 +164,7 @@ namespace ffscript {
 	void PushParamRef::execute() {
 		Context* context = Context::getCurrent();
 		int offset = getTargetOffset() + context->getCurrentOffset();
-		context->lea(offset, _param);
+		context->lea(offset, context->getGlobalAddress(_param));
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -210,7 +212,7 @@ namespace ffscript {
 	void PushParam::execute() {
 		Context* context = Context::getCurrent();
 		int offset = getTargetOffset() + context->getCurrentOffset();
-		context->write(offset, _param, getTargetSize());
+		context->write(offset, context->getGlobalAddress(_param), getTargetSize());
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -230,7 +232,7 @@ namespace ffscript {
 	void LeaOffsetToAddress::execute() {
 		Context* context = Context::getCurrent();
 		int sourceOffset = _sourceOffset + context->getCurrentOffset();
-		*(size_t*)_target = (size_t)context->getAbsoluteAddress(sourceOffset);
+		*(size_t*)context->getGlobalAddress(_target) = (size_t)context->getAbsoluteAddress(sourceOffset);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -248,7 +250,8 @@ namespace ffscript {
 	}
 
 	void LeaAddressToAddress::execute() {
-		*(size_t*)_target = (size_t)_source;
+		Context* context = Context::getCurrent();
+		*(size_t*)context->getGlobalAddress(_target) = (size_t)context->getGlobalAddress(_source);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -293,7 +296,7 @@ namespace ffscript {
 		Context* context = Context::getCurrent();
 		int targetOffset = getTargetOffset() + context->getCurrentOffset();
 
-		context->lea(targetOffset, _source);
+		context->lea(targetOffset, context->getGlobalAddress(_source));
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -378,30 +381,39 @@ namespace ffscript {
 	/////////////////////////////////////////////////////////////////////////////////////
 	CallFuntion::CallFuntion() : _beginParamOffset(0){}
 	CallFuntion::~CallFuntion() {}	
-	void CallFuntion::setFunctionName(const std::string& functionName) {
-		_functionName = functionName;
-	}
-
 	int CallFuntion::getBeginParamOffset() const {
 		return _beginParamOffset;
 	}
 
-	const std::string& CallFuntion::getFunctionName() {
-		return _functionName;
+	std::string CallFuntion::getFunctionName() const {
+		auto debugInfo = DebugInfo::getCurrent();
+		auto functionName = debugInfo ? debugInfo->getCommandName(this) : nullptr;
+		return functionName ? *functionName : "?";
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
-	CallNativeFuntion::CallNativeFuntion() : _targetFunction(nullptr) {}
+	static void callFunctionObject(void* target, void* pReturnVal, char* params) {
+		((DFunction2*)target)->call(pReturnVal, (void**)params);
+	}
+
+	CallNativeFuntion::CallNativeFuntion() : _targetFunction(nullptr), _thunk(nullptr), _thunkTarget(nullptr) {}
 	CallNativeFuntion::~CallNativeFuntion() {}
 	void CallNativeFuntion::setCommandData(int returnOffset, int beginParamOffset, const DFunction2Ref& targetFunction) {
 		setTargetOffset(returnOffset);
 		_beginParamOffset = beginParamOffset;
 		_targetFunction = targetFunction;
+
+		// the function object is still kept to make sure the thunk target is alive
+		_thunk = targetFunction ? targetFunction->getThunk(_thunkTarget) : nullptr;
+		if (_thunk == nullptr) {
+			_thunk = callFunctionObject;
+			_thunkTarget = targetFunction.get();
+		}
 	}
 
 	void CallNativeFuntion::buildCommandText(std::list<std::string>& strCommands) {
 		std::stringstream ss;
-		ss << "invoke (" << _functionName << ", [" << _beginParamOffset << "], [" << getTargetOffset() << "])" ;
+		ss << "invoke (" << getFunctionName() << ", [" << _beginParamOffset << "], [" << getTargetOffset() << "])" ;
 		strCommands.emplace_back(ss.str());
 	}	
 
@@ -417,11 +429,12 @@ namespace ffscript {
 
 		//abosulute addresses will be calculated when the code is run
 		void* returnVal = context->getAbsoluteAddress(returnOffset);
-		void** params = (void**)context->getAbsoluteAddress(beginParamOffset);
+		char* params = (char*)context->getAbsoluteAddress(beginParamOffset);
 
+		INSTRUMENT_CONTEXT(context, onNativeCall(this));
 		//call the registered function with prepared params and give the return buffer (returnVal) to function
 		//the function will write the result at returnVal
-		_targetFunction->call(returnVal, params);
+		_thunk(_thunkTarget, returnVal, params);
 
 		//Logger::WriteMessage(("native function " + std::to_string(*(int*)returnVal)).c_str());
 	}
@@ -460,13 +473,14 @@ namespace ffscript {
 			(RuntimeFunctionInfo*)context->getAbsoluteAddress(functionInfoOffset);
 		
 		if (runtimeInfo->info.type == RuntimeFunctionType::NativeFunction) {
-			CallNativeFuntion callNativeFunction;
-			//ref without delete the instance
-			DFunction2Ref refFunction( (DFunction2*) runtimeInfo->address, [](DFunction2*) {});
-			callNativeFunction.setCommandData(getTargetOffset(), _beginParamOffset, refFunction);
-			callNativeFunction.execute();
+			//call the native function directly, wrapping it in a temporary
+			//CallNativeFuntion command costs a shared pointer allocation per call
+			void* returnVal = context->getAbsoluteAddress(getTargetOffset() + currentOffset);
+			void** params = (void**)context->getAbsoluteAddress(_beginParamOffset + currentOffset);
+			INSTRUMENT_CONTEXT(context, onNativeCall(this));
+			((DFunction2*)runtimeInfo->address)->call(returnVal, params);
 		}
-		else if(runtimeInfo->anoynymousInfo.data == nullptr || runtimeInfo->anoynymousInfo.dataSize == 0) {
+		else if(runtimeInfo->anoynymousInfo.dataSize == 0) {
 			CallScriptFuntion3 callScriptFunction;
 			callScriptFunction.setTargetCommand((CommandPointer)runtimeInfo->address);
 			callScriptFunction.setCommandData(getTargetOffset(), _beginParamOffset, _paramSize);
@@ -519,21 +533,15 @@ namespace ffscript {
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	CallDynamicFuntion::CallDynamicFuntion() : 
-		_scriptTypes(nullptr), _typeNames(nullptr), _sizes(nullptr) {
+		_paramArray(nullptr), _paramArraySize(0) {
 	}
 
 	CallDynamicFuntion::~CallDynamicFuntion() {
-		if (_scriptTypes) {
-			free(_scriptTypes);
-		}
-		if (_typeNames) {
-			for (int i = 0; i < _pairCount; i++) {
-				free(_typeNames[i]);
+		if (_paramArray) {
+			for (int i = 0; i < _paramArray->size; i++) {
+				free(_paramArray->elems[i].typeName);
 			}
-			free(_typeNames);
-		}
-		if (_sizes) {
-			free(_sizes);
+			free(_paramArray);
 		}
 	}
 
@@ -542,53 +550,52 @@ namespace ffscript {
 	}
 
 	void CallDynamicFuntion::setParamsType(int* scriptTypes, char** typeNames, int* sizes) {
-		_scriptTypes = scriptTypes;
-		_typeNames = typeNames;
-		_sizes = sizes;
+		int nParam = _pairCount;
+		_paramArraySize = (int)(offsetof(SimpleVariantArray, elems) + nParam * sizeof(SimpleVariant));
+		_paramArray = (SimpleVariantArray*)malloc(_paramArraySize);
+		_paramArray->size = nParam;
+
+		for (int i = 0; i < nParam; i++) {
+			SimpleVariant& elem = _paramArray->elems[i];
+			elem.scriptType = scriptTypes[i];
+			// the param array takes ownership of type names
+			elem.typeName = typeNames[i];
+			elem.size = sizes[i];
+			elem.pData = nullptr;
+		}
+
+		free(scriptTypes);
+		free(typeNames);
+		free(sizes);
 	}
 
 	void CallDynamicFuntion::execute() {
 		Context* context = Context::getCurrent();
 		int currentOffset = context->getCurrentOffset();
-		int nParam = _pairCount;
 
 		unsigned int totalSizeNeed =
-			sizeof(void*) +																		/*space for address of SimpleVariantArray*/
-			sizeof(SimpleVariantArray::size) + nParam * sizeof(SimpleVariantArray::elems[0]);	/*space SimpleVariantArray*/
+			sizeof(void*) +		/*space for address of SimpleVariantArray*/
+			_paramArraySize;	/*space SimpleVariantArray*/
 		if (!context->prepareWrite(currentOffset, totalSizeNeed)) {
 			return;
 		}
 
 		char* baseAddress = (char*)context->getAbsoluteAddress(currentOffset);
 		
-		//write number of param to first 4 bytes of begin param offset
+		//copy the prebuilt param array to the param offset
 		SimpleVariantArray* simpleArray = (SimpleVariantArray*)(baseAddress + _beginParamOffset + sizeof(void*));
-		simpleArray->size = nParam;
-
-		SimpleVariant* elem = simpleArray->elems;
-		SimpleVariant* elemEnd = elem + nParam;
-		char* paramAddress;
-		int* pInfo = _pairs;
-		int* sTypes = _scriptTypes;
-		char** typeNames = _typeNames;
-		int* sizes = _sizes;
+		memcpy(simpleArray, _paramArray, _paramArraySize);
 
 		//write address of simpleArray to begin param offset
 		*((size_t*)(baseAddress + _beginParamOffset)) = (size_t)simpleArray;
 
+		//only data pointers depend on the current context
+		SimpleVariant* elem = simpleArray->elems;
+		SimpleVariant* elemEnd = elem + _pairCount;
+		int* pInfo = _pairs;
 		while(elem < elemEnd) {
-			//calculate addtional param address - '*pInfo + currentOffset' is additional param offset
-			paramAddress = baseAddress + *pInfo;
-
-			elem->scriptType = *sTypes;
-			elem->typeName = *typeNames;
-			elem->size = *sizes;
-			*((size_t*)(&elem->pData)) = (size_t)paramAddress;
-
+			elem->pData = baseAddress + *pInfo;
 			pInfo++;
-			sTypes++;
-			typeNames++;
-			sizes++;
 			elem++;
 		}
 
@@ -610,7 +617,7 @@ namespace ffscript {
 
 	void CallScriptFuntion::buildCommandText(std::list<std::string>& strCommands) {
 		std::stringstream ss;
-		ss << "invoke (" << _functionName << ", [" << _beginParamOffset << "], " << _paramSize << ", [" << getTargetOffset() << "])";
+		ss << "invoke (" << getFunctionName() << ", [" << _beginParamOffset << "], " << _paramSize << ", [" << getTargetOffset() << "])";
 		strCommands.emplace_back(ss.str());
 	}
 
@@ -624,6 +631,8 @@ namespace ffscript {
 		//void* returnAddress = context->getAbsoluteAddress(returnOffset);
 		void* beginParamAddress = context->getAbsoluteAddress(beginParamOffset);
 
+		INSTRUMENT_CONTEXT(context, onScriptCall(this));
+
 		//initialize scope size of the function, begin is zero
 		//the function scope size will be increased by function allocateMemory
 		//allocateMemory function will be called when a context scope is entered		
@@ -662,7 +671,7 @@ namespace ffscript {
 
 	void CallScriptFuntion2::buildCommandText(std::list<std::string>& strCommands) {
 		std::stringstream ss;
-		ss << "invoke (" << _functionName << ", [" << _beginParamOffset << "], " << _paramSize << ", [" << getTargetOffset() << "])";
+		ss << "invoke (" << getFunctionName() << ", [" << _beginParamOffset << "], " << _paramSize << ", [" << getTargetOffset() << "])";
 		strCommands.emplace_back(ss.str());
 	}
 
@@ -687,6 +696,8 @@ namespace ffscript {
 		void* returnAddress = context->getAbsoluteAddress(returnOffset);
 		void* beginParamAddress = context->getAbsoluteAddress(beginParamOffset);
 
+		INSTRUMENT_CONTEXT(context, onScriptCall(this));
+
 		//initialize scope size of the function, begin is zero
 		//the function scope size will be increased by function allocateMemory
 		//allocateMemory function will be called when a context scope is entered		
@@ -728,7 +739,7 @@ namespace ffscript {
 		Context* context = Context::getCurrent();
 		auto beginParamOffset = ffscript::getBeginParamOffset(context);
 		auto anoynymousDataOffset = beginParamOffset + _paramSize;
-		context->write(anoynymousDataOffset, _anoynymousInfo->data, _anoynymousInfo->dataSize);
+		context->write(anoynymousDataOffset, getAnoynymousData(*_anoynymousInfo), _anoynymousInfo->dataSize);
 
 		context->runFunctionScript();
 	}
@@ -740,6 +751,10 @@ namespace ffscript {
 		_targetCommand = targetCommand;
 	}
 
+	CommandPointer Jump::getTargetCommand() const {
+		return _targetCommand;
+	}
+
 	void Jump::buildCommandText(std::list<std::string>& strCommands) {
 		std::stringstream ss;
 		ss << "jmp(" << int_to_hex((size_t)(_targetCommand + 1)) << ")";
@@ -752,13 +767,46 @@ namespace ffscript {
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
-	JumpIf::JumpIf() : _targetCommandTrue(nullptr) , _conditionOffset(0) {}
+	RedirectFunction::RedirectFunction() : _targetCommand(nullptr) {}
+	RedirectFunction::~RedirectFunction() {}
+	void RedirectFunction::setCommandData(CommandPointer targetCommand) {
+		_targetCommand = targetCommand;
+	}
+
+	CommandPointer RedirectFunction::getTargetCommand() const {
+		return _targetCommand;
+	}
+
+	void RedirectFunction::buildCommandText(std::list<std::string>& strCommands) {
+		std::stringstream ss;
+		ss << "redirect(" << int_to_hex((size_t)_targetCommand) << ")";
+		strCommands.emplace_back(ss.str());
+	}
+
+	void RedirectFunction::execute() {
+		Context* context = Context::getCurrent();
+		// the first command of the target code is run in place of this command, a jump
+		// cannot be used because the first command keeps the command before the jump to return to
+		context->setCurrentCommand(_targetCommand);
+		(*_targetCommand)->execute();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	JumpIf::JumpIf() : _conditionOffset(0), _targetCommandTrue(nullptr) {}
 	JumpIf::~JumpIf() {}
 	void JumpIf::setCommandData(int conditionOffset, CommandPointer targetCommand) {
 		_conditionOffset = conditionOffset;		
 		_targetCommandTrue = targetCommand;
 	}
 
+	CommandPointer JumpIf::getTargetCommand() const {
+		return _targetCommandTrue;
+	}
+
+	void JumpIf::setTargetCommand(CommandPointer targetCommand) {
+		_targetCommandTrue = targetCommand;
+	}
+
 	void JumpIf::buildCommandText(std::list<std::string>& strCommands) {
 		std::stringstream ss;
 		ss << "jmp([" << _conditionOffset << "], " <<  int_to_hex((size_t)(_targetCommandTrue + 1)) << ")";
@@ -783,6 +831,10 @@ namespace ffscript {
 		_targetCommandFalse = targetCommand;
 	}
 
+	CommandPointer JumpIfElse::getCommandElse() const {
+		return _targetCommandFalse;
+	}
+
 	void JumpIfElse::buildCommandText(std::list<std::string>& strCommands) {
 		std::stringstream ss;
 		ss << "jmp([" << _conditionOffset << "], " << int_to_hex((size_t)(_targetCommandTrue + 1)) << ", " << int_to_hex((size_t)(_targetCommandFalse + 1)) << ")";
@@ -867,16 +919,20 @@ namespace ffscript {
 	BreakCommand::BreakCommand() {}
 	BreakCommand::~BreakCommand() {}
 	void BreakCommand::buildCommandText(std::list<std::string>& strCommands) {
-		MultipleCommand::execute();
+		MultipleCommand::buildCommandText(strCommands);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
-	ContinueCommand::ContinueCommand() : _loopCommand(nullptr){}
+	ContinueCommand::ContinueCommand() : _loopCommand(nullptr) {}
 	ContinueCommand::~ContinueCommand() {}
 	void ContinueCommand::setLoopCommand(CommandPointer loopCommand) {
 		_loopCommand = loopCommand;
 	}
 
+	CommandPointer ContinueCommand::getLoopCommand() const {
+		return _loopCommand;
+	}
+
 	void ContinueCommand::buildCommandText(std::list<std::string>& strCommands) {
 		MultipleCommand::buildCommandText(strCommands);
 
@@ -893,100 +949,73 @@ namespace ffscript {
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
-	PushMemberVariableParam::PushMemberVariableParam() : _accessors(0) {}
-	PushMemberVariableParam::~PushMemberVariableParam() {
-		if (_accessors) {
+	static void buildAccessPlanText(MemberVariableAccessPlan* accessPlan, std::list<std::string>& strCommands) {
+		if (accessPlan->getGlobalAddress()) {
+			strCommands.emplace_back("lea (" + int_to_hex(accessPlan->getGlobalAddress()) + ", REGISTER)");
+		}
+		else {
+			strCommands.emplace_back("lea ([current_offset()], REGISTER)");
+		}
+		strCommands.emplace_back("add(REGISTER, " + std::to_string(accessPlan->getBaseOffset()) + ")");
+		for (int i = 1; i <= accessPlan->getDereferenceCount(); i++) {
+			strCommands.emplace_back("mov([REGISTER],REGISTER )");
+			strCommands.emplace_back("add(REGISTER, " + std::to_string(accessPlan->getOffset(i)) + ")");
+		}
+	}
 
-			for (auto it = _accessors->begin(); it != _accessors->end(); it++) {
-				delete *it;
-			}
+	static inline void* accessMemberVariable(Context* context, MemberVariableAccessPlan* accessPlan) {
+		void* baseAddress = accessPlan->getGlobalAddress();
+		if (baseAddress == nullptr) {
+			baseAddress = context->getAbsoluteAddress(context->getCurrentOffset());
+		}
+		else {
+			baseAddress = context->getGlobalAddress(baseAddress);
+		}
+		return accessPlan->access(baseAddress);
+	}
 
-			delete _accessors;
+	PushMemberVariableParam::PushMemberVariableParam() : _accessPlan(nullptr) {}
+	PushMemberVariableParam::~PushMemberVariableParam() {
+		if (_accessPlan) {
+			delete _accessPlan;
 		}
 	}
-	void PushMemberVariableParam::setCommandData(std::vector<MemberVariableAccessor*>* accessors, int paramSize, int targetOffset) {
-		_accessors = accessors;
+	void PushMemberVariableParam::setCommandData(MemberVariableAccessPlan* accessPlan, int paramSize, int targetOffset) {
+		_accessPlan = accessPlan;
 		setTargetSize(paramSize);
 		setTargetOffset(targetOffset);
 	}
 
 	void PushMemberVariableParam::buildCommandText(std::list<std::string>& strCommands) {
-		MemberVariableAccessor* accessor, *accessorTmp;
-		for (auto it = _accessors->begin(); it != _accessors->end(); it++) {
-			accessor = *it;
-			if (accessorTmp = dynamic_cast<MVContextAccessor*>(accessor)) {
-				strCommands.emplace_back("lea ([current_offset()], REGISTER)");
-			}
-			else if(accessorTmp = dynamic_cast<MVGlobalAccessor*>(accessor)) {
-				std::stringstream ss;
-				ss << "lea(" << int_to_hex(((MVGlobalAccessor*)accessor)->access(nullptr)) << ", REGISTER)";
-				strCommands.emplace_back("lea ([current_offset()], REGISTER)");
-			}
-			else if (accessorTmp = dynamic_cast<MVOffsetAccessor*>(accessor)) {
-				strCommands.emplace_back("add(REGISTER, " + std::to_string(((MVOffsetAccessor*)accessor)->_offset) + ")");
-			}
-			else if (accessorTmp = dynamic_cast<MVPointerAccessor*>(accessor)) {
-				strCommands.emplace_back("mov([REGISTER],REGISTER )");
-			}
-		}
+		buildAccessPlanText(_accessPlan, strCommands);
 
 		std::stringstream ss;
 		ss << "write(REGISTER, [" << getTargetOffset() << "])";
+		strCommands.emplace_back(ss.str());
 	}
 
 	void PushMemberVariableParam::execute() {
 		Context* context = Context::getCurrent();
-		MemberVariableAccessor** accessors = _accessors->data();
-		size_t count = _accessors->size();
-		MemberVariableAccessor** end = accessors + count;
-
-		void* address = (*accessors)->access(nullptr);
-
-		for (accessors++; accessors < end; accessors++) {
-			address = (*accessors)->access(address);
-		}
+		void* address = accessMemberVariable(context, _accessPlan);
 
 		int targetOffset = getTargetOffset() + context->getCurrentOffset();
 		context->write(targetOffset, address, getTargetSize());
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
-	PushMemberVariableParamRef::PushMemberVariableParamRef() : _accessors(0), TargetedCommand(0, sizeof(void*)) {}
+	PushMemberVariableParamRef::PushMemberVariableParamRef() : TargetedCommand(0, sizeof(void*)), _accessPlan(nullptr) {}
 	PushMemberVariableParamRef::~PushMemberVariableParamRef() {
-		if (_accessors) {
-
-			for (auto it = _accessors->begin(); it != _accessors->end(); it++) {
-				delete *it;
-			}
-
-			delete _accessors;
+		if (_accessPlan) {
+			delete _accessPlan;
 		}
 	}
-	void PushMemberVariableParamRef::setCommandData(std::vector<MemberVariableAccessor*>* accessors, int targetOffset) {
-		_accessors = accessors;
+	void PushMemberVariableParamRef::setCommandData(MemberVariableAccessPlan* accessPlan, int targetOffset) {
+		_accessPlan = accessPlan;
 		setTargetOffset(targetOffset);
 	}
 
 	void PushMemberVariableParamRef::buildCommandText(std::list<std::string>& strCommands) {
-		Context* context = Context::getCurrent();
-		MemberVariableAccessor* accessor, *accessorTmp;
-		for (auto it = _accessors->begin(); it != _accessors->end(); it++) {
-			accessor = *it;
-			if (accessorTmp = dynamic_cast<MVContextAccessor*>(accessor)) {
-				strCommands.emplace_back("lea ([current_offset()], REGISTER)");
-			}
-			else if (accessorTmp = dynamic_cast<MVGlobalAccessor*>(accessor)) {
-				std::stringstream ss;
-				ss << "lea (" << int_to_hex(((MVGlobalAccessor*)accessor)->access(nullptr)) << ", REGISTER)";
-				strCommands.emplace_back("lea ([current_offset()], REGISTER)");
-			}
-			else if (accessorTmp = dynamic_cast<MVOffsetAccessor*>(accessor)) {
-				strCommands.emplace_back("add(REGISTER, " + std::to_string(((MVOffsetAccessor*)accessor)->_offset) + ")");
-			}
-			else if (accessorTmp = dynamic_cast<MVPointerAccessor*>(accessor)) {
-				strCommands.emplace_back("mov([REGISTER],REGISTER )");
-			}
-		}
+		buildAccessPlanText(_accessPlan, strCommands);
 
 		std::stringstream ss;
 		ss << "lea (REGISTER, [" << getTargetOffset() << "])";
@@ -996,15 +1025,7 @@ namespace ffscript {
 
 	void PushMemberVariableParamRef::execute() {
 		Context* context = Context::getCurrent();
-		MemberVariableAccessor** accessors = _accessors->data();
-		size_t count = _accessors->size();
-		MemberVariableAccessor** end = accessors + count;
-
-		void* address = (*accessors)->access(nullptr);
-
-		for (accessors++; accessors < end; accessors++) {
-			address = (*accessors)->access(address);
-		}
+		void* address = accessMemberVariable(context, _accessPlan);
 
 		int targetOffset = getTargetOffset() + context->getCurrentOffset();
 		context->lea(targetOffset, address);
@@ -1046,10 +1067,14 @@ namespace ffscript {
 
 		RuntimeFunctionInfo* runtimeData = (RuntimeFunctionInfo*)returnVal;
 		runtimeData->address = _anoynymousTargetFunction;
-		runtimeData->anoynymousInfo.data = malloc(_dataSize);
 		runtimeData->anoynymousInfo.targetOffset = _destDataOffset;
 		runtimeData->anoynymousInfo.dataSize = _dataSize;
         runtimeData->info.type = RuntimeFunctionType::ScriptFunction;
-		memcpy_s(runtimeData->anoynymousInfo.data, _dataSize, dataAddress, _dataSize);
+		//only the lambda which captures more than the inline buffer needs heap memory
+		if (!isInlineAnoynymousData(runtimeData->anoynymousInfo)) {
+			runtimeData->anoynymousInfo.data = malloc(_dataSize);
+			INSTRUMENT_CONTEXT(context, onHeapAllocation(runtimeData->anoynymousInfo.data, (unsigned int)_dataSize));
+		}
+		memcpy_s(getAnoynymousData(runtimeData->anoynymousInfo), _dataSize, dataAddress, _dataSize);
 	}
 }
@@ -34,7 +34,7 @@ class DFunction2;
 namespace ffscript {
 
 	class Context;
-	class MemberVariableAccessor;
+	class MemberVariableAccessPlan;
 
 	class InstructionCommand
 	{
@@ -181,12 +181,11 @@ public:
 	{
 	protected:
 		int _beginParamOffset;		
-		std::string _functionName;
 	public:
 		CallFuntion();
 		int getBeginParamOffset() const;
-		void setFunctionName(const std::string& functionName);
-		const std::string& getFunctionName();
+		// name of the called function in the debug info which the command text is built with
+		std::string getFunctionName() const;
 		virtual ~CallFuntion();		
 	};
 
@@ -194,6 +193,8 @@ public:
 	BEGIN_INSTRUCTION_COMMAND_DECLARE(CallNativeFuntion, CallFuntion);
 private:
 	DFunction2Ref _targetFunction;
+	DFunctionThunk _thunk;
+	void* _thunkTarget;
 public:
 	void setCommandData(int returnOffset, int beginParamOffset, const DFunction2Ref& targetFunction);
 	END_INSTRUCTION_COMMAND_DECLARE(CallNativeFuntion);
@@ -219,9 +220,10 @@ public:
 	////////////////////////////////////////////////////
 	BEGIN_INSTRUCTION_COMMAND_DECLARE(CallDynamicFuntion, CallNativeFuntionWithAssitInfo);
 	protected:
-		int* _scriptTypes;
-		char** _typeNames;
-		int* _sizes;
+		// constant part of the param array, it is built once when the command is created
+		// only data pointers of the params need to be updated when the command is run
+		SimpleVariantArray* _paramArray;
+		int _paramArraySize;
 	public:
 		void setParamsType(int* scriptTypes, char** typeNames, int* sizes);
 	END_INSTRUCTION_COMMAND_DECLARE(CallDynamicFuntion);
@@ -267,8 +269,20 @@ protected:
 	CommandPointer _targetCommand;
 public:
 	void setCommandData(CommandPointer targetCommand);
+	CommandPointer getTargetCommand() const;
 	END_INSTRUCTION_COMMAND_DECLARE(Jump);
 
+	////////////////////////////////////////////////////
+	// replace the first command of a function code to run the call with other code,
+	// the return command of the call is kept
+	BEGIN_INSTRUCTION_COMMAND_DECLARE(RedirectFunction, InstructionCommand);
+protected:
+	CommandPointer _targetCommand;
+public:
+	void setCommandData(CommandPointer targetCommand);
+	CommandPointer getTargetCommand() const;
+	END_INSTRUCTION_COMMAND_DECLARE(RedirectFunction);
+
 	////////////////////////////////////////////////////
 	BEGIN_INSTRUCTION_COMMAND_DECLARE(JumpIf, InstructionCommand);
 protected:
@@ -276,6 +290,8 @@ protected:
 	CommandPointer _targetCommandTrue;
 public:
 	void setCommandData(int conditionOffset, CommandPointer targetCommand);
+	CommandPointer getTargetCommand() const;
+	void setTargetCommand(CommandPointer targetCommand);
 	END_INSTRUCTION_COMMAND_DECLARE(JumpIf);
 
 	////////////////////////////////////////////////////
@@ -284,6 +300,7 @@ protected:
 	CommandPointer _targetCommandFalse;
 public:
 	void setCommandElse(CommandPointer targetCommand);
+	CommandPointer getCommandElse() const;
 	END_INSTRUCTION_COMMAND_DECLARE(JumpIfElse);
 
 	////////////////////////////////////////////////////
@@ -323,20 +340,21 @@ private:
 	CommandPointer _loopCommand;
 public:
 	void setLoopCommand(CommandPointer loopCommand);
+	CommandPointer getLoopCommand() const;
 	END_INSTRUCTION_COMMAND_DECLARE(ContinueCommand);
 
 	BEGIN_INSTRUCTION_COMMAND_DECLARE(PushMemberVariableParam, TargetedCommand);
 protected:
-	std::vector<MemberVariableAccessor*>* _accessors;
+	MemberVariableAccessPlan* _accessPlan;
 public:
-	void setCommandData(std::vector<MemberVariableAccessor*>* accessors, int paramSize, int targetOffset);
+	void setCommandData(MemberVariableAccessPlan* accessPlan, int paramSize, int targetOffset);
 	END_INSTRUCTION_COMMAND_DECLARE(PushMemberVariableParam);
 
 	BEGIN_INSTRUCTION_COMMAND_DECLARE(PushMemberVariableParamRef, TargetedCommand);
 protected:
-	std::vector<MemberVariableAccessor*>* _accessors;
+	MemberVariableAccessPlan* _accessPlan;
 public:
-	void setCommandData(std::vector<MemberVariableAccessor*>* accessors, int targetOffset);
+	void setCommandData(MemberVariableAccessPlan* accessPlan, int targetOffset);
 	END_INSTRUCTION_COMMAND_DECLARE(PushMemberVariableParamRef);
 
 	////////////////////////////////////////////////////
@@ -0,0 +1,140 @@
+/******************************************************************
+* File:        Instrumentation.cpp
+* Description: implement Instrumentation class. A class that counts
+*              the commands, the calls, the scopes and the heap
+*              allocations run by a context and optionally traces
+*              them to a ring buffer. It is used only when the
+*              library is built with FFSCRIPT_INSTRUMENTATION.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "Instrumentation.h"
+#include "DebugInfo.h"
+#include <stdlib.h>
+#include <sstream>
+#if __GNUC__
+#include <cxxabi.h>
+#endif
+
+namespace ffscript {
+
+	static const char TRACE_MAGIC[] = "FFTRACE1";
+
+	static std::string getClassName(const std::type_info* typeInfo) {
+#if __GNUC__
+		int status = 0;
+		char* demangledName = abi::__cxa_demangle(typeInfo->name(), nullptr, nullptr, &status);
+		if (demangledName) {
+			std::string className(demangledName);
+			free(demangledName);
+			return className;
+		}
+#endif
+		return typeInfo->name();
+	}
+
+	Instrumentation::Instrumentation() : _traceNext(0), _traceFull(false) {
+		reset();
+	}
+
+	Instrumentation::~Instrumentation() {}
+
+	static std::string getCommandName(const InstructionCommand* command, const DebugInfo* debugInfo) {
+		auto name = debugInfo ? debugInfo->getCommandName(command) : nullptr;
+		if (name) {
+			return *name;
+		}
+		std::stringstream ss;
+		ss << "command " << (const void*)command;
+		return ss.str();
+	}
+
+	void Instrumentation::getStatistics(ContextStatistics& statistics, const DebugInfo* debugInfo) const {
+		statistics.commandCount = _commandCount;
+		statistics.scriptCallCount = _scriptCallCount;
+		statistics.nativeCallCount = _nativeCallCount;
+		statistics.scopeEnterCount = _scopeEnterCount;
+		statistics.scopeExitCount = _scopeExitCount;
+		statistics.heapAllocationCount = _heapAllocationCount;
+		statistics.heapAllocationSize = _heapAllocationSize;
+
+		statistics.commandCountByClass.clear();
+		for (auto it = _commandCountByClass.begin(); it != _commandCountByClass.end(); ++it) {
+			statistics.commandCountByClass[getClassName(it->first)] += it->second;
+		}
+		statistics.nativeCallCountByName.clear();
+		for (auto it = _nativeCallCountByCommand.begin(); it != _nativeCallCountByCommand.end(); ++it) {
+			statistics.nativeCallCountByName[getCommandName(it->first, debugInfo)] += it->second;
+		}
+	}
+
+	void Instrumentation::reset() {
+		_commandCount = 0;
+		_scriptCallCount = 0;
+		_nativeCallCount = 0;
+		_scopeEnterCount = 0;
+		_scopeExitCount = 0;
+		_heapAllocationCount = 0;
+		_heapAllocationSize = 0;
+		_commandCountByClass.clear();
+		_nativeCallCountByCommand.clear();
+		_traceNext = 0;
+		_traceFull = false;
+	}
+
+	void Instrumentation::setTraceCapacity(unsigned int capacity) {
+		_traceRecords.clear();
+		_traceRecords.shrink_to_fit();
+		_traceRecords.resize(capacity);
+		_traceNext = 0;
+		_traceFull = false;
+	}
+
+	unsigned int Instrumentation::getTraceCapacity() const {
+		return (unsigned int)_traceRecords.size();
+	}
+
+	void Instrumentation::getTraceRecords(std::vector<TraceRecord>& records) const {
+		records.clear();
+		if (_traceFull) {
+			records.insert(records.end(), _traceRecords.begin() + _traceNext, _traceRecords.end());
+		}
+		records.insert(records.end(), _traceRecords.begin(), _traceRecords.begin() + _traceNext);
+	}
+
+	void Instrumentation::writeTrace(std::ostream& os) const {
+		std::vector<TraceRecord> records;
+		getTraceRecords(records);
+
+		unsigned long long recordCount = records.size();
+		os.write(TRACE_MAGIC, sizeof(TRACE_MAGIC) - 1);
+		os.write((const char*)&recordCount, sizeof(recordCount));
+		if (recordCount) {
+			os.write((const char*)records.data(), records.size() * sizeof(TraceRecord));
+		}
+	}
+
+	void Instrumentation::writeStatistics(std::ostream& os, const DebugInfo* debugInfo) const {
+		ContextStatistics statistics;
+		getStatistics(statistics, debugInfo);
+
+		os << "commands\t" << statistics.commandCount << std::endl;
+		os << "script calls\t" << statistics.scriptCallCount << std::endl;
+		os << "native calls\t" << statistics.nativeCallCount << std::endl;
+		os << "scope enters\t" << statistics.scopeEnterCount << std::endl;
+		os << "scope exits\t" << statistics.scopeExitCount << std::endl;
+		os << "heap allocations\t" << statistics.heapAllocationCount << std::endl;
+		os << "heap allocated bytes\t" << statistics.heapAllocationSize << std::endl;
+		for (auto it = statistics.commandCountByClass.begin(); it != statistics.commandCountByClass.end(); ++it) {
+			os << "command " << it->first << "\t" << it->second << std::endl;
+		}
+		for (auto it = statistics.nativeCallCountByName.begin(); it != statistics.nativeCallCountByName.end(); ++it) {
+			os << "native " << it->first << "\t" << it->second << std::endl;
+		}
+	}
+}
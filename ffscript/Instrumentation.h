@@ -0,0 +1,140 @@
+/******************************************************************
+* File:        Instrumentation.h
+* Description: declare Instrumentation class. A class that counts
+*              the commands, the calls, the scopes and the heap
+*              allocations run by a context and optionally traces
+*              them to a ring buffer. It is used only when the
+*              library is built with FFSCRIPT_INSTRUMENTATION.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+#include "InstructionCommand.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <typeinfo>
+
+#if FFSCRIPT_INSTRUMENTATION
+#define INSTRUMENT_CONTEXT(context, event) (context)->getInstrumentation()->event
+#else
+#define INSTRUMENT_CONTEXT(context, event)
+#endif
+
+namespace ffscript {
+
+	enum class TraceEvent : unsigned int {
+		Command = 0,
+		ScriptCall,
+		NativeCall,
+		ScopeEnter,
+		ScopeExit,
+		HeapAllocation,
+	};
+
+	struct TraceRecord {
+		// number of commands run before the event
+		unsigned long long sequence;
+		// the command for command and call events, the allocated block for heap allocation events
+		const void* target;
+		TraceEvent event;
+		// allocated size for heap allocation events
+		unsigned int size;
+	};
+
+	struct ContextStatistics {
+		unsigned long long commandCount;
+		unsigned long long scriptCallCount;
+		unsigned long long nativeCallCount;
+		unsigned long long scopeEnterCount;
+		unsigned long long scopeExitCount;
+		unsigned long long heapAllocationCount;
+		unsigned long long heapAllocationSize;
+		// commands run by the context loop by class name, the commands in a command tree are counted as their root
+		std::map<std::string, unsigned long long> commandCountByClass;
+		// native calls by function name, the calls are named by the address of their command without debug info
+		std::map<std::string, unsigned long long> nativeCallCountByName;
+	};
+
+	class DebugInfo;
+
+	class FFSCRIPT_API Instrumentation
+	{
+		unsigned long long _commandCount;
+		unsigned long long _scriptCallCount;
+		unsigned long long _nativeCallCount;
+		unsigned long long _scopeEnterCount;
+		unsigned long long _scopeExitCount;
+		unsigned long long _heapAllocationCount;
+		unsigned long long _heapAllocationSize;
+		std::unordered_map<const std::type_info*, unsigned long long> _commandCountByClass;
+		// native calls by call command, the commands are named when the statistics are read
+		std::unordered_map<const InstructionCommand*, unsigned long long> _nativeCallCountByCommand;
+		std::vector<TraceRecord> _traceRecords;
+		size_t _traceNext;
+		bool _traceFull;
+	private:
+		inline void trace(TraceEvent event, const void* target, unsigned int size) {
+			if (_traceRecords.size()) {
+				_traceRecords[_traceNext] = { _commandCount, target, event, size };
+				if (++_traceNext == _traceRecords.size()) {
+					_traceNext = 0;
+					_traceFull = true;
+				}
+			}
+		}
+	public:
+		Instrumentation();
+		virtual ~Instrumentation();
+
+		inline void onCommand(const InstructionCommand* command) {
+			trace(TraceEvent::Command, command, 0);
+			_commandCount++;
+			_commandCountByClass[&typeid(*command)]++;
+		}
+		inline void onScriptCall(const InstructionCommand* command) {
+			trace(TraceEvent::ScriptCall, command, 0);
+			_scriptCallCount++;
+		}
+		inline void onNativeCall(const InstructionCommand* command) {
+			trace(TraceEvent::NativeCall, command, 0);
+			_nativeCallCount++;
+			_nativeCallCountByCommand[command]++;
+		}
+		inline void onScopeEnter() {
+			trace(TraceEvent::ScopeEnter, nullptr, 0);
+			_scopeEnterCount++;
+		}
+		inline void onScopeExit() {
+			trace(TraceEvent::ScopeExit, nullptr, 0);
+			_scopeExitCount++;
+		}
+		inline void onHeapAllocation(const void* block, unsigned int size) {
+			trace(TraceEvent::HeapAllocation, block, size);
+			_heapAllocationCount++;
+			_heapAllocationSize += size;
+		}
+
+		// the native calls are named by the debug info of the program if it is given
+		void getStatistics(ContextStatistics& statistics, const DebugInfo* debugInfo = nullptr) const;
+		void reset();
+
+		// keep the last events in a ring buffer of the given number of records, zero stops tracing
+		void setTraceCapacity(unsigned int capacity);
+		unsigned int getTraceCapacity() const;
+		// traced records, the oldest one is the first
+		void getTraceRecords(std::vector<TraceRecord>& records) const;
+		// write the magic "FFTRACE1", the record count as a 64 bits integer and the records in binary
+		void writeTrace(std::ostream& os) const;
+		// write the statistics as text, one counter per line
+		void writeStatistics(std::ostream& os, const DebugInfo* debugInfo = nullptr) const;
+	};
+}
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <string>
+#include "ScriptLexer.h"
 
 template <typename CharType>
 inline const CharType* trimLeft(const CharType* s, const CharType* end) {
@@ -23,6 +24,11 @@ inline const CharType* trimLeft(const CharType* s, const CharType* end) {
 	return c;
 }
 
+// script code is trimmed by blocks of characters
+inline const wchar_t* trimLeft(const wchar_t* s, const wchar_t* end) {
+	return ffscript::ScriptLexer::skipSpaces(s, end);
+}
+
 template <typename CharType>
 inline const CharType* trimRight(const CharType* s, const CharType* end) {
 	const CharType* c = end - 1;
@@ -1,8 +1,10 @@
 /******************************************************************
 * File:        MemberVariableAccessors.cpp
-* Description: implement member variable accessor classes. Each member
-*              variable accessor has its own data and behavior to
-*              access its data base on parent's address.
+* Description: implement MemberVariableAccessPlan class. A plan holds
+*              the base address and offsets that used to access a
+*              member variable from its root variable. Consecutive
+*              offsets are folded when the plan is built, so only
+*              dereferences of reference members remain.
 * Author:      Vincent Pham
 *
 * Copyright (c) 2018 VincentPT.
@@ -12,33 +14,45 @@
 **********************************************************************/
 
 #include "MemberVariableAccessors.h"
-#include "Context.h"
+#include <stdlib.h>
 
 namespace ffscript {
-	MemberVariableAccessor::MemberVariableAccessor() {}
-	MemberVariableAccessor::~MemberVariableAccessor() {}
+	MemberVariableAccessPlan::MemberVariableAccessPlan() : _globalAddress(nullptr), _derefCount(0) {
+		_offsets = (int*)malloc(sizeof(int));
+		_offsets[0] = 0;
+	}
+
+	MemberVariableAccessPlan::~MemberVariableAccessPlan() {
+		free(_offsets);
+	}
+
+	void MemberVariableAccessPlan::setGlobalAddress(void* address) {
+		_globalAddress = address;
+	}
+
+	void MemberVariableAccessPlan::addOffset(int offset) {
+		_offsets[_derefCount] += offset;
+	}
 
-	/////////////////////////////////////////////////////////////////////////////////////////
-	MVOffsetAccessor::MVOffsetAccessor(int offset) : _offset(offset) {}
+	void MemberVariableAccessPlan::addDereference() {
+		_derefCount++;
+		_offsets = (int*)realloc(_offsets, (_derefCount + 1) * sizeof(int));
+		_offsets[_derefCount] = 0;
+	}
 
-	void* MVOffsetAccessor::access(void* address) {
-		return ((char*)address) + _offset;
+	void* MemberVariableAccessPlan::getGlobalAddress() const {
+		return _globalAddress;
 	}
 
-	/////////////////////////////////////////////////////////////////////////////////////////
-	void* MVPointerAccessor::access(void* address) {
-		return (void*)*((size_t*)address);
+	int MemberVariableAccessPlan::getBaseOffset() const {
+		return _offsets[0];
 	}
 
-	/////////////////////////////////////////////////////////////////////////////////////////
-	void* MVContextAccessor::access(void*) {
-		Context* context = Context::getCurrent();
-		return context->getAbsoluteAddress(context->getCurrentOffset());
+	int MemberVariableAccessPlan::getDereferenceCount() const {
+		return _derefCount;
 	}
 
-	/////////////////////////////////////////////////////////////////////////////////////////
-	MVGlobalAccessor::MVGlobalAccessor(void* address) : _address(address) {}
-	void* MVGlobalAccessor::access(void*) {
-		return _address;
+	int MemberVariableAccessPlan::getOffset(int i) const {
+		return _offsets[i];
 	}
-}
\ No newline at end of file
+}
@@ -1,8 +1,10 @@
 /******************************************************************
 * File:        MemberVariableAccessors.h
-* Description: declare member variable accessor classes. Each member
-*              variable accessor has its own data and behavior to
-*              access its data base on parent's address.
+* Description: declare MemberVariableAccessPlan class. A plan holds
+*              the base address and offsets that used to access a
+*              member variable from its root variable. Consecutive
+*              offsets are folded when the plan is built, so only
+*              dereferences of reference members remain.
 * Author:      Vincent Pham
 *
 * Copyright (c) 2018 VincentPT.
@@ -13,38 +15,37 @@
 
 #pragma once
 namespace ffscript {
-	class MemberVariableAccessor
+	class MemberVariableAccessPlan
 	{
+		// address of the root variable if it is a global variable, null if it is a local variable
+		void* _globalAddress;
+		// _offsets[0] is added to the base address, _offsets[i] is added after i-th dereference
+		int* _offsets;
+		int _derefCount;
 	public:
-		MemberVariableAccessor();
-		virtual ~MemberVariableAccessor();
-		virtual void* access(void* address) = 0;
-	};
-
-	class MVContextAccessor : public MemberVariableAccessor {
-	public:
-		void* access(void* address);
-	};
+		MemberVariableAccessPlan();
+		MemberVariableAccessPlan(const MemberVariableAccessPlan&) = delete;
+		~MemberVariableAccessPlan();
 
-	class MVGlobalAccessor : public MemberVariableAccessor {
-	public:
-		void* _address;
-	public:
-		MVGlobalAccessor(void* address);
-		void* access(void* address);
-	};
+		void setGlobalAddress(void* address);
+		// add offset to the current address
+		void addOffset(int offset);
+		// read the current address as a pointer
+		void addDereference();
 
-	class MVOffsetAccessor : public MemberVariableAccessor {
-	public:
-		int _offset;
-	public:
-		MVOffsetAccessor(int offset);
-		void* access(void* address);		
-	};
+		void* getGlobalAddress() const;
+		int getBaseOffset() const;
+		int getDereferenceCount() const;
+		int getOffset(int i) const;
 
-	class MVPointerAccessor : public MemberVariableAccessor {
-	public:
-		void* access(void* address);
+		inline void* access(void* baseAddress) const {
+			char* address = (char*)baseAddress + _offsets[0];
+			const int* offset = _offsets + 1;
+			const int* offsetEnd = offset + _derefCount;
+			for (; offset < offsetEnd; offset++) {
+				address = *((char**)address) + *offset;
+			}
+			return address;
+		}
 	};
 }
-
@@ -0,0 +1,138 @@
+/******************************************************************
+* File:        PlainCodeOptimizer.cpp
+* Description: implement PlainCodeOptimizer class. A class used to
+*              clean up the plain code of a program after all
+*              commands are completely updated.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "PlainCodeOptimizer.h"
+#include "InstructionCommand.h"
+#include "Program.h"
+#include <typeinfo>
+
+namespace ffscript {
+
+	// a multiple command which has no extra behavior except running its sub commands
+	static inline bool isPlainMultipleCommand(InstructionCommand* command) {
+		return typeid(*command) == typeid(MultipleCommand) || typeid(*command) == typeid(BreakCommand);
+	}
+
+	static inline bool isNoOperation(InstructionCommand* command) {
+		return isPlainMultipleCommand(command) && ((MultipleCommand*)command)->getCommands().size() == 0;
+	}
+
+	// a copy whose source and target are the same memory
+	static inline bool isDeadCopy(InstructionCommand* command) {
+		if (typeid(*command) != typeid(PushParamOffset)) {
+			return false;
+		}
+		auto copyCommand = (PushParamOffset*)command;
+		return copyCommand->getSourceOffset() == copyCommand->getTargetOffset();
+	}
+
+	PlainCodeOptimizer::PlainCodeOptimizer(Program* program) :
+		_beginCommand(program->getFirstCommand()),
+		_endCommand(program->getEndCommand()),
+		_eliminatedCommandCount(0) {
+	}
+
+	PlainCodeOptimizer::~PlainCodeOptimizer() {
+	}
+
+	bool PlainCodeOptimizer::isInProgram(CommandPointer commandPointer) const {
+		return commandPointer >= _beginCommand && commandPointer < _endCommand;
+	}
+
+	CommandPointer PlainCodeOptimizer::threadTarget(CommandPointer targetCommand) {
+		// a jump command moves the command cursor to the target command and the context
+		// executes the command after the target. So the commands after the target that
+		// do nothing can be skipped.
+		// Jump to jump chains are not threaded, the enter scope command remembers the last
+		// jump command to return to when the scope exits and the compiler starts every
+		// scope with an enter scope command, so a jump never lands on another jump.
+		while (targetCommand && isInProgram(targetCommand + 1) && isNoOperation(*(targetCommand + 1))) {
+			targetCommand++;
+		}
+		return targetCommand;
+	}
+
+	void PlainCodeOptimizer::flattenCommandList(CommandList& commandList) {
+		for (auto it = commandList.begin(); it != commandList.end();) {
+			if (isPlainMultipleCommand(*it)) {
+				CommandList subCommands = ((MultipleCommand*)*it)->getCommands();
+				flattenCommandList(subCommands);
+				commandList.splice(it, subCommands);
+				it = commandList.erase(it);
+				_eliminatedCommandCount++;
+			}
+			else if (isDeadCopy(*it)) {
+				it = commandList.erase(it);
+				_eliminatedCommandCount++;
+			}
+			else {
+				it++;
+			}
+		}
+	}
+
+	void PlainCodeOptimizer::optimizeJumps(CommandPointer commandPointer) {
+		InstructionCommand* command = *commandPointer;
+
+		if (auto jumpIf = dynamic_cast<JumpIf*>(command)) {
+			jumpIf->setTargetCommand(threadTarget(jumpIf->getTargetCommand()));
+
+			if (auto jumpIfElse = dynamic_cast<JumpIfElse*>(command)) {
+				jumpIfElse->setCommandElse(threadTarget(jumpIfElse->getCommandElse()));
+			}
+		}
+		else if (auto jump = dynamic_cast<Jump*>(command)) {
+			jump->setCommandData(threadTarget(jump->getTargetCommand()));
+		}
+		else if (auto continueCommand = dynamic_cast<ContinueCommand*>(command)) {
+			continueCommand->setLoopCommand(threadTarget(continueCommand->getLoopCommand()));
+		}
+	}
+
+	void PlainCodeOptimizer::optimizeMultipleCommands(CommandPointer commandPointer) {
+		auto multipleCommand = dynamic_cast<MultipleCommand*>(*commandPointer);
+		if (multipleCommand == nullptr) {
+			return;
+		}
+
+		auto& commands = multipleCommand->getCommands();
+		flattenCommandList(commands);
+
+		// the command contains only one command, so put the sub command to the plain code directly
+		if (commands.size() == 1 && isPlainMultipleCommand(multipleCommand)) {
+			*commandPointer = commands.front();
+			_eliminatedCommandCount++;
+		}
+	}
+
+	int PlainCodeOptimizer::optimize() {
+		_eliminatedCommandCount = 0;
+		if (_beginCommand == nullptr) {
+			return 0;
+		}
+
+		for (auto commandPointer = _beginCommand; commandPointer != _endCommand; commandPointer++) {
+			optimizeMultipleCommands(commandPointer);
+		}
+
+		for (auto commandPointer = _beginCommand; commandPointer != _endCommand; commandPointer++) {
+			optimizeJumps(commandPointer);
+		}
+
+		return _eliminatedCommandCount;
+	}
+
+	int PlainCodeOptimizer::getEliminatedCommandCount() const {
+		return _eliminatedCommandCount;
+	}
+}
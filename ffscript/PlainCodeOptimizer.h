@@ -0,0 +1,41 @@
+/******************************************************************
+* File:        PlainCodeOptimizer.h
+* Description: declare PlainCodeOptimizer class. A class used to
+*              clean up the plain code of a program after all
+*              commands are completely updated.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+
+namespace ffscript {
+
+	class Program;
+
+	class PlainCodeOptimizer
+	{
+		CommandPointer _beginCommand;
+		CommandPointer _endCommand;
+		int _eliminatedCommandCount;
+	private:
+		bool isInProgram(CommandPointer commandPointer) const;
+		CommandPointer threadTarget(CommandPointer targetCommand);
+		void flattenCommandList(CommandList& commandList);
+		void optimizeJumps(CommandPointer commandPointer);
+		void optimizeMultipleCommands(CommandPointer commandPointer);
+	public:
+		PlainCodeOptimizer(Program* program);
+		virtual ~PlainCodeOptimizer();
+
+		// run the optimization over the plain code of the program
+		// and return number of eliminated commands
+		int optimize();
+		int getEliminatedCommandCount() const;
+	};
+}
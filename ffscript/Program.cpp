@@ -15,9 +15,14 @@
 #include <Context.h>
 #include "Expression.h"
 #include "InstructionCommand.h"
+#include "PlainCodeOptimizer.h"
+#include "DebugInfo.h"
+#include <stdexcept>
 
 namespace ffscript {
-	Program::Program() : _commandCounter(0), _programCode(nullptr)
+	static const int CODE_UPDATING = -1;
+
+	Program::Program() : _stackInfoVersion(0), _codeVersion(0), _runningTaskCount(0), _programCode(nullptr), _commandCounter(0), _eliminatedCommandCount(0)
 		//_moveOffset()
 	{
 		//_assitantFuncLib = (FuncLibraryRef)( new FuncLibrary() );
@@ -37,6 +42,12 @@ namespace ffscript {
 		}
 	}
 
+	void Program::appendExecutors(Program& source) {
+		_commandContainer.splice(_commandContainer.end(), source._commandContainer);
+		_commandCounter += source._commandCounter;
+		source._commandCounter = 0;
+	}
+
 	void Program::convertToPlainCode() {
 		if (_commandCounter == 0) return;
 
@@ -59,6 +70,10 @@ namespace ffscript {
 				_expCmdMap.insert(std::make_pair(it1->get(), plainCode));
 			}
 		}
+
+		if (_debugInfo) {
+			addSourcePositions(_debugInfo.get());
+		}
 	}
 
 	CommandPointer Program::getFirstCommand() const {
@@ -77,6 +92,35 @@ namespace ffscript {
 		return nullptr;
 	}
 
+	int Program::optimizePlainCode() {
+		PlainCodeOptimizer optimizer(this);
+		_eliminatedCommandCount = optimizer.optimize();
+		return _eliminatedCommandCount;
+	}
+
+	int Program::getEliminatedCommandCount() const {
+		return _eliminatedCommandCount;
+	}
+
+	static int countCommands(InstructionCommand* command) {
+		int n = 1;
+		auto multipleCommand = dynamic_cast<MultipleCommand*>(command);
+		if (multipleCommand) {
+			for (auto subCommand : multipleCommand->getCommands()) {
+				n += countCommands(subCommand);
+			}
+		}
+		return n;
+	}
+
+	int Program::getCommandCount() const {
+		int n = 0;
+		for (auto commandPointer = getFirstCommand(); commandPointer != getEndCommand(); commandPointer++) {
+			n += countCommands(*commandPointer);
+		}
+		return n;
+	}
+
 	CodeSegmentEntry* Program::getFunctionPlainCode(int functionId) {
 		auto it = _functionMap.find(functionId);
 		if (it == _functionMap.end()) {
@@ -85,10 +129,63 @@ namespace ffscript {
 		return &it->second;
 	}
 
+	const std::map<int, CodeSegmentEntry>& Program::getFunctionPlainCodes() const {
+		return _functionMap;
+	}
+
 	void Program::setFunctionPlainCode(int functionId, const CodeSegmentEntry& functionCode) {
 		_functionMap.insert( std::make_pair(functionId, functionCode));
 	}
 
+	void Program::replaceFunctionPlainCode(int functionId, const CodeSegmentEntry& functionCode) {
+		auto it = _functionMap.find(functionId);
+		if (it != _functionMap.end()) {
+			// the function objects keep the address of the old code, its first command
+			// is replaced so they run the new code
+			RedirectFunction* redirectCommand = new RedirectFunction();
+			redirectCommand->setCommandData(functionCode.first);
+			_redirectCommands.push_back(std::unique_ptr<InstructionCommand>(redirectCommand));
+			*it->second.first = redirectCommand;
+		}
+		_functionMap[functionId] = functionCode;
+		_codeVersion++;
+	}
+
+	bool Program::beginCodeUpdate() {
+		int runningTaskCount = 0;
+		return _runningTaskCount.compare_exchange_strong(runningTaskCount, CODE_UPDATING);
+	}
+
+	void Program::endCodeUpdate() {
+		_runningTaskCount.store(0);
+	}
+
+	void Program::beginRun() {
+		int runningTaskCount = _runningTaskCount.load();
+		do {
+			if (runningTaskCount == CODE_UPDATING) {
+				throw std::runtime_error("the code of the program is being updated");
+			}
+		} while (!_runningTaskCount.compare_exchange_weak(runningTaskCount, runningTaskCount + 1));
+	}
+
+	void Program::endRun() {
+		_runningTaskCount.fetch_sub(1);
+	}
+
+	int Program::getRunningTaskCount() const {
+		int runningTaskCount = _runningTaskCount.load();
+		return runningTaskCount == CODE_UPDATING ? 0 : runningTaskCount;
+	}
+
+	int Program::getCodeVersion() const {
+		return _codeVersion;
+	}
+
+	void Program::attachProgram(Program* program) {
+		_attachedPrograms.push_back(std::unique_ptr<Program>(program));
+	}
+
 	FunctionInfo* Program::getFunctionInfo(int functionId) {
 		auto it = _functionInfoMap.find(functionId);
 		if (it == _functionInfoMap.end()) {
@@ -105,6 +202,59 @@ namespace ffscript {
 		_functionInfoMap.insert(std::make_pair(functionId, functionInfo));
 	}
 
+	void Program::setFunctionStackInfo(int functionId, const FunctionStackInfo& stackInfo) {
+		_functionStackInfoMap[functionId] = stackInfo;
+		_stackInfoVersion++;
+	}
+
+	const FunctionStackInfo* Program::getFunctionStackInfo(int functionId) const {
+		auto it = _functionStackInfoMap.find(functionId);
+		if (it == _functionStackInfoMap.end()) {
+			return nullptr;
+		}
+		return &it->second;
+	}
+
+	int Program::getStackInfoVersion() const {
+		return _stackInfoVersion;
+	}
+
+	int Program::getFunctionStackSize(int functionId) const {
+		std::map<int, int> stackSizes;
+		return computeStackSize(functionId, stackSizes);
+	}
+
+	// stack sizes of the visited functions, a function being visited has size -2
+	int Program::computeStackSize(int functionId, std::map<int, int>& stackSizes) const {
+		static const int VISITING = -2;
+		auto it = _functionStackInfoMap.find(functionId);
+		if (it == _functionStackInfoMap.end()) {
+			// native functions do not use the stack of the context
+			return _functionInfoMap.find(functionId) == _functionInfoMap.end() ? 0 : -1;
+		}
+
+		auto res = stackSizes.insert(std::make_pair(functionId, VISITING));
+		if (res.second == false) {
+			// a recursive call if the function is being visited
+			return res.first->second == VISITING ? -1 : res.first->second;
+		}
+
+		const FunctionStackInfo& stackInfo = it->second;
+		int stackSize = stackInfo.frameSize;
+		for (auto& call : stackInfo.calls) {
+			int calleeStackSize = call.calleeId == DYNAMIC_CALLEE_ID ? -1 : computeStackSize(call.calleeId, stackSizes);
+			if (calleeStackSize < 0) {
+				stackSize = -1;
+				break;
+			}
+			if (stackInfo.frameSize + call.extraSize + calleeStackSize > stackSize) {
+				stackSize = stackInfo.frameSize + call.extraSize + calleeStackSize;
+			}
+		}
+		stackSizes[functionId] = stackSize;
+		return stackSize;
+	}
+
 	//int Program::findFunction(const std::string& name, const std::vector<int>& paramTypes) {
 	//	return _assitantFuncLib->findFunction(name, paramTypes);
 	//}
@@ -116,4 +266,23 @@ namespace ffscript {
 	//int Program::mapDynamicFunction(const std::string& name, int functionId) {
 	//	return _assitantFuncLib->mapDynamicFunction(name, functionId);
 	//}
-}
\ No newline at end of file
+
+	void Program::enableDebugInfo() {
+		if (!_debugInfo) {
+			_debugInfo.reset(new DebugInfo());
+		}
+	}
+
+	DebugInfo* Program::getDebugInfo() const {
+		return _debugInfo.get();
+	}
+
+	void Program::addSourcePositions(DebugInfo* debugInfo) const {
+		for (auto it = _expCmdMap.begin(); it != _expCmdMap.end(); ++it) {
+			int charIndex = it->first->getSourceCharIndex();
+			if (charIndex >= 0) {
+				debugInfo->addSourceRange(it->second.first, it->second.second, charIndex);
+			}
+		}
+	}
+}
@@ -14,6 +14,7 @@
 #include "ffscript.h"
 #include <list>
 #include <memory>
+#include <atomic>
 #include "FunctionRegisterHelper.h"
 #include <map>
 #include <string.h>
@@ -23,28 +24,59 @@
 namespace ffscript {
 
 	class Executor;
+	class DebugInfo;
 
 	struct FunctionInfo {
 		unsigned short returnStorageSize;
 		unsigned short paramDataSize;		
 	};
 
+	// callee id of a call through a function object, the callee is known only at runtime
+#define DYNAMIC_CALLEE_ID -1
+
+	// a call made by a script function, the stack of the callee begins after
+	// the frame of the caller and the extra size
+	struct FunctionCall {
+		int calleeId;
+		int extraSize;
+	};
+
+	struct FunctionStackInfo {
+		// the largest offset used by the scopes of the function
+		int frameSize;
+		std::list<FunctionCall> calls;
+	};
+
 	class Program
 	{
 		std::list<std::shared_ptr<Executor>> _commandContainer;
 		std::map<Executor*, CodeSegmentEntry> _expCmdMap;
 		std::map<int, CodeSegmentEntry> _functionMap;
 		std::map<int, FunctionInfo> _functionInfoMap;
+		std::map<int, FunctionStackInfo> _functionStackInfoMap;
+		int _stackInfoVersion;
+		int _codeVersion;
+		std::list<std::unique_ptr<Program>> _attachedPrograms;
+		// commands which redirect the old code of reloaded functions to their new code
+		std::list<std::unique_ptr<InstructionCommand>> _redirectCommands;
+		// number of tasks running the program, it is CODE_UPDATING while the code is updated
+		std::atomic<int> _runningTaskCount;
+		std::unique_ptr<DebugInfo> _debugInfo;
 		//FuncLibraryRef _assitantFuncLib;
 
 		CommandPointer _programCode;
 		int _commandCounter;
+		int _eliminatedCommandCount;
 		//static Program* g_instance;
+	private:
+		int computeStackSize(int functionId, std::map<int, int>& stackSizes) const;
 	public:
 		Program();
 		virtual ~Program();
 
 		void addExecutor(const ExecutorRef& executor);
+		// move all executors of the source program to the end of this program
+		void appendExecutors(Program& source);
 		//int findFunction(const std::string& name, const std::vector<int>& paramTypes);
 		//int mapFunction(const std::string& name, const std::vector<ScriptType>& paramTypes, int functionId);
 		//int mapDynamicFunction(const std::string& name, int functionId);
@@ -57,10 +89,48 @@ namespace ffscript {
 
 		CodeSegmentEntry* getCode(Executor* pExcutor);
 
+		//clean up the plain code, this method must be called after all commands are updated
+		int optimizePlainCode();
+		int getEliminatedCommandCount() const;
+		// number of commands in the plain code and the commands run by its multiple commands
+		int getCommandCount() const;
+
 		CodeSegmentEntry* getFunctionPlainCode(int functionId);
+		const std::map<int, CodeSegmentEntry>& getFunctionPlainCodes() const;
 		void setFunctionPlainCode(int functionId, const CodeSegmentEntry& functionCode);
+		// make the function run the given code from its next call, the function objects which
+		// refer to the old code run the given code too. It must be called between
+		// beginCodeUpdate and endCodeUpdate
+		void replaceFunctionPlainCode(int functionId, const CodeSegmentEntry& functionCode);
+		// the code can be updated only when no task runs the program, it returns false otherwise.
+		// The tasks cannot run the program until endCodeUpdate is called
+		bool beginCodeUpdate();
+		void endCodeUpdate();
+		// a task must call beginRun before it runs the code of the program and endRun after that,
+		// beginRun throws an exception if the code is being updated
+		void beginRun();
+		void endRun();
+		int getRunningTaskCount() const;
+		// it is changed whenever the code of a function is replaced
+		int getCodeVersion() const;
+		// keep the program alive as long as this program, it is used to keep the code of reloaded functions
+		void attachProgram(Program* program);
 
 		FunctionInfo* getFunctionInfo(int functionId);
 		void setFunctionInfo(int functionId, const FunctionInfo& functionInfo);
+		void setFunctionStackInfo(int functionId, const FunctionStackInfo& stackInfo);
+		const FunctionStackInfo* getFunctionStackInfo(int functionId) const;
+		// the largest stack size used by a call of the function and the functions it calls.
+		// It is -1 if the function may be called recursively or calls a function object
+		int getFunctionStackSize(int functionId) const;
+		// it is changed whenever the stack info of a function is changed
+		int getStackInfoVersion() const;
+
+		// create the debug info table of the program, it must be called before the code is extracted
+		void enableDebugInfo();
+		// the debug info table or null if it is not enabled
+		DebugInfo* getDebugInfo() const;
+		// add the source positions of the plain code of this program to the debug info
+		void addSourcePositions(DebugInfo* debugInfo) const;
 	};
 }
@@ -34,7 +34,7 @@ namespace ffscript {
 			return new ScopeRuntimeDataFixSize();
 		}
 
-		return new ScopeRuntimeDataDynamicSize( (scopeContructorCount >> 3) + (scopeContructorCount & 0x07) != 0 ); // scopeContructorCount /8 + scopeContructorCount % 8
+		return new ScopeRuntimeDataDynamicSize( (scopeContructorCount >> 3) + ((scopeContructorCount & 0x07) != 0) ); // scopeContructorCount / 8 rounded up
 	}
 
 	unsigned char ScopeRuntimeData::isContructorExecuted(int index) {
@@ -72,14 +72,23 @@ namespace ffscript {
 		_executedConstructor = &_data;
 	}
 	ScopeRuntimeDataFixSize::~ScopeRuntimeDataFixSize() {}
+
+	unsigned int ScopeRuntimeDataFixSize::getAllocatedSize() const {
+		return (unsigned int)sizeof(*this);
+	}
 	
 	/////////////////////////////////////////////////////////////////////
-	ScopeRuntimeDataDynamicSize::ScopeRuntimeDataDynamicSize(int size) {
-		_data = (unsigned char*) malloc(size);
+	ScopeRuntimeDataDynamicSize::ScopeRuntimeDataDynamicSize(int size) : _size(size) {
+		// no constructor is executed when the scope is entered
+		_data = (unsigned char*) calloc(size, 1);
 		_executedConstructor = _data;
 	}
 
 	ScopeRuntimeDataDynamicSize::~ScopeRuntimeDataDynamicSize() {
 		free(_data);
 	}
+
+	unsigned int ScopeRuntimeDataDynamicSize::getAllocatedSize() const {
+		return (unsigned int)sizeof(*this) + _size;
+	}
 }
\ No newline at end of file
@@ -24,6 +24,8 @@ namespace ffscript {
 	public:
 		static ScopeRuntimeData* createRuntimeData(int scopeContructorCount);
 		virtual ~ScopeRuntimeData();
+		// number of heap bytes used by the object and its constructor flags
+		virtual unsigned int getAllocatedSize() const = 0;
 		unsigned char isContructorExecuted(int index);
 		void markContructorExecuted(int index);
 		void markContructorNotExecuted(int index);
@@ -35,13 +37,16 @@ namespace ffscript {
 	public:
 		ScopeRuntimeDataFixSize();
 		virtual ~ScopeRuntimeDataFixSize();
+		unsigned int getAllocatedSize() const override;
 	};
 
 	class ScopeRuntimeDataDynamicSize : public ScopeRuntimeData
 	{
 		unsigned char *_data;
+		int _size;
 	public:
 		ScopeRuntimeDataDynamicSize(int size);
 		virtual ~ScopeRuntimeDataDynamicSize();
+		unsigned int getAllocatedSize() const override;
 	};
 }
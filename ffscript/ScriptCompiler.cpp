@@ -130,6 +130,39 @@ namespace ffscript {
 		_messageBuffer.resize(256);
 	}
 
+	ScriptCompiler::ScriptCompiler(const std::shared_ptr<ScriptCompiler>& systemLibCompiler) :
+		_functionFactories(systemLibCompiler->_functionFactories),
+		_keywordMap(systemLibCompiler->_keywordMap),
+		_typeConversionMap(systemLibCompiler->_typeConversionMap),
+		_preCompileOperators(systemLibCompiler->_preCompileOperators),
+		_constructorMap(systemLibCompiler->_constructorMap),
+		_destructorMap(systemLibCompiler->_destructorMap),
+		_templates(systemLibCompiler->_templates),
+		_constantMap(systemLibCompiler->_constantMap),
+		_functionCallMap(systemLibCompiler->_functionCallMap),
+		_argumentTypesCache(systemLibCompiler->_argumentTypesCache),
+		_program(nullptr),
+		_logger(nullptr),
+		_systemLibCompiler(systemLibCompiler),
+		_refFunctionId(systemLibCompiler->_refFunctionId),
+		_functionInfoConstructorId(systemLibCompiler->_functionInfoConstructorId),
+		_functionInfoDestructorId(systemLibCompiler->_functionInfoDestructorId),
+		_functionInfoCopyConstructorId(systemLibCompiler->_functionInfoCopyConstructorId)
+	{
+		_functionLibRef = std::make_shared<FuncLibrary>(*systemLibCompiler->_functionLibRef);
+		_typeManagerRef = std::make_shared<TypeManager>(*systemLibCompiler->_typeManagerRef, this);
+
+		// constructor lists are extended when constructors are registered, so they are not shared
+		for (auto& it : systemLibCompiler->_copyConstructorMap) {
+			_copyConstructorMap.insert(std::make_pair(it.first, std::make_shared<BinaryFunctionParamMap>(*it.second)));
+		}
+		for (auto& it : systemLibCompiler->_constructorsMap) {
+			_constructorsMap.insert(std::make_pair(it.first, std::make_shared<ConstructorIDList>(*it.second)));
+		}
+
+		_messageBuffer.resize(256);
+	}
+
 	ScriptCompiler::~ScriptCompiler()
 	{
 	}
@@ -271,6 +304,7 @@ namespace ffscript {
 	}
 
 	Function* ScriptCompiler::createFunctionFromId(int functionId) {
+		std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
 		FunctionFactory* factory = _functionFactories[functionId];
 		auto pFunc = factory->build(factory->getName());
 		if (pFunc->getReturnType().isUnkownType()) {
@@ -309,6 +343,7 @@ namespace ffscript {
 		factory->setFunctionId(functionId);
 		factory->setName(name.c_str());
 		_functionFactories.push_back(factory);
+		clearResolutionCache();
 		return functionId;
 	}
 
@@ -329,16 +364,30 @@ namespace ffscript {
 		return true;
 	}
 
+	const std::vector<ScriptType>* ScriptCompiler::getArgumentTypes(const std::string& sargs) {
+		std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
+		auto it = _argumentTypesCache.find(sargs);
+		if (it != _argumentTypesCache.end()) {
+			return &it->second;
+		}
+
+		vector<ScriptType> args;
+		if (!parseArgumentTypes(this, sargs, args)) {
+			return nullptr;
+		}
+		return &(_argumentTypesCache[sargs] = std::move(args));
+	}
+
 	int ScriptCompiler::registFunction(const std::string& name, const std::string& sagrs, FunctionFactory* factory) {
 		factory->setCompiler(this);
 		
-		vector<ScriptType> args;
-		if (!parseArgumentTypes(this, sagrs, args)) {
+		auto args = getArgumentTypes(sagrs);
+		if (args == nullptr) {
 			LOG_COMPILE_MESSAGE(_logger, MESSAGE_WARNING, formatMessage("invalid arguments of function: %s(%s)", name.c_str(), sagrs.c_str()));
 			return -1;
 		}
 		
-		return registFunction(name, args, factory);
+		return registFunction(name, *args, factory);
 	}
 
 	void ScriptCompiler::unregisterFunction(int functionId) {
@@ -349,6 +398,7 @@ namespace ffscript {
 		}
 		_functionFactories[functionId] = nullptr;
 		_functionLibRef->unmapFunction(functionFactory->getName(), functionId);
+		clearResolutionCache();
 
 		for (auto it = _constructorMap.begin(); it != _constructorMap.end();) {
 			if (it->second == functionId) {
@@ -381,6 +431,7 @@ namespace ffscript {
 		factory->setFunctionId(functionId);
 		factory->setName(name.c_str());
 		_functionFactories.push_back(factory);
+		clearResolutionCache();
 
 		return functionId;
 	}
@@ -409,6 +460,7 @@ namespace ffscript {
 	}
 
 	void ScriptCompiler::setErrorText(const std::string& errorMsg) {
+		std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
 		_lastError = errorMsg;
 	}
 
@@ -441,6 +493,8 @@ namespace ffscript {
 	}
 
 	bool ScriptCompiler::registConstructor(int type, int functionId) {
+		// matching parameters may use the constructors
+		clearResolutionCache();
 		auto functionFactory = getFunctionFactory(functionId);
 		if (functionFactory == nullptr) {
 			this->setErrorText("operator is not found");
@@ -502,6 +556,7 @@ namespace ffscript {
 	}
 
 	bool ScriptCompiler::registDefaultConstructor(int type, int functionId) {
+		clearResolutionCache();
 		auto it = _constructorMap.insert(std::make_pair(type, functionId));
 		if (it.second == false) {
 			LOG_COMPILE_MESSAGE(_logger, MESSAGE_WARNING, formatMessage("the default constructor for type '%s' is already defined", getType(type).c_str()));
@@ -512,6 +567,7 @@ namespace ffscript {
 	}
 
 	bool ScriptCompiler::registBinaryConstructor(int type, int functionId) {
+		clearResolutionCache();
 
 		// check data type of argument #2
 		auto factory = getFunctionFactory(functionId);
@@ -644,12 +700,12 @@ namespace ffscript {
 			constructorCandidate.paramCasting.push_back(emptyCasingInfo);
 			constructorCandidate.totalAccurative = 0;
 
-			candidates = make_shared<list<CandidateInfo>>();
+			candidates = makeCompileShared<list<CandidateInfo>>();
 			candidates->push_back(constructorCandidate);
 
 			return candidates;
 		}
-		candidates = make_shared<list<CandidateInfo>>();
+		candidates = makeCompileShared<list<CandidateInfo>>();
 
 		ScriptType refVoidType(_typeManagerRef->getBasicTypes().TYPE_VOID | DATA_TYPE_POINTER_MASK, "ref void");
 		for (auto it = registFunctions->begin(); it != registFunctions->end(); it++) {
@@ -853,12 +909,25 @@ namespace ffscript {
 	}
 
 	Function* ScriptCompiler::findCastingFunction(const ScriptType& sourceType, const ScriptType& targetType) {
-		int functionId = findFunction(targetType.sType(), { sourceType });
-		if (functionId < 0) {
-			return nullptr;
+		std::string key = std::to_string(sourceType.iType()) + sourceType.sType() + '>' + std::to_string(targetType.iType()) + targetType.sType();
+		// the cache is shared by the threads which extract function bodies in parallel
+		int cachedFunctionId = -2;
+		{
+			std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
+			auto cit = _castingFunctionCache.find(key);
+			if (cit != _castingFunctionCache.end()) {
+				cachedFunctionId = cit->second;
+			}
+		}
+		if (cachedFunctionId != -2) {
+			return cachedFunctionId < 0 ? nullptr : createFunctionFromId(cachedFunctionId);
 		}
 
-		auto theFunction = createFunctionFromId(functionId);
+		int functionId = findFunction(targetType.sType(), { sourceType });
+		Function* theFunction = nullptr;
+		if (functionId >= 0) {
+			theFunction = createFunctionFromId(functionId);
+		}
 		if (theFunction) {
 			auto& rt = theFunction->getReturnType();
 			if (targetType.iType() != rt.iType()) {
@@ -866,6 +935,8 @@ namespace ffscript {
 				theFunction = nullptr;
 			}
 		}
+		std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
+		_castingFunctionCache[key] = theFunction ? functionId : -1;
 		return theFunction;
 	}
 
@@ -887,7 +958,7 @@ namespace ffscript {
 				}
 
 				DFunction2Ref derefCommand = make_shared<DeRefCommand>(getTypeSize(argumentType));
-				auto derefFunction = make_shared<FixParamFunction<1>>(DEREF_OPERATOR, EXP_UNIT_ID_DEREF, FUNCTION_PRIORITY_UNARY_PREFIX, argumentType);
+				auto derefFunction = makeCompileShared<FixParamFunction<1>>(DEREF_OPERATOR, EXP_UNIT_ID_DEREF, FUNCTION_PRIORITY_UNARY_PREFIX, argumentType);
 				derefFunction->setNative(derefCommand);
 				theFunction->pushParam(derefFunction);
 
@@ -938,7 +1009,7 @@ namespace ffscript {
 
 				// 1. deref unit
 				DFunction2Ref derefCommand = make_shared<DeRefCommand>(getTypeSize(argumentTypeOrigin));
-				auto derefFunction = make_shared<FixParamFunction<1>>(DEREF_OPERATOR, EXP_UNIT_ID_DEREF, FUNCTION_PRIORITY_UNARY_PREFIX, argumentTypeOrigin);
+				auto derefFunction = makeCompileShared<FixParamFunction<1>>(DEREF_OPERATOR, EXP_UNIT_ID_DEREF, FUNCTION_PRIORITY_UNARY_PREFIX, argumentTypeOrigin);
 				derefFunction->setNative(derefCommand);
 				
 				// 2. casting type of [1] to origin type of argument
@@ -1096,7 +1167,7 @@ namespace ffscript {
 		paramInfoTemp.accurative = 0;
 		paramInfoTemp.castingFunction = nullptr;
 
-		auto overloadingCandidates = make_shared<list<CandidateInfo>>();
+		auto overloadingCandidates = makeCompileShared<list<CandidateInfo>>();
 
 		// filter overloading functions by number of parameters
 		for (auto it = overloadingItems.begin(); it != overloadingItems.end(); ++it) {
@@ -1388,7 +1459,7 @@ namespace ffscript {
 				assignmentCompositeUnit = dynamic_pointer_cast<Function>(firstUnit);
 			}
 			else {
-				assignmentCompositeUnit = make_shared<CompositeConstrutorUnit>(assigments);
+				assignmentCompositeUnit = makeCompileShared<CompositeConstrutorUnit>(assigments);
 				// keep origin source char in new expression unit
 				assignmentCompositeUnit->setSourceCharIndex(firstUnit->getSourceCharIndex());
 			}
@@ -1412,7 +1483,7 @@ namespace ffscript {
 				assignmentCompositeUnit = dynamic_pointer_cast<Function>(firstUnit);
 			}
 			else {
-				assignmentCompositeUnit = make_shared<CompositeConstrutorUnit>(assigments);
+				assignmentCompositeUnit = makeCompileShared<CompositeConstrutorUnit>(assigments);
 				// keep origin source char in new expression unit
 				assignmentCompositeUnit->setSourceCharIndex(firstUnit->getSourceCharIndex());
 			}
@@ -1454,7 +1525,7 @@ namespace ffscript {
 		}
 
 		if (unit->getType() == EXP_UNIT_ID_DYNAMIC_FUNC) {
-			auto assignmentCompositeUnit = make_shared<CompositeConstrutorUnit>();
+			auto assignmentCompositeUnit = makeCompileShared<CompositeConstrutorUnit>();
 			// keep origin source char in new expression unit
 			assignmentCompositeUnit->setSourceCharIndex(unit->getSourceCharIndex());
 
@@ -1986,12 +2057,11 @@ namespace ffscript {
 	}
 
 	template <class Container>
-	void simpleFilter(ScriptCompiler* scriptCompiler, const Container& parameterUnits, list<CandidateInfo>& overloadingCandidates, bool forToSearchMatchingLevel2) {
+	void simpleFilter(ScriptCompiler* scriptCompiler, const Container& parameterUnits, list<CandidateInfo>& overloadingCandidates, bool forToSearchMatchingLevel2, int overloadingSize) {
 		ScriptType refVoidType(scriptCompiler->getTypeManager()->getBasicTypes().TYPE_VOID | DATA_TYPE_POINTER_MASK, "ref void");
 
 		auto pit = parameterUnits.begin();
 		int n = (int)parameterUnits.size();
-		int overloadingSize = (int)overloadingCandidates.size();
 		for (int i = 0; i < n ; i++, pit++) {
 			auto& param = *pit;
 			auto& paramType = param->getReturnType();
@@ -2020,6 +2090,68 @@ namespace ffscript {
 		}
 	}
 
+	void ScriptCompiler::clearResolutionCache() {
+		std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
+		_castingFunctionCache.clear();
+		_candidateFilterCache.clear();
+	}
+
+	void ScriptCompiler::filterCandidatesForPath(const list<OverLoadingItem>* overloadingFuncs, const std::vector<ExecutableUnitRef>& path,
+		const list<CandidateInfo>& originCandidates, list<CandidateInfo>& overloadingCandidates, bool forToSearchMatchingLevel2) {
+		int overloadingSize = (int)originCandidates.size();
+
+		// build the key from the overloading functions and the parameter types
+		// parameters which are composite values cannot be cached because matching them depends on their elements.
+		// Matching through temporary variables needs a scope, so only the results filtered in a scope are cached
+		std::string key;
+		if (currentScope()) {
+			key = std::to_string((size_t)overloadingFuncs) + (forToSearchMatchingLevel2 ? "|2" : "|1");
+		}
+		for (size_t i = 0; i < path.size() && key.size(); i++) {
+			auto& param = path[i];
+			if (param->getType() == EXP_UNIT_ID_DYNAMIC_FUNC) {
+				key.clear();
+				break;
+			}
+			auto& paramType = param->getReturnType();
+			key.append("|" + std::to_string(paramType.iType()) + paramType.sType());
+		}
+
+		// the cache is shared by the threads which extract function bodies in parallel,
+		// so the matched ids are copied while the cache is locked
+		bool cached = false;
+		vector<int> matchedIds;
+		if (key.size()) {
+			std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
+			auto cit = _candidateFilterCache.find(key);
+			if (cit != _candidateFilterCache.end()) {
+				matchedIds = cit->second;
+				cached = true;
+			}
+		}
+		if (cached) {
+			// only the candidates that matched before need to be checked again to build their casting functions
+			for (auto& candidate : originCandidates) {
+				if (std::find(matchedIds.begin(), matchedIds.end(), candidate.item->functionId) != matchedIds.end()) {
+					overloadingCandidates.push_back(candidate);
+				}
+			}
+			simpleFilter(this, path, overloadingCandidates, forToSearchMatchingLevel2, overloadingSize);
+			return;
+		}
+
+		overloadingCandidates = originCandidates;
+		simpleFilter(this, path, overloadingCandidates, forToSearchMatchingLevel2, overloadingSize);
+
+		if (key.size()) {
+			for (auto& candidate : overloadingCandidates) {
+				matchedIds.push_back(candidate.item->functionId);
+			}
+			std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
+			_candidateFilterCache[key].swap(matchedIds);
+		}
+	}
+
 	CandidateCollectionRef ScriptCompiler::filterCandidate(
 		const string& functionName, int functionType,
 		const list<OverLoadingItem>* overloadingFuncs,
@@ -2073,8 +2205,8 @@ namespace ffscript {
 				}
 			}
 
-			list<CandidateInfo> overloadingCandidates = overloadingCandidatesOrigin;
-			simpleFilter(this, path, overloadingCandidates, false);
+			list<CandidateInfo> overloadingCandidates;
+			filterCandidatesForPath(overloadingFuncs, path, overloadingCandidatesOrigin, overloadingCandidates, false);
 			if (overloadingCandidates.size() == 0) {
 				// when the code reach here, it means no operator found if we don't try to search matching level 2
 				if (functionType == EXP_UNIT_ID_OPERATOR_ASSIGNMENT) {
@@ -2089,8 +2221,8 @@ namespace ffscript {
 						continue;
 					}
 				}
-				overloadingCandidates = overloadingCandidatesOrigin;
-				simpleFilter(this, path, overloadingCandidates, true);
+				overloadingCandidates.clear();
+				filterCandidatesForPath(overloadingFuncs, path, overloadingCandidatesOrigin, overloadingCandidates, true);
 			}
 
 			//copy candidate to map but no duplicate candidate(function) id
@@ -2151,7 +2283,7 @@ namespace ffscript {
 		});
 
 		//everything is ok now, it's time to build candidates		
-		CandidateCollectionRef functionCandidates = std::make_shared<CandidateCollection>();
+		CandidateCollectionRef functionCandidates = makeCompileShared<CandidateCollection>();
 		for (auto it = candidateElems.begin(); it != candidateElems.end(); it++) {
 			FunctionFactory* fp = getFunctionFactory((*it)->first);
 			Function* f = fp->build(fp->getName());
@@ -2244,12 +2376,14 @@ namespace ffscript {
 		_typeManagerRef->beginUserTypes();
 
 		_systemLibMarkEnd = (LibraryMarkInfoRef)(new LibraryMarkInfo);
-		_systemLibMarkEnd->functionIdx = (int)_functionFactories.size();		
+		_systemLibMarkEnd->functionIdx = (int)_functionFactories.size();
+		_systemLibMarkEnd->argumentTypes = _argumentTypesCache;
 	}
 
 	void ScriptCompiler::clearUserLib() {
 		_functionLibRef->clearUserLib();
 		_typeManagerRef->clearUserTypes();
+		clearResolutionCache();
 
 		if (_systemLibMarkEnd) {
 
@@ -2258,6 +2392,8 @@ namespace ffscript {
 			}
 
 			_functionFactories.resize(_systemLibMarkEnd->functionIdx);
+			// parsed arguments may refer to the user types, only the ones parsed before the mark are kept
+			_argumentTypesCache.swap(_systemLibMarkEnd->argumentTypes);
 			_systemLibMarkEnd.reset();
 		}
 	}
@@ -2347,6 +2483,7 @@ namespace ffscript {
 	}
 
 	const wchar_t* ScriptCompiler::parseFunctionType(const wchar_t* text, const wchar_t* end, ScriptType& returnType, std::list<ScriptType>& argTypes, bool& isDynamicFunction) {
+		std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
 		auto c = trimLeft(text, end);
 		if (*c != '<') return nullptr;
 		c = readType(c + 1, end, returnType);
@@ -2539,6 +2676,7 @@ namespace ffscript {
 	}
 
 	bool ScriptCompiler::parseFunctionType(int type, ScriptType& returnType, std::list<ScriptType>& argTypes, bool& isDynamicFunction) {
+		std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
 		std::string stype = getType(type);
 		std::wstring wstype(stype.begin(), stype.end());
 		const wchar_t* text = wstype.data();
@@ -2618,6 +2756,7 @@ namespace ffscript {
 	}
 
 	const wchar_t* ScriptCompiler::readType(const wchar_t* text, const wchar_t* end, ScriptType& stype) {
+		std::lock_guard<std::recursive_mutex> lock(_sharedStateLock);
 		const wchar_t* d = trimLeft(text, end);
 		const wchar_t* e = d;
 		const wchar_t* c;
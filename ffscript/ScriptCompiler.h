@@ -24,10 +24,12 @@
 
 #include <stack>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <vector>
 #include <list>
 #include <memory>
+#include <mutex>
 
 #define CONDITIONAL_FUNCTION "_SYSTEM_FUNCTION_CONDITIONAL"
 #define LOG_COMPILE_MESSAGE(logger, type, message) if(logger) logger->log(type, message)
@@ -92,29 +94,39 @@ namespace ffscript {
 
 		stack<ScriptScope*> _scopeStack;
 		vector<FunctionFactory*> _functionFactories;
-		map<string, EKeyword > _keywordMap;
+		unordered_map<string, EKeyword > _keywordMap;
 		list<FunctionFactoryRef> _factoriesStorage;
 		TypeCompatibilityMap _typeConversionMap;
-		typedef std::map<string, OperatorEntry*>  OperatorMap;
+		typedef std::unordered_map<string, OperatorEntry*>  OperatorMap;
 		OperatorMap _preCompileOperators; /*map operator name to operator information, pre-defined operator is only allow type overloading, not param count overloading*/
 		map<int, int> _constructorMap;
 		map<int, int> _destructorMap;
 		map<int, BinaryFunctionParamMapRef> _copyConstructorMap;
 		map<int, ConstructorIDListRef> _constructorsMap; // map a data type to its constructor list
-		map<string, TemplateRef> _templates;
-		map<string, DelegateRef> _constantMap;
+		unordered_map<string, TemplateRef> _templates;
+		unordered_map<string, DelegateRef> _constantMap;
 		map<int, int> _functionCallMap;
+		// resolution caches, they are cleared when the function library is changed
+		unordered_map<string, int> _castingFunctionCache; /*map source and target types to casting function id*/
+		unordered_map<string, vector<int>> _candidateFilterCache; /*map overloading functions and parameter types to ids of matched functions*/
+		unordered_map<string, vector<ScriptType>> _argumentTypesCache; /*map argument strings such as "int,float&" to parsed types*/
 
 		Program* _program;
 		CompilationLogger* _logger;
 
 		struct LibraryMarkInfo {
-			int functionIdx;			
+			int functionIdx;
+			unordered_map<string, vector<ScriptType>> argumentTypes;
 		};
 		typedef std::shared_ptr<LibraryMarkInfo> LibraryMarkInfoRef;
 		LibraryMarkInfoRef _systemLibMarkEnd;
 
+		// the compiler whose system library is shared with this compiler, it owns the shared function factories
+		std::shared_ptr<ScriptCompiler> _systemLibCompiler;
+
 		std::string _lastError;
+		// guards the compiler state which may be changed while function bodies are extracted in parallel
+		std::recursive_mutex _sharedStateLock;
 		std::vector<wchar_t> _messageBuffer;
 
 		int _refFunctionId = -1;
@@ -124,6 +136,10 @@ namespace ffscript {
 		
 	public:
 		ScriptCompiler();
+		// create a compiler from a compiler which contains a system library only.
+		// The function factories of the system library are shared, the lookup tables are copied
+		// so the new compiler can register its own types and functions independently
+		ScriptCompiler(const std::shared_ptr<ScriptCompiler>& systemLibCompiler);
 		virtual ~ScriptCompiler();
 
 		void setErrorText(const std::string& errorMsg);
@@ -170,6 +186,8 @@ namespace ffscript {
 		int findFunction(const std::string& name, const std::string& sargs);
 		int findDynamicFunctionOnly(const std::string& name);
 		int findFunction(const std::string& name, const std::vector<ScriptType>& paramTypes);
+		// parse an argument string such as "int,float&", return nullptr if the string contains an unknown type
+		const std::vector<ScriptType>* getArgumentTypes(const std::string& sargs);
 		FunctionFactory* getFunctionFactory(int functionId) const;
 		 
 		bool registerTypeConversionAccurative(int sourceType, int targetType, int accurative);
@@ -219,6 +237,9 @@ namespace ffscript {
 			const ExecutableUnitRef& secondOperand, list<pair<Variable*,
 			ExecutableUnitRef>>&assigments, int& accurative);
 
+		void filterCandidatesForPath(const list<OverLoadingItem>* overloadingFuncs, const std::vector<ExecutableUnitRef>& path,
+			const list<CandidateInfo>& originCandidates, list<CandidateInfo>& overloadingCandidates, bool forToSearchMatchingLevel2);
+		void clearResolutionCache();
 		CandidateCollectionRef filterCandidate(const string& functionName, int functionType,
 			const list<OverLoadingItem>* overloadingFuncs,
 			const std::vector<CandidateCollectionRef>& candidatesForParams, EExpressionResult& eResult);
@@ -0,0 +1,228 @@
+/******************************************************************
+* File:        ScriptLexer.cpp
+* Description: implement ScriptLexer class. A class used to classify
+*              whitespace, identifier, number and punctuation runs of
+*              script code. Runs are scanned with SSE2 instructions
+*              where they are available and one character at a time
+*              otherwise.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ScriptLexer.h"
+#include <atomic>
+
+#ifdef FFSCRIPT_SIMD_LEXER
+#include <emmintrin.h>
+#if _WIN32 || _WIN64
+#include <intrin.h>
+#endif
+#endif
+
+namespace ffscript {
+
+	// the switch is shared by the lexers of all threads
+	static std::atomic<bool> _simdEnabled(true);
+
+	static inline bool isSpaceChar(wchar_t c) {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+	static inline bool isIdentifierChar(wchar_t c) {
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+	}
+
+	static inline bool isDigitChar(wchar_t c) {
+		return c >= '0' && c <= '9';
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	/// scalar scanners
+	///////////////////////////////////////////////////////////////////////////
+	static const wchar_t* skipSpacesScalar(const wchar_t* c, const wchar_t* end) {
+		while (c < end && isSpaceChar(*c)) c++;
+		return c;
+	}
+
+	static const wchar_t* skipIdentifierScalar(const wchar_t* c, const wchar_t* end) {
+		while (c < end && isIdentifierChar(*c)) c++;
+		return c;
+	}
+
+	static const wchar_t* skipIdentifierOrDotScalar(const wchar_t* c, const wchar_t* end) {
+		while (c < end && (isIdentifierChar(*c) || *c == '.')) c++;
+		return c;
+	}
+
+	static const wchar_t* skipDigitsScalar(const wchar_t* c, const wchar_t* end) {
+		while (c < end && isDigitChar(*c)) c++;
+		return c;
+	}
+
+	static const wchar_t* findEitherScalar(const wchar_t* c, const wchar_t* end, wchar_t c1, wchar_t c2) {
+		while (c < end && *c != c1 && *c != c2) c++;
+		return c;
+	}
+
+#ifdef FFSCRIPT_SIMD_LEXER
+	///////////////////////////////////////////////////////////////////////////
+	/// SSE2 scanners, wchar_t is 16 bits on Windows and 32 bits on the others
+	///////////////////////////////////////////////////////////////////////////
+	template <int charSize>
+	struct SimdLane;
+
+	template <>
+	struct SimdLane<2> {
+		static inline __m128i set(int c) { return _mm_set1_epi16((short)c); }
+		static inline __m128i equal(__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); }
+		// characters from 0x8000 are negative here, so they are out of all ASCII ranges
+		static inline __m128i greater(__m128i a, __m128i b) { return _mm_cmpgt_epi16(a, b); }
+	};
+
+	template <>
+	struct SimdLane<4> {
+		static inline __m128i set(int c) { return _mm_set1_epi32(c); }
+		static inline __m128i equal(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+		static inline __m128i greater(__m128i a, __m128i b) { return _mm_cmpgt_epi32(a, b); }
+	};
+
+	typedef SimdLane<sizeof(wchar_t)> Lane;
+	static const int CHARS_PER_BLOCK = (int)(sizeof(__m128i) / sizeof(wchar_t));
+
+	static inline int firstBit(unsigned int mask) {
+#if _WIN32 || _WIN64
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (int)index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	static inline __m128i inRange(__m128i chars, int low, int high) {
+		return _mm_and_si128(Lane::greater(chars, Lane::set(low - 1)), Lane::greater(Lane::set(high + 1), chars));
+	}
+
+	struct SpaceClass {
+		static inline __m128i match(__m128i chars) {
+			__m128i m = _mm_or_si128(Lane::equal(chars, Lane::set(' ')), Lane::equal(chars, Lane::set('\t')));
+			return _mm_or_si128(m, _mm_or_si128(Lane::equal(chars, Lane::set('\r')), Lane::equal(chars, Lane::set('\n'))));
+		}
+		static inline bool match(wchar_t c) { return isSpaceChar(c); }
+	};
+
+	struct IdentifierClass {
+		static inline __m128i match(__m128i chars) {
+			// setting bit 5 maps upper case letters to lower case ones
+			__m128i letters = inRange(_mm_or_si128(chars, Lane::set(0x20)), 'a', 'z');
+			__m128i m = _mm_or_si128(letters, inRange(chars, '0', '9'));
+			return _mm_or_si128(m, Lane::equal(chars, Lane::set('_')));
+		}
+		static inline bool match(wchar_t c) { return isIdentifierChar(c); }
+	};
+
+	struct IdentifierOrDotClass {
+		static inline __m128i match(__m128i chars) {
+			return _mm_or_si128(IdentifierClass::match(chars), Lane::equal(chars, Lane::set('.')));
+		}
+		static inline bool match(wchar_t c) { return isIdentifierChar(c) || c == '.'; }
+	};
+
+	struct DigitClass {
+		static inline __m128i match(__m128i chars) {
+			return inRange(chars, '0', '9');
+		}
+		static inline bool match(wchar_t c) { return isDigitChar(c); }
+	};
+
+	// return first character which does not belong to the character class
+	template <class CharClass>
+	static const wchar_t* skipRunSimd(const wchar_t* c, const wchar_t* end) {
+		// short runs are the common case, check the first character before loading a block
+		if (c < end && !CharClass::match(*c)) return c;
+
+		while (end - c >= CHARS_PER_BLOCK) {
+			__m128i chars = _mm_loadu_si128((const __m128i*)c);
+			unsigned int mask = (~(unsigned int)_mm_movemask_epi8(CharClass::match(chars))) & 0xFFFF;
+			if (mask) {
+				return c + firstBit(mask) / sizeof(wchar_t);
+			}
+			c += CHARS_PER_BLOCK;
+		}
+		while (c < end && CharClass::match(*c)) c++;
+		return c;
+	}
+
+	static const wchar_t* findEitherSimd(const wchar_t* c, const wchar_t* end, wchar_t c1, wchar_t c2) {
+		__m128i v1 = Lane::set(c1);
+		__m128i v2 = Lane::set(c2);
+		while (end - c >= CHARS_PER_BLOCK) {
+			__m128i chars = _mm_loadu_si128((const __m128i*)c);
+			unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(Lane::equal(chars, v1), Lane::equal(chars, v2)));
+			if (mask) {
+				return c + firstBit(mask) / sizeof(wchar_t);
+			}
+			c += CHARS_PER_BLOCK;
+		}
+		return findEitherScalar(c, end, c1, c2);
+	}
+#endif // FFSCRIPT_SIMD_LEXER
+
+	///////////////////////////////////////////////////////////////////////////
+	/// ScriptLexer
+	///////////////////////////////////////////////////////////////////////////
+	const wchar_t* ScriptLexer::skipSpaces(const wchar_t* begin, const wchar_t* end) {
+#ifdef FFSCRIPT_SIMD_LEXER
+		if (_simdEnabled.load(std::memory_order_relaxed)) return skipRunSimd<SpaceClass>(begin, end);
+#endif
+		return skipSpacesScalar(begin, end);
+	}
+
+	const wchar_t* ScriptLexer::skipIdentifier(const wchar_t* begin, const wchar_t* end) {
+#ifdef FFSCRIPT_SIMD_LEXER
+		if (_simdEnabled.load(std::memory_order_relaxed)) return skipRunSimd<IdentifierClass>(begin, end);
+#endif
+		return skipIdentifierScalar(begin, end);
+	}
+
+	const wchar_t* ScriptLexer::skipIdentifierOrDot(const wchar_t* begin, const wchar_t* end) {
+#ifdef FFSCRIPT_SIMD_LEXER
+		if (_simdEnabled.load(std::memory_order_relaxed)) return skipRunSimd<IdentifierOrDotClass>(begin, end);
+#endif
+		return skipIdentifierOrDotScalar(begin, end);
+	}
+
+	const wchar_t* ScriptLexer::skipDigits(const wchar_t* begin, const wchar_t* end) {
+#ifdef FFSCRIPT_SIMD_LEXER
+		if (_simdEnabled.load(std::memory_order_relaxed)) return skipRunSimd<DigitClass>(begin, end);
+#endif
+		return skipDigitsScalar(begin, end);
+	}
+
+	const wchar_t* ScriptLexer::findEither(const wchar_t* begin, const wchar_t* end, wchar_t c1, wchar_t c2) {
+#ifdef FFSCRIPT_SIMD_LEXER
+		if (_simdEnabled.load(std::memory_order_relaxed)) return findEitherSimd(begin, end, c1, c2);
+#endif
+		return findEitherScalar(begin, end, c1, c2);
+	}
+
+	const wchar_t* ScriptLexer::findChar(const wchar_t* begin, const wchar_t* end, wchar_t c) {
+		return findEither(begin, end, c, c);
+	}
+
+	void ScriptLexer::setSimdEnabled(bool enabled) {
+		_simdEnabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool ScriptLexer::isSimdEnabled() {
+#ifdef FFSCRIPT_SIMD_LEXER
+		return _simdEnabled.load(std::memory_order_relaxed);
+#else
+		return false;
+#endif
+	}
+}
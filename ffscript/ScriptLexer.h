@@ -0,0 +1,44 @@
+/******************************************************************
+* File:        ScriptLexer.h
+* Description: declare ScriptLexer class. A class used to classify
+*              whitespace, identifier, number and punctuation runs of
+*              script code. Runs are scanned with SSE2 instructions
+*              where they are available and one character at a time
+*              otherwise.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+
+#if !defined(FFSCRIPT_NO_SIMD_LEXER) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define FFSCRIPT_SIMD_LEXER 1
+#endif
+
+namespace ffscript {
+
+	class FFSCRIPT_API ScriptLexer
+	{
+	public:
+		// return first character which is not a space, tab or new line character
+		static const wchar_t* skipSpaces(const wchar_t* begin, const wchar_t* end);
+		// return first character which is not a letter, a digit or '_'
+		static const wchar_t* skipIdentifier(const wchar_t* begin, const wchar_t* end);
+		// same as skipIdentifier but '.' is also accepted
+		static const wchar_t* skipIdentifierOrDot(const wchar_t* begin, const wchar_t* end);
+		// return first character which is not a digit
+		static const wchar_t* skipDigits(const wchar_t* begin, const wchar_t* end);
+		// return first character which is c1 or c2, end if there is no such character
+		static const wchar_t* findEither(const wchar_t* begin, const wchar_t* end, wchar_t c1, wchar_t c2);
+		static const wchar_t* findChar(const wchar_t* begin, const wchar_t* end, wchar_t c);
+
+		// the scalar functions are used instead of SIMD ones if SIMD is disabled
+		static void setSimdEnabled(bool enabled);
+		static bool isSimdEnabled();
+	};
+}
@@ -0,0 +1,235 @@
+/******************************************************************
+* File:        ScriptProfiler.cpp
+* Description: implement ScriptProfiler class. A sampling profiler
+*              for script code. A background thread requests samples
+*              of the call stacks of the attached contexts, the
+*              samples are reported as folded stacks and a table of
+*              self and total time of the script functions.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ScriptProfiler.h"
+#include "Context.h"
+#include "Program.h"
+#include "ScriptCompiler.h"
+#include "DebugInfo.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+namespace ffscript {
+
+	static const char* UNKNOWN_FUNCTION_NAME = "[unknown]";
+
+	ScriptProfiler::ScriptProfiler(Program* program, ScriptCompiler* scriptCompiler) :
+		_program(program),
+		_scriptCompiler(scriptCompiler),
+		_sampleCount(0),
+		_interval(1000),
+		_running(false)
+	{
+		loadFunctions();
+	}
+
+	ScriptProfiler::~ScriptProfiler() {
+		stop();
+		// a context records its samples while it holds its profiler lock and then this lock,
+		// so the contexts are detached after this lock is released
+		std::set<Context*> contexts;
+		{
+			std::unique_lock<std::mutex> lk(_mutex);
+			contexts.swap(_contexts);
+		}
+		for (auto context : contexts) {
+			context->setProfiler(nullptr);
+		}
+	}
+
+	void ScriptProfiler::loadFunctions() {
+		_functionNames.push_back(UNKNOWN_FUNCTION_NAME);
+		_functionLines.push_back(-1);
+
+		auto debugInfo = _program->getDebugInfo();
+		auto& functionCodes = _program->getFunctionPlainCodes();
+		for (auto it = functionCodes.begin(); it != functionCodes.end(); ++it) {
+			auto factory = _scriptCompiler->getFunctionFactory(it->first);
+			FunctionRange functionRange;
+			functionRange.begin = it->second.first;
+			functionRange.end = it->second.second;
+			functionRange.nameIndex = (int)_functionNames.size();
+			_functionNames.push_back(factory ? factory->getFullFuntionName() : "function" + std::to_string(it->first));
+			_functionRanges.push_back(functionRange);
+
+			int line = -1;
+			for (auto command = functionRange.begin; debugInfo && command <= functionRange.end && line < 0; command++) {
+				auto position = debugInfo->getSourcePosition(command);
+				if (position) line = position->line;
+			}
+			_functionLines.push_back(line);
+		}
+
+		std::sort(_functionRanges.begin(), _functionRanges.end(), [](const FunctionRange& range1, const FunctionRange& range2) {
+			return range1.begin < range2.begin;
+		});
+	}
+
+	int ScriptProfiler::findFunction(CommandPointer command) const {
+		auto it = std::upper_bound(_functionRanges.begin(), _functionRanges.end(), command, [](CommandPointer command, const FunctionRange& range) {
+			return command < range.begin;
+		});
+		if (it == _functionRanges.begin()) {
+			return 0;
+		}
+		--it;
+		return command <= it->end ? it->nameIndex : 0;
+	}
+
+	void ScriptProfiler::attach(Context* context) {
+		{
+			std::unique_lock<std::mutex> lk(_mutex);
+			_contexts.insert(context);
+		}
+		context->setProfiler(this);
+	}
+
+	void ScriptProfiler::detach(Context* context) {
+		bool attached;
+		{
+			std::unique_lock<std::mutex> lk(_mutex);
+			attached = _contexts.erase(context) > 0;
+		}
+		if (attached) {
+			context->setProfiler(nullptr);
+		}
+	}
+
+	void ScriptProfiler::start(int interval) {
+		stop();
+		_interval = interval > 0 ? interval : 1;
+		_running = true;
+		_samplerThread = std::thread(&ScriptProfiler::sample, this);
+	}
+
+	void ScriptProfiler::stop() {
+		{
+			std::unique_lock<std::mutex> lk(_mutex);
+			_running = false;
+		}
+		_stopCondition.notify_all();
+		if (_samplerThread.joinable()) {
+			_samplerThread.join();
+		}
+	}
+
+	bool ScriptProfiler::isRunning() const {
+		std::unique_lock<std::mutex> lk(_mutex);
+		return _running;
+	}
+
+	void ScriptProfiler::sample() {
+		std::unique_lock<std::mutex> lk(_mutex);
+		while (_running) {
+			_stopCondition.wait_for(lk, std::chrono::microseconds(_interval));
+			if (!_running) break;
+			for (auto context : _contexts) {
+				context->requestSample();
+			}
+		}
+	}
+
+	void ScriptProfiler::clear() {
+		std::unique_lock<std::mutex> lk(_mutex);
+		_stacks.clear();
+		_sampleCount = 0;
+	}
+
+	int ScriptProfiler::getSampleCount() const {
+		std::unique_lock<std::mutex> lk(_mutex);
+		return _sampleCount;
+	}
+
+	void ScriptProfiler::recordSample(Context* context) {
+		std::vector<int> stack;
+#if FFSCRIPT_INSTRUMENTATION
+		auto& callFrames = context->getCallFrames();
+		stack.reserve(callFrames.getSize());
+		for (auto it = callFrames.begin(); it != callFrames.end(); ++it) {
+			stack.push_back(findFunction(*it));
+		}
+#else
+		// the contexts do not track their call frames, so the sample is not attributed to a function
+		(void)context;
+#endif
+		if (stack.empty()) {
+			stack.push_back(0);
+		}
+
+		std::unique_lock<std::mutex> lk(_mutex);
+		_stacks[stack]++;
+		_sampleCount++;
+	}
+
+	void ScriptProfiler::writeFoldedStacks(std::ostream& os) const {
+		std::unique_lock<std::mutex> lk(_mutex);
+		for (auto it = _stacks.begin(); it != _stacks.end(); ++it) {
+			auto& stack = it->first;
+			for (size_t i = 0; i < stack.size(); i++) {
+				if (i) os << ';';
+				os << _functionNames[stack[i]];
+			}
+			os << ' ' << it->second << std::endl;
+		}
+	}
+
+	void ScriptProfiler::writeFunctionTable(std::ostream& os) const {
+		std::unique_lock<std::mutex> lk(_mutex);
+		std::vector<int> selfSamples(_functionNames.size(), 0);
+		std::vector<int> totalSamples(_functionNames.size(), 0);
+		std::vector<char> counted(_functionNames.size(), 0);
+		for (auto it = _stacks.begin(); it != _stacks.end(); ++it) {
+			auto& stack = it->first;
+			selfSamples[stack.back()] += it->second;
+			// a recursive function is counted once for a sample
+			for (int nameIndex : stack) {
+				if (counted[nameIndex]) continue;
+				counted[nameIndex] = 1;
+				totalSamples[nameIndex] += it->second;
+			}
+			for (int nameIndex : stack) {
+				counted[nameIndex] = 0;
+			}
+		}
+
+		std::vector<int> functions;
+		for (int i = 0; i < (int)_functionNames.size(); i++) {
+			if (totalSamples[i]) functions.push_back(i);
+		}
+		std::sort(functions.begin(), functions.end(), [&](int function1, int function2) {
+			if (selfSamples[function1] != selfSamples[function2]) {
+				return selfSamples[function1] > selfSamples[function2];
+			}
+			return totalSamples[function1] > totalSamples[function2];
+		});
+
+		double sampleTime = _interval / 1000.0;
+		os << "function\tself samples\ttotal samples\tself(ms)\ttotal(ms)\tline" << std::endl;
+		os << std::fixed << std::setprecision(3);
+		for (int function : functions) {
+			os << _functionNames[function] << '\t' << selfSamples[function] << '\t' << totalSamples[function] << '\t'
+				<< selfSamples[function] * sampleTime << '\t' << totalSamples[function] * sampleTime << '\t';
+			// lines are written one based
+			if (_functionLines[function] >= 0) {
+				os << _functionLines[function] + 1;
+			}
+			else {
+				os << '-';
+			}
+			os << std::endl;
+		}
+	}
+}
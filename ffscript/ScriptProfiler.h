@@ -0,0 +1,86 @@
+/******************************************************************
+* File:        ScriptProfiler.h
+* Description: declare ScriptProfiler class. A sampling profiler for
+*              script code. A background thread requests samples of
+*              the call stacks of the attached contexts, the samples
+*              are reported as folded stacks and a table of self and
+*              total time of the script functions.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace ffscript {
+
+	class Context;
+	class Program;
+	class ScriptCompiler;
+
+	class FFSCRIPT_API ScriptProfiler
+	{
+		struct FunctionRange {
+			CommandPointer begin;
+			CommandPointer end;
+			int nameIndex;
+		};
+
+		Program* _program;
+		ScriptCompiler* _scriptCompiler;
+		std::vector<FunctionRange> _functionRanges;
+		std::vector<std::string> _functionNames;
+		// zero based line of the first expression of each function, -1 if the program has no debug info
+		std::vector<int> _functionLines;
+		// sampled stacks, the outermost function is the first element
+		std::map<std::vector<int>, int> _stacks;
+		int _sampleCount;
+		int _interval;
+		std::set<Context*> _contexts;
+		bool _running;
+		std::thread _samplerThread;
+		mutable std::mutex _mutex;
+		std::condition_variable _stopCondition;
+	private:
+		void loadFunctions();
+		int findFunction(CommandPointer command) const;
+		void sample();
+	public:
+		// the profiler must be created after the program is compiled
+		ScriptProfiler(Program* program, ScriptCompiler* scriptCompiler);
+		// stop sampling and detach the contexts, it waits for the samples which are being recorded
+		virtual ~ScriptProfiler();
+
+		// the contexts are sampled while they run script functions. The contexts track their call
+		// frames only if the library is built with FFSCRIPT_INSTRUMENTATION, no sample is taken otherwise
+		void attach(Context* context);
+		void detach(Context* context);
+
+		// start sampling the attached contexts at the given interval, in microseconds
+		void start(int interval = 1000);
+		void stop();
+		bool isRunning() const;
+		void clear();
+		int getSampleCount() const;
+		// called by a context when it runs the next command after a sample is requested
+		void recordSample(Context* context);
+
+		// one line per sampled stack, functions are separated by ';' and followed by the sample count
+		void writeFoldedStacks(std::ostream& os) const;
+		// self and total samples and time of each sampled function, the most expensive function is the first.
+		// The line of the function is written if the program has the debug info
+		void writeFunctionTable(std::ostream& os) const;
+	};
+}
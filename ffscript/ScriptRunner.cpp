@@ -16,15 +16,17 @@
 #include "Context.h"
 #include "Program.h"
 #include "InstructionCommand.h"
+#include <stdexcept>
+#include <string>
+#include <memory>
 
 namespace ffscript {
 	static const int s_returnOffset = SCRIPT_FUNCTION_RETURN_STORAGE_OFFSET;
 
-	ScriptRunner::ScriptRunner(Program* program, int functionId) : _program(program), _functionInfo(nullptr)
+	ScriptRunner::ScriptRunner(Program* program, int functionId) : _program(program), _functionInfo(nullptr), _functionId(functionId),
+		_stackSize(-1), _stackInfoVersion(-1), _codeVersion(-1)
 	{
 		_functionInfo = program->getFunctionInfo(functionId);
-		auto functionCode = program->getFunctionPlainCode(functionId);
-
 		int paramOffset = s_returnOffset + _functionInfo->returnStorageSize;
 
 #if USE_DIRECT_COPY_FOR_RETURN
@@ -39,8 +41,22 @@ namespace ffscript {
 		CallScriptFuntion* callScriptCommand = new CallScriptFuntion();
 		callScriptCommand.setCommandData(_resultSize, paramOffset, functionInfo->paramDataSize);
 #endif
-		callScriptCommand->setTargetCommand(functionCode->first);
 		_scriptInvoker = callScriptCommand;
+		updateTargetCommand();
+	}
+
+	void ScriptRunner::updateTargetCommand() {
+		// the function code is read again if a function of the program is reloaded
+		if (_codeVersion == _program->getCodeVersion()) {
+			return;
+		}
+		auto functionCode = _program->getFunctionPlainCode(_functionId);
+		if (functionCode == nullptr) {
+			// the function is not an entry function and it is not called by the script
+			throw std::runtime_error("function " + std::to_string(_functionId) + " has no code in the program");
+		}
+		((CallScriptFuntion2*)_scriptInvoker)->setTargetCommand(functionCode->first);
+		_codeVersion = _program->getCodeVersion();
 	}
 
 	ScriptRunner::~ScriptRunner(){
@@ -50,6 +66,12 @@ namespace ffscript {
 		auto context = Context::getCurrent();
 
 		Program* program = _program;
+		// the code of the program is not updated while the function is running
+		program->beginRun();
+		std::unique_ptr<Program, void(*)(Program*)> runScope(program, [](Program* p) {
+			p->endRun();
+		});
+		updateTargetCommand();
 
 		int paramOffset = s_returnOffset + _functionInfo->returnStorageSize;
 		if (paramBuffer != nullptr && _functionInfo->paramDataSize > 0) {
@@ -85,6 +107,18 @@ namespace ffscript {
 		context->scopeUnallocate(allocatedSize, 0);
 	}
 
+	int ScriptRunner::getStackSize() {
+		// the stack size is computed again if a function of the program is reloaded
+		if (_stackInfoVersion != _program->getStackInfoVersion()) {
+			_stackInfoVersion = _program->getStackInfoVersion();
+			int functionStackSize = _program->getFunctionStackSize(_functionId);
+			// the function frame begins after its return storage and its parameters
+			_stackSize = functionStackSize < 0 ? -1 :
+				s_returnOffset + _functionInfo->returnStorageSize + _functionInfo->paramDataSize + functionStackSize;
+		}
+		return _stackSize;
+	}
+
 	void* ScriptRunner::getTaskResult() {
 		auto context = Context::getCurrent();
 		if (_functionInfo->returnStorageSize > 0 && context) {
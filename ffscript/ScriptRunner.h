@@ -27,11 +27,19 @@ namespace ffscript {
 		Program* _program;
 		FunctionInfo* _functionInfo;
 		CallFuntion* _scriptInvoker;
+		int _functionId;
+		int _stackSize;
+		int _stackInfoVersion;
+		int _codeVersion;
+	private:
+		void updateTargetCommand();
 	public:
 		ScriptRunner(Program* program, int functionId);
 		virtual ~ScriptRunner();
 
 		virtual void runFunction(const ScriptParamBuffer* paramBuffer);
 		virtual void* getTaskResult();
+		// stack size needed to run the function, it is -1 if it cannot be determined at compile time
+		int getStackSize();
 	};
 }
@@ -13,6 +13,7 @@
 #include "ObjectBlock.hpp"
 #include "ExpUnitExecutor.h"
 #include "Program.h"
+#include <stdexcept>
 
 namespace ffscript {
 	ScriptScope::ScriptScope(ScriptCompiler* scriptCompiler) :
@@ -286,11 +287,11 @@ namespace ffscript {
 	bool ScriptScope::applyDestructor(const ExecutableUnitRef& variableUnit) {
 		auto xOperand = dynamic_cast<CXOperand*>(variableUnit.get());
 		if (!xOperand) {
-			throw runtime_error("expression unit is not a variable");
+			throw std::runtime_error("expression unit is not a variable");
 		}
 		auto pVariable = xOperand->getVariable();
 		if (!pVariable) {
-			throw runtime_error("null variable");
+			throw std::runtime_error("null variable");
 		}
 
 		return checkVariableToRunDestructor(xOperand);
@@ -442,6 +443,16 @@ namespace ffscript {
 	void ScriptScope::addChild(ScriptScope* child) {
 		_children.push_back(ScriptScopeRef(child));
 	}
+	ScriptScopeRef ScriptScope::detachChild(ScriptScope* child) {
+		for (auto it = _children.begin(); it != _children.end(); ++it) {
+			if (it->get() == child) {
+				ScriptScopeRef childRef = *it;
+				_children.erase(it);
+				return childRef;
+			}
+		}
+		return nullptr;
+	}
 	const ScopeRefList& ScriptScope::getChildren() const {
 		return _children;
 	}
@@ -482,4 +493,13 @@ namespace ffscript {
 		_dataSize = 0;
 		_commandBuilder.clear();
 	}
+
+	void ScriptScope::releaseCommandBuilders() {
+		_commandBuilder.clear();
+		_destructors.clear();
+		_variableUnitMap.clear();
+		for (auto& child : _children) {
+			child->releaseCommandBuilders();
+		}
+	}
 }
\ No newline at end of file
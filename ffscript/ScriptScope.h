@@ -14,6 +14,7 @@
 
 #pragma once
 #include <map>
+#include <unordered_map>
 #include <list>
 #include <string>
 #include <memory>
@@ -43,9 +44,9 @@ namespace ffscript {
 
 	class ScriptScope
 	{
-		typedef std::map<std::string, DFunction2Ref> KeywordProcessingMap;
+		typedef std::unordered_map<std::string, DFunction2Ref> KeywordProcessingMap;
 
-		std::map<std::string, Variable*> _variableNameMap;
+		std::unordered_map<std::string, Variable*> _variableNameMap;
 		std::map<CommandUnitBuilder*, std::shared_ptr<Variable>> _variableUnitMap;
 		KeywordProcessingMap _keywordProcessingMap;
 		std::list<Variable> _varibles;
@@ -99,6 +100,8 @@ namespace ffscript {
 		void setBaseOffset(int offset);
 		void allocate(int size);
 		virtual void addChild(ScriptScope* child);
+		// remove the child from the children list and return its reference
+		ScriptScopeRef detachChild(ScriptScope* child);
 		ScriptCompiler* getCompiler() const;
 
 	public:
@@ -109,6 +112,9 @@ namespace ffscript {
 		const ScopeRefList& getChildren() const;
 		void setParent(ScriptScope* parent);
 		void clear();
+		// release the command builders of the scope and its children after their code is extracted,
+		// the expression units they hold are not used by the extracted code
+		void releaseCommandBuilders();
 
 		//parser functions
 	protected:
@@ -19,10 +19,11 @@
 #include "Context.h"
 #include "Program.h"
 #include "InstructionCommand.h"
+#include "ScriptProfiler.h"
 
 namespace ffscript {
-	ScriptTask::ScriptTask(Program* program) : _program(program), _scriptContext(nullptr), _allocatedSize(0),
-		_scriptRunner(nullptr), _lastCallFunctionId(-1)
+	ScriptTask::ScriptTask(Program* program) : _scriptContext(nullptr), _allocatedSize(0), _scriptRunner(nullptr),
+		_program(program), _profiler(nullptr), _lastCallFunctionId(-1)
 	{
 	}
 
@@ -45,6 +46,12 @@ namespace ffscript {
 			_scriptRunner = new ScriptRunner(_program, functionId);
 			_lastCallFunctionId = functionId;
 		}
+		if (stackSize <= 0) {
+			stackSize = _scriptRunner->getStackSize();
+			if (stackSize < 0) {
+				stackSize = DEFAULT_TASK_STACK_SIZE;
+			}
+		}
 
 		if (_scriptContext == nullptr) {
 			_scriptContext = new Context(stackSize);
@@ -54,21 +61,48 @@ namespace ffscript {
 			_scriptContext = new Context(stackSize);
 			_allocatedSize = 0;
 		}
-		else
+		else if (_allocatedSize > 0)
 		{
+			// the runner releases its scope when the function returns, so only the memory
+			// allocated by the task is released here
 			_scriptContext->scopeUnallocate(_allocatedSize, 0);
 		}
 
+		if (_scriptContext->getProfiler() != _profiler) {
+			if (_scriptContext->getProfiler()) {
+				_scriptContext->getProfiler()->detach(_scriptContext);
+			}
+			if (_profiler) {
+				_profiler->attach(_scriptContext);
+			}
+		}
+		_scriptContext->setGlobalDataView(_globalDataView.get());
 		Context::makeCurrent(_scriptContext);
 		_scriptRunner->runFunction(paramBuffer);
 	}
 
 	void ScriptTask::runFunction(int functionId, const ScriptParamBuffer& paramBuffer) {
-		runFunction(1024 * 1024, functionId, &paramBuffer);
+		runFunction(0, functionId, &paramBuffer);
 	}
 
 	void ScriptTask::runFunction(int functionId, const ScriptParamBuffer* paramBuffer) {
-		runFunction(1024 * 1024, functionId, paramBuffer);
+		runFunction(0, functionId, paramBuffer);
+	}
+
+	void ScriptTask::setGlobalDataView(const GlobalDataViewRef& globalDataView) {
+		_globalDataView = globalDataView;
+	}
+
+	const GlobalDataViewRef& ScriptTask::getGlobalDataView() const {
+		return _globalDataView;
+	}
+
+	void ScriptTask::setProfiler(ScriptProfiler* profiler) {
+		_profiler = profiler;
+	}
+
+	ScriptProfiler* ScriptTask::getProfiler() const {
+		return _profiler;
 	}
 
 	void* ScriptTask::getTaskResult() {
@@ -19,11 +19,16 @@
 #include "ffscript.h"
 #include "ScriptParamBuffer.hpp"
 #include "ScriptRunner.h"
+#include "GlobalDataView.h"
+
+// stack size of a task whose function needs a stack size unknown at compile time
+#define DEFAULT_TASK_STACK_SIZE (1024 * 1024)
 
 namespace ffscript {
 
 	class Context;
 	class Program;
+	class ScriptProfiler;
 	struct FunctionInfo;
 
 	class ScriptTask
@@ -32,12 +37,17 @@ namespace ffscript {
 		int _allocatedSize;
 		ScriptRunner* _scriptRunner;
 		Program* _program;
+		GlobalDataViewRef _globalDataView;
+		ScriptProfiler* _profiler;
 
 		int _lastCallFunctionId;
 	public:
 		ScriptTask(Program* program);
 		virtual ~ScriptTask();
 
+		// the task allocates the stack size computed by the compiler for the function,
+		// or DEFAULT_TASK_STACK_SIZE if the function is recursive or calls function objects.
+		// A stack size which is zero or negative is computed in the same way
 		void runFunction(int functionId, const ScriptParamBuffer* paramBuffer);
 		void runFunction(int stackSize, int functionId, const ScriptParamBuffer* paramBuffer);
 		void runFunction(int functionId, const ScriptParamBuffer& paramBuffer);
@@ -45,5 +55,12 @@ namespace ffscript {
 		/*void runFunction2(int functionId, const SimpleVariantArray* params);
 		void runFunction2(int stackSize, int functionId, const SimpleVariantArray* params);*/
 		void* getTaskResult();
+		// the task reads and writes the global variables in the view instead of the global memory
+		// of the program. A view can be shared by the tasks which run in the same thread
+		void setGlobalDataView(const GlobalDataViewRef& globalDataView);
+		const GlobalDataViewRef& getGlobalDataView() const;
+		// sample the functions run by the task, the profiler must outlive the task
+		void setProfiler(ScriptProfiler* profiler);
+		ScriptProfiler* getProfiler() const;
 	};
 }
@@ -14,6 +14,9 @@
 #include "StaticContext.h"
 #include "function/DynamicFunction.h"
 #include "InstructionCommand.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <string.h>
 
 namespace ffscript {
 	StaticContext::StaticContext(unsigned char* threadData, int bufferSize) : Context(threadData, bufferSize) {}
@@ -38,6 +41,7 @@ namespace ffscript {
 		Context::makeCurrent(this);
 
 		for (auto it = commands.begin(); it != commands.end(); ++it) {
+			INSTRUMENT_CONTEXT(this, onCommand(*(*it)));
 			(*(*it))->execute();
 #ifndef THROW_EXCEPTION_ON_ERROR
 			if (isError()) {
@@ -50,7 +54,51 @@ namespace ffscript {
 		Context::makeCurrent(currentContext);
 	}
 
+	bool StaticContext::evaluateInitialData(const std::list<CommandPointer>& commands, std::vector<std::pair<int, int>> blocks) {
+		_initialDataBlocks.clear();
+		_initialData.clear();
+		auto currentContext = Context::getCurrent();
+		try {
+			runCommands(commands);
+		}
+		catch (std::exception&) {
+			Context::makeCurrent(currentContext);
+			return false;
+		}
+		if (isError()) {
+			return false;
+		}
+
+		// merge the adjacent blocks so the data is copied by as few memcpy as possible
+		std::sort(blocks.begin(), blocks.end());
+		for (auto& block : blocks) {
+			if (_initialDataBlocks.size() && _initialDataBlocks.back().first + _initialDataBlocks.back().second >= block.first) {
+				auto& lastBlock = _initialDataBlocks.back();
+				lastBlock.second = std::max(lastBlock.first + lastBlock.second, block.first + block.second) - lastBlock.first;
+			}
+			else {
+				_initialDataBlocks.push_back(block);
+			}
+		}
+
+		unsigned char* globalData = (unsigned char*)getAbsoluteAddress(getCurrentOffset());
+		for (auto& block : _initialDataBlocks) {
+			_initialData.insert(_initialData.end(), globalData + block.first, globalData + block.first + block.second);
+		}
+		return true;
+	}
+
+	int StaticContext::getInitialDataSize() const {
+		return (int)_initialData.size();
+	}
+
 	void StaticContext::run() {
+		unsigned char* globalData = (unsigned char*)getAbsoluteAddress(getCurrentOffset());
+		const unsigned char* initialData = _initialData.data();
+		for (auto& block : _initialDataBlocks) {
+			memcpy(globalData + block.first, initialData, block.second);
+			initialData += block.second;
+		}
 		runCommands(_globalCommands);
 	}
 
@@ -14,6 +14,7 @@
 #pragma once
 #include "Context.h"
 #include <list>
+#include <vector>
 #include <memory>
 
 namespace ffscript {
@@ -23,6 +24,10 @@ namespace ffscript {
 	protected:
 		std::list<CommandPointer> _globalCommands;
 		std::list<CommandPointer> _destructorCommands;
+		// blocks of global data which are initialized at compile time, a block
+		// is a pair of offset and size, the data of the blocks are packed in _initialData
+		std::vector<std::pair<int, int>> _initialDataBlocks;
+		std::vector<unsigned char> _initialData;
 
 		void runCommands(const std::list<CommandPointer>& commands);
 
@@ -32,6 +37,11 @@ namespace ffscript {
 		virtual ~StaticContext();
 		void addCommand(CommandPointer command);
 		void addDestructorCommand(CommandPointer command);
+		// run the commands once and keep the data they write to the given blocks as the
+		// initial data of the global memory. The global memory must be allocated before.
+		bool evaluateInitialData(const std::list<CommandPointer>& commands, std::vector<std::pair<int, int>> blocks);
+		int getInitialDataSize() const;
+		// copy the initial data to the global memory then run the global commands
 		virtual void run();
 		virtual void runDestructorCommands();
 	};
@@ -14,10 +14,13 @@
 #include "ScriptCompiler.h"
 
 namespace ffscript {
-	StructClass::StructClass(ScriptCompiler* scriptCompiler) : _scriptCompiler(scriptCompiler)
+	StructClass::StructClass(ScriptCompiler* scriptCompiler) : _memberInfoMapBuilt(false), _scriptCompiler(scriptCompiler)
 	{
 	}
-	StructClass::StructClass(ScriptCompiler* scriptCompiler, const std::string& name) : _scriptCompiler(scriptCompiler), _name(name)
+	StructClass::StructClass(ScriptCompiler* scriptCompiler, const std::string& name) : _name(name), _memberInfoMapBuilt(false), _scriptCompiler(scriptCompiler)
+	{
+	}
+	StructClass::StructClass(ScriptCompiler* scriptCompiler, const StructClass& other) : _name(other._name), _members(other._members), _memberInfoMapBuilt(false), _scriptCompiler(scriptCompiler)
 	{
 	}
 	StructClass::~StructClass()
@@ -46,20 +49,49 @@ namespace ffscript {
 
 	void StructClass::addMember(const ScriptType& type, const std::string& memberName) {
 		_members.push_back(std::make_pair(type, memberName));
+		_memberInfoMap.clear();
+		_memberInfoMapBuilt = false;
 	}
 
-	bool StructClass::getInfo(const std::string& memberName, MemberInfo& info) const {
+	void StructClass::buildMemberInfoMap() const {
+		MemberInfo info;
 		int size = 0;
 		for (auto& elm : _members) {
-			if (memberName == elm.second) {
-				info.offset = size;
-				info.type = elm.first;
-				return true;
-			}
+			info.offset = size;
+			info.type = elm.first;
+			// keep the first member if there are members with same name
+			_memberInfoMap.insert(std::make_pair(elm.second, info));
 			size += _scriptCompiler->getTypeSize(elm.first);
 		}
+	}
+
+	bool StructClass::getInfo(const std::string& memberName, MemberInfo& info) const {
+		if (!_memberInfoMapBuilt) {
+			std::lock_guard<std::mutex> lock(_memberInfoMapLock);
+			if (!_memberInfoMapBuilt) {
+				buildMemberInfoMap();
+				_memberInfoMapBuilt = true;
+			}
+		}
 
-		return false;
+		auto it = _memberInfoMap.find(memberName);
+		if (it == _memberInfoMap.end()) {
+			return false;
+		}
+		info = it->second;
+		return true;
+	}
+
+	void StructClass::getMemberInfos(std::vector<MemberInfo>& infos) const {
+		MemberInfo info;
+		int size = 0;
+		infos.reserve(_members.size());
+		for (auto& elm : _members) {
+			info.offset = size;
+			info.type = elm.first;
+			infos.push_back(info);
+			size += _scriptCompiler->getTypeSize(elm.first);
+		}
 	}
 
 	void StructClass::retreiveMemberInfo(std::string* memberName, MemberInfo* info) const {
@@ -13,7 +13,11 @@
 #pragma once
 #include <string>
 #include <list>
+#include <unordered_map>
 #include <memory>
+#include <vector>
+#include <atomic>
+#include <mutex>
 #include "ScriptType.h"
 
 namespace ffscript {
@@ -30,10 +34,17 @@ namespace ffscript {
 		std::list<std::pair<ScriptType, std::string>> _members;
 		mutable decltype(_members)::const_iterator _iterator;
 		mutable int _offset;
+		// member infos are cached by name when a member is looked up by name at first time
+		mutable std::unordered_map<std::string, MemberInfo> _memberInfoMap;
+		// the cache may be built by threads which extract code in parallel
+		mutable std::atomic<bool> _memberInfoMapBuilt;
+		mutable std::mutex _memberInfoMapLock;
 		ScriptCompiler* _scriptCompiler;
 	public:
 		StructClass(ScriptCompiler* scriptCompiler);
 		StructClass(ScriptCompiler* scriptCompiler, const std::string& name);
+		// copy name and members of other struct
+		StructClass(ScriptCompiler* scriptCompiler, const StructClass& other);
 		virtual ~StructClass();
 
 		int getSize() const;
@@ -44,9 +55,13 @@ namespace ffscript {
 		bool getInfo(const std::string& memberName, MemberInfo& info) const;
 		bool getMemberFirst(std::string* memberName, MemberInfo* info) const;
 		bool getMemberNext(std::string* memberName, MemberInfo* info) const;
+		// get member infos in declaring order, unlike getMemberFirst/getMemberNext
+		// it can be called by multiple threads at same time
+		void getMemberInfos(std::vector<MemberInfo>& infos) const;
 
 	protected:
 		void retreiveMemberInfo(std::string* memberName, MemberInfo* info) const;
+		void buildMemberInfoMap() const;
 
 	};
 
@@ -0,0 +1,76 @@
+/******************************************************************
+* File:        SystemLibrary.cpp
+* Description: implement SystemLibrary class. A class used to build
+*              the system library once and share it with compilers
+*              which compile user programs in different threads.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "SystemLibrary.h"
+#include "FunctionRegisterHelper.h"
+#include "BasicFunction.h"
+#include <stdexcept>
+
+namespace ffscript {
+	SystemLibrary::SystemLibrary() : _frozen(false)
+	{
+		_compiler = std::make_shared<ScriptCompiler>();
+		registerBasicLibrary(_compiler.get());
+	}
+
+	SystemLibrary::~SystemLibrary()
+	{
+	}
+
+	ScriptCompiler* SystemLibrary::getCompiler() {
+		if (_frozen) {
+			throw std::runtime_error("system library is frozen");
+		}
+		return _compiler.get();
+	}
+
+	void SystemLibrary::freeze() {
+		if (!_frozen) {
+			_compiler->beginUserLib();
+			_frozen = true;
+		}
+	}
+
+	bool SystemLibrary::isFrozen() const {
+		return _frozen;
+	}
+
+	ScriptCompilerRef SystemLibrary::createCompiler() const {
+		if (!_frozen) {
+			throw std::runtime_error("system library must be frozen before it is shared");
+		}
+		return std::make_shared<ScriptCompiler>(_compiler);
+	}
+
+	void SystemLibrary::registerBasicLibrary(ScriptCompiler* scriptCompiler) {
+		FunctionRegisterHelper funcLibHelper(scriptCompiler);
+
+		auto& typeManager = scriptCompiler->getTypeManager();
+
+		typeManager->registerBasicTypes(scriptCompiler);
+		typeManager->registerBasicTypeCastFunctions(scriptCompiler, funcLibHelper);
+		typeManager->registerConstants(scriptCompiler);
+
+		importBasicfunction(funcLibHelper);
+	}
+
+	const SystemLibraryRef& SystemLibrary::getBasicLibrary() {
+		// initialization of a local static object is thread safe
+		static SystemLibraryRef basicLibrary = []() {
+			auto systemLibrary = std::make_shared<SystemLibrary>();
+			systemLibrary->freeze();
+			return systemLibrary;
+		}();
+		return basicLibrary;
+	}
+}
@@ -0,0 +1,44 @@
+/******************************************************************
+* File:        SystemLibrary.h
+* Description: declare SystemLibrary class. A class used to build
+*              the system library once and share it with compilers
+*              which compile user programs in different threads.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+#include "ScriptCompiler.h"
+
+namespace ffscript {
+
+	class SystemLibrary
+	{
+		ScriptCompilerRef _compiler;
+		bool _frozen;
+	public:
+		// create a system library contains basic types, casting functions, constants and basic functions
+		SystemLibrary();
+		virtual ~SystemLibrary();
+
+		// get the compiler used to add more libraries to the system library,
+		// it is not accessible after the library is frozen
+		ScriptCompiler* getCompiler();
+		// make the system library immutable, compilers can only be created from a frozen library
+		void freeze();
+		bool isFrozen() const;
+		// create a compiler shares the system library, it can be called by multiple threads at same time
+		ScriptCompilerRef createCompiler() const;
+
+		static void registerBasicLibrary(ScriptCompiler* scriptCompiler);
+		// get a frozen system library which contains the basic library only, it is built at first call
+		static const std::shared_ptr<SystemLibrary>& getBasicLibrary();
+	};
+
+	typedef std::shared_ptr<SystemLibrary> SystemLibraryRef;
+}
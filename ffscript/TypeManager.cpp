@@ -18,6 +18,20 @@
 namespace ffscript {
 	TypeManager::TypeManager() {}
 
+	TypeManager::TypeManager(const TypeManager& other, ScriptCompiler* scriptCompiler) :
+		_basicTypes(other._basicTypes),
+		_typesInString(other._typesInString),
+		_typeStringIntMap(other._typeStringIntMap),
+		_typeInfoMap(other._typeInfoMap)
+	{
+		for (auto& it : _typeStringIntMap) {
+			_typesInString[it.second & DATA_TYPE_ORIGIN_MASK].name = &it.first;
+		}
+		for (auto& it : other._structMap) {
+			_structMap.insert(std::make_pair(it.first, std::make_shared<StructClass>(scriptCompiler, *it.second)));
+		}
+	}
+
 	TypeManager::~TypeManager()
 	{
 	}
@@ -155,11 +169,9 @@ namespace ffscript {
 				_structMap.erase(i);
 				_typeInfoMap.erase(i);
 				
-				for (auto it = _typeStringIntMap.begin(); it != _typeStringIntMap.end(); it++) {
-					if (it->second == i) {
-						_typeStringIntMap.erase(it);
-						break;
-					}
+				auto it = _typeStringIntMap.find(*(_typesInString[i].name));
+				if (it != _typeStringIntMap.end() && it->second == i) {
+					_typeStringIntMap.erase(it);
 				}
 			}
 
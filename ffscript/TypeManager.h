@@ -16,6 +16,7 @@
 #include "BasicType.h"
 
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <memory>
 #include <vector>
@@ -32,7 +33,7 @@ namespace ffscript {
 		ffscript::BasicTypes _basicTypes;
 
 		std::vector<TypeInfo> _typesInString;
-		std::map<const std::string, int> _typeStringIntMap;
+		std::unordered_map<std::string, int> _typeStringIntMap;
 		std::map<int, StructClassRef> _structMap;
 		std::map<int, MemoryBlockRef> _typeInfoMap;
 
@@ -44,6 +45,8 @@ namespace ffscript {
 
 	public:
 		TypeManager();
+		// copy types of other manager, its structs are copied and bound to the given compiler
+		TypeManager(const TypeManager& other, ScriptCompiler* scriptCompiler);
 		~TypeManager();
 		bool registTypeInfo(int type, MemoryBlockRef typeInfo);
 		void* getTypeInfo(int type);
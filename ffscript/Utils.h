@@ -14,6 +14,7 @@
 #include "GlobalScope.h"
 #include "ffscript.h"
 #include "TypeManager.h"
+#include "ScriptLexer.h"
 #include <string>
 #include <istream>
 #include <sstream>
@@ -67,6 +68,16 @@ namespace ffscript {
 		return c;
 	}
 
+	template <>
+	inline const wchar_t* lastCharInToken<wchar_t>(const wchar_t* text, const wchar_t* end) {
+		return ScriptLexer::skipIdentifierOrDot(text, end);
+	}
+
+	template <>
+	inline const wchar_t* lastCharInToken2<wchar_t>(const wchar_t* text, const wchar_t* end) {
+		return ScriptLexer::skipIdentifier(text, end);
+	}
+
 	template <class T>
 	SimpleArray<T> newSimpleArray(int size) {
 		SimpleArray<T> arr;
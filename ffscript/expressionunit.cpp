@@ -25,6 +25,14 @@ namespace ffscript {
 		//LOG_D("Delete expression unit " + POINTER2STRING(this));
 	}
 
+	void* ExpUnit::operator new(size_t size) {
+		return CompileArena::allocateObject(size);
+	}
+
+	void ExpUnit::operator delete(void* p) {
+		CompileArena::freeObject(p);
+	}
+
 	void ExpUnit::setIndex(int idx) {
 		_indexInExpression = (short)idx;
 	}
@@ -28,6 +28,7 @@
 #include <vector>
 #include <memory>
 #include "StructClass.h"
+#include "CompileArena.h"
 
 namespace ffscript {	
 
@@ -64,6 +65,11 @@ namespace ffscript {
 	public:
 		ExpUnit();
 		virtual ~ExpUnit();
+
+		// units are allocated from the arena of the current compile session if there is one
+		static void* operator new(size_t size);
+		static void operator delete(void* p);
+
 		void setIndex(int);
 		int getIndex() const;
 		void setSourceCharIndex(int);
@@ -81,6 +81,17 @@ typedef unsigned char byte;
 
 #define SCRIPT_FUNCTION_RETURN_STORAGE_OFFSET 0
 #define OPTIMIZE_CTOR_CALL 0
+// reuse param space of a finished sub expression for its next siblings
+#define REUSE_EXPRESSION_LOCAL_SPACE 1
+// call function objects which always refer to one known function directly
+#define DEVIRTUALIZE_FUNCTION_OBJECT 1
+// maximum size of captured data which is stored inside a function object
+#define LAMBDA_INLINE_DATA_SIZE (4 * sizeof(void*))
+// count the commands, calls, scopes and heap allocations of each context and allow to trace them.
+// it is off by default, the cmake option FFSCRIPT_INSTRUMENTATION turns it on
+#ifndef FFSCRIPT_INSTRUMENTATION
+#define FFSCRIPT_INSTRUMENTATION 0
+#endif
 
 #pragma region ffscript types
 
@@ -212,9 +223,22 @@ namespace ffscript {
 	struct AnoynymousDataInfo {
 		unsigned int dataSize;
 		unsigned int targetOffset;
-		void* data;
+		union {
+			// captured data allocated in heap, used when it is larger than the inline buffer
+			void* data;
+			// captured data of small lambda is stored inside the function object
+			char inlineData[LAMBDA_INLINE_DATA_SIZE];
+		};
 	};
 
+	inline bool isInlineAnoynymousData(const AnoynymousDataInfo& anoynymousInfo) {
+		return anoynymousInfo.dataSize <= LAMBDA_INLINE_DATA_SIZE;
+	}
+
+	inline void* getAnoynymousData(AnoynymousDataInfo& anoynymousInfo) {
+		return isInlineAnoynymousData(anoynymousInfo) ? anoynymousInfo.inlineData : anoynymousInfo.data;
+	}
+
 	struct RuntimeFunctionInfo
 	{
 		void* address;
@@ -23,4 +23,9 @@ DFunction2::DFunction2()
 
 DFunction2::~DFunction2()
 {
-}
\ No newline at end of file
+}
+
+DFunctionThunk DFunction2::getThunk(void*& target) {
+	target = nullptr;
+	return nullptr;
+}
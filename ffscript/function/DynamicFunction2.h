@@ -18,6 +18,10 @@
 //the library won't offer bind function, but it reduce calling cost
 #define USE_EXTERNAL_PARAMS_ONLY
 
+// plain function that invokes a target function with arguments packed in a block of memory
+// the target is stored by the caller, so the thunk can be called without the function object
+typedef void(*DFunctionThunk)(void* target, void* pReturnVal, char* params);
+
 class DFunction2
 {
 protected:
@@ -29,5 +33,8 @@ public:
 	virtual ~DFunction2();
 	virtual void call(void* pReturnVal, void* param[]) = 0;
 	virtual DFunction2* clone() = 0;
+	// get the thunk and its target that can be used to invoke the same function as call method
+	// return null if the function object does not support it
+	virtual DFunctionThunk getThunk(void*& target);
 };
 
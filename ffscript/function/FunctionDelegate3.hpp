@@ -270,5 +270,17 @@ namespace FT {
 			auto funcObj = new FunctionDelegate3<Ret, Types...>(_invoker._fx);
 			return funcObj;
 		}
+
+		// the thunk is specialized for the exact signature of the target function,
+		// argument offsets are resolved at compile time
+		static void thunk(void* target, void* pReturnVal, char* params) {
+			MyInvoker invoker((Fx)target);
+			invoker(pReturnVal, params);
+		}
+
+		DFunctionThunk getThunk(void*& target) {
+			target = (void*)_invoker._fx;
+			return thunk;
+		}
 	};
 }
\ No newline at end of file
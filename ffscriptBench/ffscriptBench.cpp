@@ -0,0 +1,483 @@
+/******************************************************************
+* File:        ffscriptBench.cpp
+* Description: Contains the micro and macro benchmarks of the script
+*              runtime. Each benchmark compiles a small script, runs
+*              one of its functions several times and reports the
+*              times as JSON, so the results of different releases
+*              can be compared.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <RawStringLib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace ffscript;
+
+// native function which is called by the native call benchmark
+static int benchAdd(int a, int b) {
+	return a + b;
+}
+
+static void importBenchLibrary(ScriptCompiler* scriptCompiler) {
+	FunctionRegisterHelper fb(scriptCompiler);
+	includeRawStringToCompiler(scriptCompiler);
+	registerFunction<int, int, int>(fb, benchAdd, "benchAdd", "int", "int,int");
+}
+
+struct BenchmarkResult {
+	std::string name;
+	std::string kind;
+	long long operations;
+	long long result;
+	bool passed;
+	std::vector<double> runTimes;
+};
+
+// a compiled script and the function which is measured, the function takes the
+// workload size and returns a value checked against the expected one
+class ScriptBenchmark {
+	CompilerSuite _compiler;
+	Program* _program;
+	int _functionId;
+public:
+	ScriptBenchmark() : _program(nullptr), _functionId(-1) {}
+
+	~ScriptBenchmark() {
+		if (_program) {
+			_compiler.getGlobalScope()->cleanupGlobalMemory();
+			delete _program;
+		}
+	}
+
+	bool compile(const wchar_t* scriptCode, const char* functionName, const char* paramTypes) {
+		_compiler.initialize(4096);
+		auto scriptCompiler = _compiler.getCompiler().get();
+		importBenchLibrary(scriptCompiler);
+		scriptCompiler->beginUserLib();
+
+		_program = _compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+		if (_program == nullptr) {
+			std::cerr << "compile error: " << scriptCompiler->getLastError() << std::endl;
+			return false;
+		}
+		_compiler.getGlobalScope()->runGlobalCode();
+
+		_functionId = scriptCompiler->findFunction(functionName, paramTypes);
+		if (_functionId < 0) {
+			std::cerr << "function '" << functionName << "' is not found" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	Program* getProgram() const { return _program; }
+	int getFunctionId() const { return _functionId; }
+};
+
+struct BenchmarkOptions {
+	int repeat = 5;
+	double scale = 1.0;
+	std::string filter;
+	std::string output;
+};
+
+class BenchmarkSuite {
+	BenchmarkOptions _options;
+	std::vector<BenchmarkResult> _results;
+private:
+	bool isSelected(const std::string& name) const {
+		return _options.filter.empty() || name.find(_options.filter) != std::string::npos;
+	}
+
+	// run the measured code once to warm up then the given number of times
+	void measure(BenchmarkResult& benchmarkResult, const std::function<long long()>& runOnce) {
+		runOnce();
+		for (int i = 0; i < _options.repeat; i++) {
+			auto t1 = std::chrono::high_resolution_clock::now();
+			benchmarkResult.result = runOnce();
+			auto t2 = std::chrono::high_resolution_clock::now();
+			benchmarkResult.runTimes.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+		}
+	}
+
+	static void writeNumber(std::ostream& os, double value) {
+		std::stringstream ss;
+		ss.precision(6);
+		ss << std::fixed << value;
+		os << ss.str();
+	}
+public:
+	BenchmarkSuite(const BenchmarkOptions& options) : _options(options) {}
+
+	int scaled(int size) const {
+		return std::max(1, (int)(size * _options.scale));
+	}
+
+	// measure a script function which takes an int and returns an int or a long
+	template <class Ret>
+	void addScript(const char* name, const char* kind, const wchar_t* scriptCode, const char* functionName,
+		int param, long long operations, long long expected) {
+		if (!isSelected(name)) return;
+		std::cerr << "running " << name << std::endl;
+
+		BenchmarkResult benchmarkResult{ name, kind, operations, 0, false, {} };
+		ScriptBenchmark benchmark;
+		if (benchmark.compile(scriptCode, functionName, "int")) {
+			ScriptTask scriptTask(benchmark.getProgram());
+			ScriptParamBuffer paramBuffer(param);
+			measure(benchmarkResult, [&]() {
+				scriptTask.runFunction(benchmark.getFunctionId(), &paramBuffer);
+				return (long long)*(Ret*)scriptTask.getTaskResult();
+			});
+			benchmarkResult.passed = benchmarkResult.result == expected;
+		}
+		_results.push_back(benchmarkResult);
+	}
+
+	// measure a code which uses a compiled script
+	void addCode(const char* name, const char* kind, const wchar_t* scriptCode, const char* functionName,
+		long long operations, long long expected, const std::function<long long(ScriptBenchmark&)>& runOnce) {
+		if (!isSelected(name)) return;
+		std::cerr << "running " << name << std::endl;
+
+		BenchmarkResult benchmarkResult{ name, kind, operations, 0, false, {} };
+		ScriptBenchmark benchmark;
+		if (benchmark.compile(scriptCode, functionName, "")) {
+			measure(benchmarkResult, [&]() { return runOnce(benchmark); });
+			benchmarkResult.passed = benchmarkResult.result == expected;
+		}
+		_results.push_back(benchmarkResult);
+	}
+
+	bool isPassed() const {
+		for (auto& benchmarkResult : _results) {
+			if (!benchmarkResult.passed) return false;
+		}
+		return true;
+	}
+
+	void writeJson(std::ostream& os) const {
+		os << "{" << std::endl;
+		os << "  \"suite\": \"ffscriptBench\"," << std::endl;
+		os << "  \"repeat\": " << _options.repeat << "," << std::endl;
+		os << "  \"scale\": ";
+		writeNumber(os, _options.scale);
+		os << "," << std::endl;
+		os << "  \"instrumentation\": " << (FFSCRIPT_INSTRUMENTATION ? "true" : "false") << "," << std::endl;
+		os << "  \"benchmarks\": [";
+		for (size_t i = 0; i < _results.size(); i++) {
+			auto& benchmarkResult = _results[i];
+			std::vector<double> runTimes(benchmarkResult.runTimes);
+			std::sort(runTimes.begin(), runTimes.end());
+			double minTime = 0, medianTime = 0, meanTime = 0;
+			if (runTimes.size()) {
+				minTime = runTimes.front();
+				medianTime = runTimes[runTimes.size() / 2];
+				for (double runTime : runTimes) meanTime += runTime;
+				meanTime /= runTimes.size();
+			}
+
+			os << (i ? "," : "") << std::endl;
+			os << "    {" << std::endl;
+			os << "      \"name\": \"" << benchmarkResult.name << "\"," << std::endl;
+			os << "      \"kind\": \"" << benchmarkResult.kind << "\"," << std::endl;
+			os << "      \"passed\": " << (benchmarkResult.passed ? "true" : "false") << "," << std::endl;
+			os << "      \"result\": " << benchmarkResult.result << "," << std::endl;
+			os << "      \"operations\": " << benchmarkResult.operations << "," << std::endl;
+			os << "      \"runs\": " << runTimes.size() << "," << std::endl;
+			os << "      \"min_ms\": ";
+			writeNumber(os, minTime);
+			os << "," << std::endl << "      \"median_ms\": ";
+			writeNumber(os, medianTime);
+			os << "," << std::endl << "      \"mean_ms\": ";
+			writeNumber(os, meanTime);
+			os << "," << std::endl << "      \"ns_per_operation\": ";
+			writeNumber(os, benchmarkResult.operations ? medianTime * 1e6 / benchmarkResult.operations : 0);
+			os << std::endl << "    }";
+		}
+		os << std::endl << "  ]" << std::endl;
+		os << "}" << std::endl;
+	}
+
+	const BenchmarkOptions& getOptions() const { return _options; }
+};
+
+////////////////////////////////////////////////////////////////////////////
+/// micro benchmarks
+////////////////////////////////////////////////////////////////////////////
+static const wchar_t* dispatchLoopScript =
+	L"int run(int n) {\n"
+	L"	int s = 0;\n"
+	L"	while(n > 0) {\n"
+	L"		s = s + 1;\n"
+	L"		n = n - 1;\n"
+	L"	}\n"
+	L"	return s;\n"
+	L"}\n";
+
+static const wchar_t* scriptCallScript =
+	L"int one(int x) {\n"
+	L"	return x;\n"
+	L"}\n"
+	L"int run(int n) {\n"
+	L"	int s = 0;\n"
+	L"	while(n > 0) {\n"
+	L"		s = s + one(1);\n"
+	L"		n = n - 1;\n"
+	L"	}\n"
+	L"	return s;\n"
+	L"}\n";
+
+static const wchar_t* nativeCallScript =
+	L"int run(int n) {\n"
+	L"	int s = 0;\n"
+	L"	while(n > 0) {\n"
+	L"		s = benchAdd(s, 1);\n"
+	L"		n = n - 1;\n"
+	L"	}\n"
+	L"	return s;\n"
+	L"}\n";
+
+// the function object is a parameter, so its target is known only at runtime
+static const wchar_t* lambdaCallScript =
+	L"int callLoop(function<int(int)>& f, int n) {\n"
+	L"	int s = 0;\n"
+	L"	while(n > 0) {\n"
+	L"		s = s + f(1);\n"
+	L"		n = n - 1;\n"
+	L"	}\n"
+	L"	return s;\n"
+	L"}\n"
+	L"int run(int n) {\n"
+	L"	int k = 1;\n"
+	L"	function<int(int)> f = [k](int x) -> int {\n"
+	L"		return x * k;\n"
+	L"	};\n"
+	L"	return callLoop(f, n);\n"
+	L"}\n";
+
+// each iteration enters the loop scope, constructs and destructs a string
+static const wchar_t* scopeScript =
+	L"int run(int n) {\n"
+	L"	int s = 0;\n"
+	L"	while(n > 0) {\n"
+	L"		String str;\n"
+	L"		s = s + 1;\n"
+	L"		n = n - 1;\n"
+	L"	}\n"
+	L"	return s;\n"
+	L"}\n";
+
+static const wchar_t* stringConcatScript =
+	L"int run(int n) {\n"
+	L"	int s = 0;\n"
+	L"	String a = \"abc\";\n"
+	L"	while(n > 0) {\n"
+	L"		String b = a + \"def\" + n;\n"
+	L"		s = s + 1;\n"
+	L"		n = n - 1;\n"
+	L"	}\n"
+	L"	return s;\n"
+	L"}\n";
+
+static const wchar_t* arrayIndexScript =
+	L"int run(int n) {\n"
+	L"	array<int,64> a;\n"
+	L"	int i = 0;\n"
+	L"	int s = 0;\n"
+	L"	while(n > 0) {\n"
+	L"		i = n % 64;\n"
+	L"		a[i] = 1;\n"
+	L"		s = s + a[i];\n"
+	L"		n = n - 1;\n"
+	L"	}\n"
+	L"	return s;\n"
+	L"}\n";
+
+static const wchar_t* globalAccessScript =
+	L"int total = 0;\n"
+	L"int run(int n) {\n"
+	L"	total = 0;\n"
+	L"	while(n > 0) {\n"
+	L"		total = total + 1;\n"
+	L"		n = n - 1;\n"
+	L"	}\n"
+	L"	return total;\n"
+	L"}\n";
+
+static const wchar_t* taskSetupScript =
+	L"int run() {\n"
+	L"	return 1;\n"
+	L"}\n";
+
+////////////////////////////////////////////////////////////////////////////
+/// macro workloads
+////////////////////////////////////////////////////////////////////////////
+
+// the script of the CoActionRecursive tutorial without the output, the size is the parameter
+static const wchar_t* coActionScript =
+	L"function<long(long)> fy;\n"
+	L"long X(long n) {\n"
+	L"	if(n < 1) {\n"
+	L"		return 1;\n"
+	L"	}\n"
+	L"	return X(n -1) + fy(n - 1);\n"
+	L"}\n"
+	L"long Y(long n) {\n"
+	L"	if(n < 1) {\n"
+	L"		return 1;\n"
+	L"	}\n"
+	L"	return 2 * X(n -1) * Y(n - 1);\n"
+	L"}\n"
+	L"fy = Y;\n"
+	L"long run(int n) {\n"
+	L"	long m = n;\n"
+	L"	return X(m) + Y(m);\n"
+	L"}\n";
+
+// fibonacci computed by two functions calling each other in the style of CoActionRecursive
+static const wchar_t* fibonacciScript =
+	L"function<int(int)> fy;\n"
+	L"int X(int n) {\n"
+	L"	if(n < 2) {\n"
+	L"		return n;\n"
+	L"	}\n"
+	L"	return X(n - 1) + fy(n - 2);\n"
+	L"}\n"
+	L"int Y(int n) {\n"
+	L"	if(n < 2) {\n"
+	L"		return n;\n"
+	L"	}\n"
+	L"	return X(n - 1) + Y(n - 2);\n"
+	L"}\n"
+	L"fy = Y;\n"
+	L"int run(int n) {\n"
+	L"	return X(n);\n"
+	L"}\n";
+
+// values of the co-action functions with the wrapping arithmetic of the script
+static void coAction(int n, unsigned long long& x, unsigned long long& y) {
+	x = 1;
+	y = 1;
+	for (int i = 1; i <= n; i++) {
+		unsigned long long nextX = x + y;
+		y = 2 * x * y;
+		x = nextX;
+	}
+}
+
+static long long coActionCalls(int n) {
+	// a call of X or Y with n > 0 calls both functions with n - 1
+	return (2LL << n) - 1;
+}
+
+static int fibonacci(int n) {
+	int a = 0, b = 1;
+	for (int i = 0; i < n; i++) {
+		int c = a + b;
+		a = b;
+		b = c;
+	}
+	return a;
+}
+
+static long long fibonacciCalls(int n) {
+	return 2LL * fibonacci(n + 1) - 1;
+}
+
+static void printUsage() {
+	std::cout << "usage: ffscriptBench [--repeat N] [--scale F] [--filter TEXT] [--output FILE]" << std::endl;
+	std::cout << "  --repeat N      measured runs of each benchmark, default 5" << std::endl;
+	std::cout << "  --scale F       multiply the workload sizes, default 1" << std::endl;
+	std::cout << "  --filter TEXT   run only the benchmarks whose name contains the text" << std::endl;
+	std::cout << "  --output FILE   write the JSON result to the file instead of the standard output" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h") {
+			printUsage();
+			return 0;
+		}
+		if (i + 1 >= argc) {
+			printUsage();
+			return 1;
+		}
+		if (arg == "--repeat") options.repeat = std::max(1, atoi(argv[++i]));
+		else if (arg == "--scale") options.scale = atof(argv[++i]);
+		else if (arg == "--filter") options.filter = argv[++i];
+		else if (arg == "--output") options.output = argv[++i];
+		else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	BenchmarkSuite suite(options);
+
+	int n = suite.scaled(1000000);
+	suite.addScript<int>("dispatch_loop", "micro", dispatchLoopScript, "run", n, n, n);
+	suite.addScript<int>("script_call", "micro", scriptCallScript, "run", n, n, n);
+	suite.addScript<int>("native_call", "micro", nativeCallScript, "run", n, n, n);
+	suite.addScript<int>("lambda_call", "micro", lambdaCallScript, "run", n, n, n);
+	n = suite.scaled(200000);
+	suite.addScript<int>("scope_constructor", "micro", scopeScript, "run", n, n, n);
+	suite.addScript<int>("string_concat", "micro", stringConcatScript, "run", n, n, n);
+	n = suite.scaled(1000000);
+	suite.addScript<int>("static_array_index", "micro", arrayIndexScript, "run", n, n, n);
+	suite.addScript<int>("global_access", "micro", globalAccessScript, "run", n, n, n);
+
+	n = suite.scaled(10000);
+	suite.addCode("script_task_setup", "micro", taskSetupScript, "run", n, n, [n](ScriptBenchmark& benchmark) {
+		long long s = 0;
+		for (int i = 0; i < n; i++) {
+			ScriptTask scriptTask(benchmark.getProgram());
+			scriptTask.runFunction(benchmark.getFunctionId(), nullptr);
+			s += *(int*)scriptTask.getTaskResult();
+		}
+		return s;
+	});
+
+	// the workloads grow exponentially, so the scale changes their size logarithmically
+	int sizeStep = options.scale > 0 ? (int)(log2(options.scale) + (options.scale >= 1 ? 0.5 : -0.5)) : 0;
+	n = std::max(1, 18 + sizeStep);
+	unsigned long long x, y;
+	coAction(n, x, y);
+	suite.addScript<long long>("co_action_recursive", "macro", coActionScript, "run", n, 2 * coActionCalls(n), (long long)(x + y));
+	n = std::max(1, 25 + sizeStep);
+	suite.addScript<int>("fibonacci_recursive", "macro", fibonacciScript, "run", n, fibonacciCalls(n), fibonacci(n));
+
+	if (options.output.empty()) {
+		suite.writeJson(std::cout);
+	}
+	else {
+		std::ofstream ofs(options.output);
+		if (!ofs.is_open()) {
+			std::cerr << "cannot open file " << options.output << std::endl;
+			return 1;
+		}
+		suite.writeJson(ofs);
+	}
+
+	return suite.isPassed() ? 0 : 2;
+}
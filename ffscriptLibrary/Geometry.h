@@ -15,6 +15,7 @@
 #include <memory>
 #include <algorithm>
 #include <cmath>
+#include <stdexcept>
 
 #define GEOMETRY_EPSILON 0.000001
 #define MIN_POINT_DISTANCE 5.0f
@@ -1308,6 +1308,377 @@ namespace ffscriptUT
 			EXPECT_TRUE(*funcRes == n) << L"program can run but return wrong value";
 		}
 
+		TEST_F(CompileProgram, CompileLooAndBreak4)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext,&scriptCompiler);
+			int n = 100;
+
+			//initialize an instance of script program
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			const wchar_t* scriptCode =
+				L"int foo(int n) {"
+				L"	int res = 0;"
+				L"	while(n > 0) {"
+				L"		while(n > 0) {"
+				L"			n = n - 1;"
+				L"			res = res + 1;"
+				L"			break;"
+				L"		}"
+				L"		if(n < 50) {"
+				L"			break;"
+				L"		}"
+				L"	}"
+				L"	return res;"
+				L"}"
+				;
+
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			EXPECT_TRUE(res != nullptr) << L"compile program failed";
+
+			bool blRes = rootScope.extractCode(&theProgram);
+			EXPECT_TRUE(blRes) << L"extract code failed";
+
+			// the break command of the inner loop contains only the exit scope command
+			// of the loop, so it must be replaced by that command
+			EXPECT_EQ(1, theProgram.getEliminatedCommandCount()) << L"break command is not optimized";
+
+			const list<OverLoadingItem>* overLoadingFuncItems = scriptCompiler.findOverloadingFuncRoot("foo");
+			EXPECT_TRUE(overLoadingFuncItems->size() > 0) << L"cannot find function 'foo'";
+
+			ScriptParamBuffer paramBuffer(n);
+			ScriptTask scriptTask(&theProgram);
+			scriptTask.runFunction(overLoadingFuncItems->front().functionId, &paramBuffer);
+			int* funcRes = (int*)scriptTask.getTaskResult();
+			PRINT_TEST_MESSAGE(("foo =" + std::to_string(*funcRes)).c_str());
+			EXPECT_EQ(51, *funcRes) << L"program can run but return wrong value";
+		}
+
+		TEST_F(CompileProgram, CompileStripUnreachableFunctions)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext,&scriptCompiler);
+			int n = 10;
+
+			//initialize an instance of script program
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			const wchar_t* scriptCode =
+				L"int unused(int n) {"
+				L"	return n * 2;"
+				L"}"
+				L"int bar(int n) {"
+				L"	return n + 1;"
+				L"}"
+				L"int foo(int n) {"
+				L"	int res = bar(n) * 3;"
+				L"	return res;"
+				L"	res = unused(res);"
+				L"}"
+				;
+
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			EXPECT_TRUE(res != nullptr) << L"compile program failed";
+
+			rootScope.addEntryFunction("foo");
+			bool blRes = rootScope.extractCode(&theProgram);
+			EXPECT_TRUE(blRes) << L"extract code failed";
+
+			// function 'unused' is called only after the return statement of 'foo'
+			// so it is not reachable from the entry function
+			const list<OverLoadingItem>* unusedItems = scriptCompiler.findOverloadingFuncRoot("unused");
+			EXPECT_TRUE(unusedItems->size() > 0) << L"cannot find function 'unused'";
+			EXPECT_EQ(nullptr, theProgram.getFunctionPlainCode(unusedItems->front().functionId)) << L"function 'unused' must be stripped";
+
+			const list<OverLoadingItem>* barItems = scriptCompiler.findOverloadingFuncRoot("bar");
+			EXPECT_TRUE(barItems->size() > 0) << L"cannot find function 'bar'";
+			EXPECT_NE(nullptr, theProgram.getFunctionPlainCode(barItems->front().functionId)) << L"function 'bar' must be kept";
+
+			const list<OverLoadingItem>* overLoadingFuncItems = scriptCompiler.findOverloadingFuncRoot("foo");
+			EXPECT_TRUE(overLoadingFuncItems->size() > 0) << L"cannot find function 'foo'";
+
+			ScriptParamBuffer paramBuffer(n);
+			ScriptTask scriptTask(&theProgram);
+			scriptTask.runFunction(overLoadingFuncItems->front().functionId, &paramBuffer);
+			int* funcRes = (int*)scriptTask.getTaskResult();
+			PRINT_TEST_MESSAGE(("foo =" + std::to_string(*funcRes)).c_str());
+			EXPECT_EQ(33, *funcRes) << L"program can run but return wrong value";
+		}
+
+		TEST_F(CompileProgram, CompileLazyFunctionBodies)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext,&scriptCompiler);
+			int n = 10;
+
+			//initialize an instance of script program
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			// 'unused' is never called so its body is not parsed, 'bar' is called by 'foo'
+			const wchar_t* scriptCode =
+				L"int unused(int n) {"
+				L"	int x = n * 2;"
+				L"	return x;"
+				L"}"
+				L"int bar(int n) {"
+				L"	return n + 1;"
+				L"}"
+				L"int foo(int n) {"
+				L"	int res = bar(n) * 3;"
+				L"	return res;"
+				L"}"
+				;
+
+			rootScope.addEntryFunction("foo");
+			rootScope.setLazyFunctionBody(true);
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			EXPECT_TRUE(res != nullptr) << scriptCompiler.getLastError();
+			EXPECT_EQ(1, rootScope.getSkippedFunctionBodyCount());
+
+			bool blRes = rootScope.extractCode(&theProgram);
+			EXPECT_TRUE(blRes) << L"extract code failed";
+
+			const list<OverLoadingItem>* barItems = scriptCompiler.findOverloadingFuncRoot("bar");
+			EXPECT_TRUE(barItems->size() > 0) << L"cannot find function 'bar'";
+			EXPECT_NE(nullptr, theProgram.getFunctionPlainCode(barItems->front().functionId)) << L"function 'bar' must be kept";
+
+			const list<OverLoadingItem>* overLoadingFuncItems = scriptCompiler.findOverloadingFuncRoot("foo");
+			EXPECT_TRUE(overLoadingFuncItems->size() > 0) << L"cannot find function 'foo'";
+
+			ScriptParamBuffer paramBuffer(n);
+			ScriptTask scriptTask(&theProgram);
+			scriptTask.runFunction(overLoadingFuncItems->front().functionId, &paramBuffer);
+			int* funcRes = (int*)scriptTask.getTaskResult();
+			EXPECT_EQ(33, *funcRes) << L"program can run but return wrong value";
+		}
+
+		TEST_F(CompileProgram, CompileLazyFunctionBodiesUseGlobal)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext, &scriptCompiler);
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			// the body of 'unused' is skipped, the other bodies compile as in eager mode
+			const wchar_t* scriptCode =
+				L"int g = 2;"
+				L"int unused(int n) {"
+				L"	return n * 2;"
+				L"}"
+				L"int bar(int n) {"
+				L"	return n + g;"
+				L"}"
+				L"int foo(int n) {"
+				L"	return bar(n) * 3;"
+				L"}"
+				;
+
+			rootScope.addEntryFunction("foo");
+			rootScope.setLazyFunctionBody(true);
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			ASSERT_TRUE(res != nullptr) << scriptCompiler.getLastError();
+			EXPECT_EQ(1, rootScope.getSkippedFunctionBodyCount());
+			ASSERT_TRUE(rootScope.extractCode(&theProgram)) << L"extract code failed";
+
+			const list<OverLoadingItem>* fooItems = scriptCompiler.findOverloadingFuncRoot("foo");
+			ASSERT_TRUE(fooItems != nullptr && fooItems->size() > 0) << L"cannot find function 'foo'";
+
+			ScriptParamBuffer paramBuffer(10);
+			ScriptTask scriptTask(&theProgram);
+			scriptTask.runFunction(fooItems->front().functionId, &paramBuffer);
+			EXPECT_EQ(36, *(int*)scriptTask.getTaskResult()) << L"program can run but return wrong value";
+		}
+
+		TEST_F(CompileProgram, CompileEagerFunctionBodiesUseGlobal)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext, &scriptCompiler);
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			// same code as CompileLazyFunctionBodiesUseGlobal, all bodies are parsed
+			const wchar_t* scriptCode =
+				L"int g = 2;"
+				L"int unused(int n) {"
+				L"	return n * 2;"
+				L"}"
+				L"int bar(int n) {"
+				L"	return n + g;"
+				L"}"
+				L"int foo(int n) {"
+				L"	return bar(n) * 3;"
+				L"}"
+				;
+
+			rootScope.addEntryFunction("foo");
+			rootScope.setLazyFunctionBody(false);
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			ASSERT_TRUE(res != nullptr) << scriptCompiler.getLastError();
+			EXPECT_EQ(0, rootScope.getSkippedFunctionBodyCount());
+			ASSERT_TRUE(rootScope.extractCode(&theProgram)) << L"extract code failed";
+
+			const list<OverLoadingItem>* fooItems = scriptCompiler.findOverloadingFuncRoot("foo");
+			ASSERT_TRUE(fooItems != nullptr && fooItems->size() > 0) << L"cannot find function 'foo'";
+
+			ScriptParamBuffer paramBuffer(10);
+			ScriptTask scriptTask(&theProgram);
+			scriptTask.runFunction(fooItems->front().functionId, &paramBuffer);
+			EXPECT_EQ(36, *(int*)scriptTask.getTaskResult()) << L"program can run but return wrong value";
+		}
+
+		TEST_F(CompileProgram, CompileLazyFunctionBodiesLaterGlobal)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext, &scriptCompiler);
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			// a used body sees only the global variables declared before it as in eager mode
+			const wchar_t* scriptCode =
+				L"int foo() {"
+				L"	return g;"
+				L"}"
+				L"int g = 1;"
+				;
+
+			rootScope.addEntryFunction("foo");
+			rootScope.setLazyFunctionBody(true);
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			EXPECT_EQ(nullptr, res) << L"'g' must not be visible in 'foo'";
+		}
+
+		TEST_F(CompileProgram, CompileEagerFunctionBodiesLaterGlobal)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext, &scriptCompiler);
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			// a used body sees only the global variables declared before it
+			const wchar_t* scriptCode =
+				L"int foo() {"
+				L"	return g;"
+				L"}"
+				L"int g = 1;"
+				;
+
+			rootScope.addEntryFunction("foo");
+			rootScope.setLazyFunctionBody(false);
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			EXPECT_EQ(nullptr, res) << L"'g' must not be visible in 'foo'";
+		}
+
+		TEST_F(CompileProgram, PrecomputeGlobalData)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext,&scriptCompiler);
+
+			//initialize an instance of script program
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			// 'a', 'b' and 'd' are initialized at compile time, 'a = 5' must run after 'c' is
+			// initialized and no initializer is evaluated after calling 'foo'
+			const wchar_t* scriptCode =
+				L"int a = 1;"
+				L"int b = 2 + 3 * 4;"
+				L"double d = 1.5;"
+				L"int c = a + 1;"
+				L"a = 5;"
+				L"int foo() {"
+				L"	b = 9;"
+				L"	return 0;"
+				L"}"
+				L"int z = foo();"
+				L"int w = 8;"
+				;
+
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			EXPECT_TRUE(res != nullptr) << scriptCompiler.getLastError();
+
+			bool blRes = rootScope.extractCode(&theProgram);
+			EXPECT_TRUE(blRes) << L"extract code failed";
+			EXPECT_EQ(16, staticContext.getInitialDataSize());
+
+			auto globalVariable = [&rootScope](const char* name) {
+				return rootScope.getGlobalAddress(rootScope.findVariable(name)->getOffset());
+			};
+
+			for (int i = 0; i < 2; i++) {
+				*(double*)globalVariable("d") = 0;
+				rootScope.runGlobalCode();
+				EXPECT_EQ(5, *(int*)globalVariable("a"));
+				EXPECT_EQ(9, *(int*)globalVariable("b"));
+				EXPECT_EQ(2, *(int*)globalVariable("c"));
+				EXPECT_EQ(1.5, *(double*)globalVariable("d"));
+				EXPECT_EQ(8, *(int*)globalVariable("w"));
+				rootScope.cleanupGlobalMemory();
+			}
+		}
+
+		TEST_F(CompileProgram, CompileOverloadResolutionCache)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext,&scriptCompiler);
+
+			//initialize an instance of script program
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			const wchar_t* scriptCode =
+				L"float half(float x) {"
+				L"	return x / 2;"
+				L"}"
+				L"float foo(int n) {"
+				L"	float f = 1;"
+				L"	float r = half(n) + f + n + f + n;"
+				L"	r = r + half(n) + f + n;"
+				L"	return r;"
+				L"}"
+				L"int half(int x) {"
+				L"	return x;"
+				L"}"
+				L"int bar(int n) {"
+				L"	return half(n);"
+				L"}"
+				;
+
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			EXPECT_TRUE(res != nullptr) << L"compile program failed";
+
+			bool blRes = rootScope.extractCode(&theProgram);
+			EXPECT_TRUE(blRes) << L"extract code failed";
+
+			int n = 5;
+			int fooId = scriptCompiler.findFunction("foo", "int");
+			EXPECT_TRUE(fooId >= 0) << L"cannot find function 'foo'";
+			ScriptParamBuffer paramBuffer(n);
+			ScriptTask scriptTask(&theProgram);
+			scriptTask.runFunction(fooId, &paramBuffer);
+			float* fooRes = (float*)scriptTask.getTaskResult();
+			EXPECT_EQ(2.5f + 1 + 5 + 1 + 5 + 2.5f + 1 + 5, *fooRes) << L"program can run but return wrong value";
+
+			// 'half(int)' is registered after 'half(n)' in 'foo' was resolved, so it must be selected in 'bar'
+			int barId = scriptCompiler.findFunction("bar", "int");
+			EXPECT_TRUE(barId >= 0) << L"cannot find function 'bar'";
+			scriptTask.runFunction(barId, &paramBuffer);
+			int* barRes = (int*)scriptTask.getTaskResult();
+			EXPECT_EQ(5, *barRes) << L"program can run but return wrong value";
+		}
+
 		int fibonacci(int n) {
 				if(n < 2) {
 					return n;
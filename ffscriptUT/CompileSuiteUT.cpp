@@ -16,6 +16,21 @@
 #include <Utils.h>
 #include <DefaultPreprocessor.h>
 #include <RawStringLib.h>
+#include <CompileArena.h>
+#include <ExpresionParser.h>
+#include <InstructionCommand.h>
+#include <FuncLibrary.h>
+#include <Executor.h>
+#include <GlobalDataView.h>
+#include <ScriptProfiler.h>
+#include <Instrumentation.h>
+#include <ScopeRuntimeData.h>
+#include <DebugInfo.h>
+#include <typeinfo>
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <cstdio>
 
 #include "Utils.h"
 
@@ -1367,6 +1382,932 @@ TEST(CompileSuite, TestSemiRef03)
 	auto res = *(unsigned long long*)scriptTask.getTaskResult();
 	EXPECT_EQ(0x12345678ull, res);
 }
+TEST(CompileSuite, CompileSessionArena)
+{
+	ExpUnitRef aliveUnit;
+	{
+		CompileSession compileSession;
+		CompileArena* arena = compileSession.getArena();
+		EXPECT_EQ(arena, CompileArena::getCurrent());
+
+		aliveUnit.reset(new ParamSeperator());
+		EXPECT_EQ(1, (int)arena->getAllocationCount()) << L"expression unit must be allocated from the arena";
+
+		auto candidates = makeCompileShared<CandidateCollection>();
+		for (int i = 0; i < 100; i++) {
+			candidates->push_back(ExecutableUnitRef(new CConstOperand<int>(i, "int")));
+		}
+		EXPECT_LT(200, (int)arena->getAllocationCount()) << L"candidate list and its units must be allocated from the arena";
+		EXPECT_EQ(1, arena->getRegionCount());
+
+		// a freed unit gives its block to the next unit of the same size
+		ExpUnit* freedUnit = candidates->back().get();
+		candidates->pop_back();
+		ExpUnitRef newUnit(new CConstOperand<int>(100, "int"));
+		EXPECT_EQ(freedUnit, newUnit.get());
+		EXPECT_LT(0, (int)arena->getReusedCount());
+	}
+	EXPECT_EQ(nullptr, CompileArena::getCurrent());
+
+	// the unit keeps its memory after the session ends
+	EXPECT_EQ(ParamSeperator::getFuncName(), aliveUnit->toString());
+	aliveUnit.reset();
+
+	// units are allocated from the heap outside of compile sessions
+	ExpUnitRef heapUnit(new ParamSeperator());
+	EXPECT_EQ(ParamSeperator::getFuncName(), heapUnit->toString());
+
+	CompilerSuite compiler;
+	compiler.initialize(8);
+	GlobalScopeRef rootScope = compiler.getGlobalScope();
+	auto scriptCompiler = rootScope->getCompiler();
+
+	const wchar_t* scriptCode =
+		L"int square(int n) {"
+		L"	return n * n;"
+		L"}"
+		;
+
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program);
+	int functionId = scriptCompiler->findFunction("square", "int");
+	EXPECT_TRUE(functionId >= 0) << L"cannot find function 'square'";
+
+	int n = 10;
+	ScriptParamBuffer paramBuffer(n);
+	ScriptTask scriptTask(program);
+	scriptTask.runFunction(functionId, &paramBuffer);
+	int* funcRes = (int*)scriptTask.getTaskResult();
+	EXPECT_EQ(n * n, *funcRes) << L"program can run but return wrong value";
+
+	// the units of the compiled code are released when the compiling ends
+	EXPECT_EQ(0, rootScope->getCommandUnitCount());
+	for (auto& child : rootScope->getChildren()) {
+		EXPECT_EQ(0, child->getCommandUnitCount());
+	}
+	delete program;
+}
+
+static Program* compileGeneratedFunctions(CompilerSuite& compiler, int threadCount, int functionCount) {
+	compiler.initialize(1024);
+	compiler.getGlobalScope()->setExtractionThreadCount(threadCount);
+
+	std::wstring scriptCode =
+		L"struct Pair {"
+		L"	int first;"
+		L"	int second;"
+		L"}"
+		L"int f0(int n) {"
+		L"	return n + 1;"
+		L"}";
+	for (int i = 1; i < functionCount; i++) {
+		auto index = std::to_wstring(i);
+		auto prevIndex = std::to_wstring(i - 1);
+		scriptCode += L"int f" + index + L"(int n) {"
+			L"	Pair p;"
+			L"	p.first = f" + prevIndex + L"(n);"
+			L"	p.second = " + index + L";"
+			L"	function<int(int)> g = [](int x) -> int { return x * 2; };"
+			L"	if(n > 100) {"
+			L"		return p.first;"
+			L"	}"
+			L"	return p.first + g(p.second);"
+			L"}";
+	}
+
+	return compiler.compileProgram(scriptCode.c_str(), scriptCode.c_str() + scriptCode.size());
+}
+
+TEST(CompileSuite, ExtractFunctionsInParallel)
+{
+	const int functionCount = 40;
+	CompilerSuite sequentialCompiler;
+	CompilerSuite parallelCompiler;
+
+	Program* sequentialProgram = compileGeneratedFunctions(sequentialCompiler, 1, functionCount);
+	Program* parallelProgram = compileGeneratedFunctions(parallelCompiler, 4, functionCount);
+	ASSERT_NE(nullptr, sequentialProgram);
+	ASSERT_NE(nullptr, parallelProgram);
+	EXPECT_EQ(4, parallelCompiler.getGlobalScope()->getExtractionThreadCount());
+
+	// the parallel extraction must produce the same plain code
+	int commandCount = (int)(sequentialProgram->getEndCommand() - sequentialProgram->getFirstCommand());
+	ASSERT_EQ(commandCount, (int)(parallelProgram->getEndCommand() - parallelProgram->getFirstCommand()));
+	for (int i = 0; i < commandCount; i++) {
+		auto sequentialCommand = sequentialProgram->getFirstCommand()[i];
+		auto parallelCommand = parallelProgram->getFirstCommand()[i];
+		ASSERT_TRUE(typeid(*sequentialCommand) == typeid(*parallelCommand)) << L"command " << i << L" is different";
+	}
+
+	auto functionName = "f" + std::to_string(functionCount - 1);
+	int n = 1;
+	int expectedResult = n + 1;
+	for (int i = 1; i < functionCount; i++) {
+		expectedResult += i * 2;
+	}
+
+	Program* programs[] = { sequentialProgram, parallelProgram };
+	CompilerSuite* compilers[] = { &sequentialCompiler, &parallelCompiler };
+	for (int i = 0; i < 2; i++) {
+		int functionId = compilers[i]->getGlobalScope()->getCompiler()->findFunction(functionName, "int");
+		ASSERT_TRUE(functionId >= 0) << L"cannot find function";
+
+		ScriptParamBuffer paramBuffer(n);
+		ScriptTask scriptTask(programs[i]);
+		scriptTask.runFunction(functionId, &paramBuffer);
+		EXPECT_EQ(expectedResult, *(int*)scriptTask.getTaskResult()) << L"program can run but return wrong value";
+		delete programs[i];
+	}
+}
+
+TEST(CompileSuite, CompileWithSharedSystemLibrary)
+{
+	auto systemLibrary = std::make_shared<SystemLibrary>();
+	includeRawStringToCompiler(systemLibrary->getCompiler());
+	systemLibrary->freeze();
+	EXPECT_THROW(systemLibrary->getCompiler(), std::runtime_error);
+
+	const int threadCount = 4;
+	int results[threadCount];
+	std::string errors[threadCount];
+	std::vector<std::thread> threads;
+	for (int i = 0; i < threadCount; i++) {
+		threads.emplace_back([&systemLibrary, &results, &errors, i]() {
+			CompilerSuite compiler;
+			compiler.initialize(8, systemLibrary);
+			auto& scriptCompiler = compiler.getCompiler();
+
+			// all threads define a function with same name but different body
+			std::wstring scriptCode =
+				L"int foo(int n) {"
+				L"	String s = \"value\";"
+				L"	bool b = true;"
+				L"	return n * " + std::to_wstring(i + 2) + L";"
+				L"}";
+			results[i] = -1;
+			Program* program = compiler.compileProgram(scriptCode.c_str(), scriptCode.c_str() + scriptCode.size());
+			if (program == nullptr) {
+				errors[i] = scriptCompiler->getLastError();
+				return;
+			}
+			int functionId = scriptCompiler->findFunction("foo", "int");
+			if (functionId >= 0) {
+				ScriptParamBuffer paramBuffer(10);
+				ScriptTask scriptTask(program);
+				scriptTask.runFunction(functionId, &paramBuffer);
+				results[i] = *(int*)scriptTask.getTaskResult();
+			}
+			delete program;
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	for (int i = 0; i < threadCount; i++) {
+		EXPECT_EQ(10 * (i + 2), results[i]) << errors[i];
+	}
+}
+
+TEST(CompileSuite, InitializeFromBasicLibrary)
+{
+	CompilerSuite compiler1;
+	CompilerSuite compiler2;
+	compiler1.initialize(8);
+	compiler2.initialize(8);
+	auto& scriptCompiler1 = compiler1.getCompiler();
+	auto& scriptCompiler2 = compiler2.getCompiler();
+
+	// the basic functions are registered once and shared by the suites
+	int functionId = scriptCompiler1->findFunction("+", "int,int");
+	ASSERT_TRUE(functionId >= 0);
+	EXPECT_EQ(functionId, scriptCompiler2->findFunction("+", "int,int"));
+	EXPECT_EQ(scriptCompiler1->getFunctionFactory(functionId), scriptCompiler2->getFunctionFactory(functionId));
+	EXPECT_EQ(scriptCompiler1->getFunctionLib()->getFunctionCount(), scriptCompiler2->getFunctionLib()->getFunctionCount());
+
+	// user functions of a suite are not visible in other suite
+	const wchar_t* scriptCode = L"int foo(int n) { return n + 1; }";
+	Program* program = compiler1.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program);
+	EXPECT_TRUE(scriptCompiler1->findFunction("foo", "int") >= 0);
+	EXPECT_EQ(-1, scriptCompiler2->findFunction("foo", "int"));
+	delete program;
+}
+
+TEST(CompileSuite, ReloadFunction)
+{
+	const wchar_t* scriptCode =
+		L"int counter = 5;"
+		L"int weight(int n) {"
+		L"	return n * 2;"
+		L"}"
+		L"int foo(int n) {"
+		L"	counter = counter + 1;"
+		L"	function<int(int)> f = weight;"
+		L"	return weight(n) + f(1) + counter;"
+		L"}";
+
+	CompilerSuite compiler;
+	compiler.initialize(64);
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << compiler.getCompiler()->getLastError();
+	compiler.getGlobalScope()->runGlobalCode();
+
+	int functionId = compiler.getCompiler()->findFunction("foo", "int");
+	ASSERT_TRUE(functionId >= 0);
+	ScriptTask scriptTask(program);
+	ScriptParamBuffer paramBuffer(10);
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(20 + 2 + 6, *(int*)scriptTask.getTaskResult());
+
+	// the recursive call must run the new code too
+	const wchar_t* newWeight =
+		L"int weight(int n) {"
+		L"	if(n > 5) {"
+		L"		return weight(n - 5) + 15;"
+		L"	}"
+		L"	return n * 3;"
+		L"}";
+	ASSERT_TRUE(compiler.reloadFunction(program, newWeight, newWeight + wcslen(newWeight))) << compiler.getCompiler()->getLastError();
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(30 + 3 + 7, *(int*)scriptTask.getTaskResult()) << L"global variable must keep its value";
+
+	// a failed reload keeps the current code
+	const wchar_t* invalidWeight = L"int weight(int n) { return unknown(n); }";
+	EXPECT_FALSE(compiler.reloadFunction(program, invalidWeight, invalidWeight + wcslen(invalidWeight)));
+	const wchar_t* newFunction = L"int bar(int n) { return n; }";
+	EXPECT_FALSE(compiler.reloadFunction(program, newFunction, newFunction + wcslen(newFunction)));
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(30 + 3 + 8, *(int*)scriptTask.getTaskResult());
+
+	// the lambda functions registered by a failed reload are unregistered
+	auto registeredFunctionCount = [&compiler]() {
+		int count = 0;
+		for (int i = 0; i < 10000; i++) {
+			if (compiler.getCompiler()->getFunctionFactory(i)) count++;
+		}
+		return count;
+	};
+	int functionCount = registeredFunctionCount();
+	const wchar_t* invalidFoo =
+		L"int foo(int n) {"
+		L"	function<int(int)> g = [](int x) -> int { return x * 2; };"
+		L"	return g(n) + unknown(n);"
+		L"}";
+	EXPECT_FALSE(compiler.reloadFunction(program, invalidFoo, invalidFoo + wcslen(invalidFoo)));
+	EXPECT_EQ(functionCount, registeredFunctionCount());
+
+	// the task which already ran the entry function runs its new code
+	const wchar_t* newFoo =
+		L"int foo(int n) {"
+		L"	return n * 11;"
+		L"}";
+	ASSERT_TRUE(compiler.reloadFunction(program, newFoo, newFoo + wcslen(newFoo))) << compiler.getCompiler()->getLastError();
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(110, *(int*)scriptTask.getTaskResult());
+
+	compiler.getGlobalScope()->cleanupGlobalMemory();
+	delete program;
+}
+
+TEST(CompileSuite, ReloadFunctionObject)
+{
+	// the function object is stored by a task before the reload and called through
+	// a parameter, so its target is known only at runtime
+	const wchar_t* scriptCode =
+		L"function<int(int)> savedWeight;"
+		L"int weight(int n) {"
+		L"	return n * 2;"
+		L"}"
+		L"void save() {"
+		L"	savedWeight = weight;"
+		L"}"
+		L"int apply(function<int(int)> f, int n) {"
+		L"	return f(n);"
+		L"}"
+		L"int foo(int n) {"
+		L"	return apply(savedWeight, n);"
+		L"}";
+
+	CompilerSuite compiler;
+	compiler.initialize(1024);
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << compiler.getCompiler()->getLastError();
+	compiler.getGlobalScope()->runGlobalCode();
+
+	int saveId = compiler.getCompiler()->findFunction("save", "");
+	int functionId = compiler.getCompiler()->findFunction("foo", "int");
+	ASSERT_TRUE(saveId >= 0 && functionId >= 0);
+	ScriptTask scriptTask(program);
+	scriptTask.runFunction(saveId, nullptr);
+	ScriptParamBuffer paramBuffer(10);
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(20, *(int*)scriptTask.getTaskResult());
+
+	const wchar_t* newWeight =
+		L"int weight(int n) {"
+		L"	return n * 3;"
+		L"}";
+	ASSERT_TRUE(compiler.reloadFunction(program, newWeight, newWeight + wcslen(newWeight))) << compiler.getCompiler()->getLastError();
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(30, *(int*)scriptTask.getTaskResult()) << L"the function object built before the reload must run the new code";
+
+	// the old code is redirected again when the function is reloaded again
+	const wchar_t* newerWeight =
+		L"int weight(int n) {"
+		L"	return n * 4;"
+		L"}";
+	ASSERT_TRUE(compiler.reloadFunction(program, newerWeight, newerWeight + wcslen(newerWeight))) << compiler.getCompiler()->getLastError();
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(40, *(int*)scriptTask.getTaskResult());
+
+	compiler.getGlobalScope()->cleanupGlobalMemory();
+	delete program;
+}
+
+static CompilerSuite* s_reloadingCompiler = nullptr;
+static Program* s_reloadingProgram = nullptr;
+
+static int reloadWhileRunning(int n) {
+	const wchar_t* newWeight = L"int weight(int n) { return n * 3; }";
+	bool reloaded = s_reloadingCompiler->reloadFunction(s_reloadingProgram, newWeight, newWeight + wcslen(newWeight));
+	return reloaded ? -1 : n;
+}
+
+TEST(CompileSuite, ReloadFunctionWhileRunning)
+{
+	CompilerSuite compiler;
+	compiler.initialize(64);
+	auto scriptCompiler = compiler.getCompiler();
+	FunctionRegisterHelper fb(scriptCompiler.get());
+	registerFunction<int, int>(fb, reloadWhileRunning, "reloadWhileRunning", "int", "int");
+	scriptCompiler->beginUserLib();
+
+	const wchar_t* scriptCode =
+		L"int weight(int n) {"
+		L"	return n * 2;"
+		L"}"
+		L"int foo(int n) {"
+		L"	return reloadWhileRunning(n) + weight(n);"
+		L"}";
+
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << scriptCompiler->getLastError();
+	s_reloadingCompiler = &compiler;
+	s_reloadingProgram = program;
+
+	int functionId = scriptCompiler->findFunction("foo", "int");
+	ASSERT_TRUE(functionId >= 0);
+	ScriptTask scriptTask(program);
+	ScriptParamBuffer paramBuffer(10);
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(10 + 20, *(int*)scriptTask.getTaskResult()) << L"the function must not be reloaded while the task runs";
+	EXPECT_EQ(0, program->getRunningTaskCount());
+
+	// a task cannot start while the code is updated
+	ASSERT_TRUE(program->beginCodeUpdate());
+	EXPECT_THROW(scriptTask.runFunction(functionId, &paramBuffer), std::runtime_error);
+	program->endCodeUpdate();
+
+	const wchar_t* newWeight = L"int weight(int n) { return n * 3; }";
+	ASSERT_TRUE(compiler.reloadFunction(program, newWeight, newWeight + wcslen(newWeight))) << scriptCompiler->getLastError();
+	s_reloadingCompiler = nullptr;
+	s_reloadingProgram = nullptr;
+	delete program;
+}
+
+TEST(CompileSuite, GlobalDataView)
+{
+	const wchar_t* scriptCode =
+		L"struct Point {"
+		L"	int x;"
+		L"	int y;"
+		L"}"
+		L"int counter = 100;"
+		L"Point pt;"
+		L"int bump(int n) {"
+		L"	counter = counter + n;"
+		L"	pt.y = counter;"
+		L"	return pt.y;"
+		L"}";
+
+	CompilerSuite compiler;
+	compiler.initialize(1024);
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << compiler.getCompiler()->getLastError();
+	auto rootScope = compiler.getGlobalScope();
+	rootScope->runGlobalCode();
+	int functionId = compiler.getCompiler()->findFunction("bump", "int");
+	ASSERT_TRUE(functionId >= 0);
+
+	auto image = std::make_shared<GlobalDataImage>(rootScope.get());
+	const int threadCount = 4;
+	const int loopCount = 1000;
+	std::vector<int> results(threadCount, 0);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < threadCount; i++) {
+		threads.emplace_back([&, i]() {
+			ScriptTask scriptTask(program);
+			scriptTask.setGlobalDataView(std::make_shared<GlobalDataView>(image));
+			ScriptParamBuffer paramBuffer(i + 1);
+			for (int j = 0; j < loopCount; j++) {
+				scriptTask.runFunction(functionId, &paramBuffer);
+			}
+			results[i] = *(int*)scriptTask.getTaskResult();
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	// each task updates its own copy of the global variables
+	for (int i = 0; i < threadCount; i++) {
+		EXPECT_EQ(100 + (i + 1) * loopCount, results[i]);
+	}
+	int* counter = (int*)rootScope->getGlobalAddress(rootScope->findVariable("counter")->getOffset());
+	EXPECT_EQ(100, *counter) << L"global memory of the program must not be changed";
+
+	// the tasks without a view still use the global memory of the program
+	ScriptTask scriptTask(program);
+	ScriptParamBuffer paramBuffer(5);
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(105, *(int*)scriptTask.getTaskResult());
+	EXPECT_EQ(105, *counter);
+
+	rootScope->cleanupGlobalMemory();
+	delete program;
+}
+
+TEST(CompileSuite, GlobalDataViewNonCopyable)
+{
+	const wchar_t* scriptCode =
+		L"String name = \"image\";"
+		L"int counter = 0;"
+		L"void setFirst() {"
+		L"	name = \"first\";"
+		L"	counter = counter + 1;"
+		L"}"
+		L"void setSecond() {"
+		L"	name = \"second\";"
+		L"	counter = counter + 1;"
+		L"}";
+
+	CompilerSuite compiler;
+	compiler.initialize(1024);
+	auto rootScope = compiler.getGlobalScope();
+	auto scriptCompiler = rootScope->getCompiler();
+	includeRawStringToCompiler(scriptCompiler);
+	scriptCompiler->beginUserLib();
+
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << scriptCompiler->getLastError();
+	rootScope->runGlobalCode();
+
+	// the string owns heap memory, a byte copy would share it between the image and the views
+	EXPECT_THROW(std::make_shared<GlobalDataImage>(rootScope.get()), std::runtime_error);
+	const Variable* variable = rootScope->findNonCopyableVariable();
+	ASSERT_NE(nullptr, variable);
+	EXPECT_EQ("name", variable->getName());
+
+	// without views the two tasks write the string of the program one after the other
+	int firstId = scriptCompiler->findFunction("setFirst", "");
+	int secondId = scriptCompiler->findFunction("setSecond", "");
+	ASSERT_TRUE(firstId >= 0 && secondId >= 0);
+	RawString* name = (RawString*)rootScope->getGlobalAddress(rootScope->findVariable("name")->getOffset());
+	{
+		ScriptTask firstTask(program);
+		ScriptTask secondTask(program);
+		firstTask.runFunction(firstId, nullptr);
+		EXPECT_EQ(0, wcscmp(L"first", name->elms));
+		secondTask.runFunction(secondId, nullptr);
+		EXPECT_EQ(0, wcscmp(L"second", name->elms));
+	}
+	EXPECT_EQ(2, *(int*)rootScope->getGlobalAddress(rootScope->findVariable("counter")->getOffset()));
+
+	rootScope->cleanupGlobalMemory();
+	delete program;
+}
+
+TEST(CompileSuite, GlobalDataViewFunctionObject)
+{
+	// a function object without captured data is copied with the image
+	const wchar_t* scriptCode =
+		L"int twice(int n) {"
+		L"	return n * 2;"
+		L"}"
+		L"function<int(int)> f = twice;"
+		L"int run(int n) {"
+		L"	return f(n);"
+		L"}";
+
+	CompilerSuite compiler;
+	compiler.initialize(1024);
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << compiler.getCompiler()->getLastError();
+	auto rootScope = compiler.getGlobalScope();
+	rootScope->runGlobalCode();
+	EXPECT_EQ(nullptr, rootScope->findNonCopyableVariable());
+
+	int functionId = compiler.getCompiler()->findFunction("run", "int");
+	ASSERT_TRUE(functionId >= 0);
+	auto image = std::make_shared<GlobalDataImage>(rootScope.get());
+	ScriptTask scriptTask(program);
+	scriptTask.setGlobalDataView(std::make_shared<GlobalDataView>(image));
+	ScriptParamBuffer paramBuffer(21);
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(42, *(int*)scriptTask.getTaskResult());
+
+	rootScope->cleanupGlobalMemory();
+	delete program;
+}
+
+TEST(CompileSuite, ScriptProfiler)
+{
+	const wchar_t* scriptCode =
+		L"int leaf(int n) {"
+		L"	int sum = 0;"
+		L"	while(n > 0) {"
+		L"		sum = sum + n;"
+		L"		n = n - 1;"
+		L"	}"
+		L"	return sum;"
+		L"}"
+		L"int work(int n) {"
+		L"	return leaf(n) + leaf(n);"
+		L"}";
+
+	CompilerSuite compiler;
+	compiler.initialize(1024);
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << compiler.getCompiler()->getLastError();
+	int functionId = compiler.getCompiler()->findFunction("work", "int");
+	ASSERT_TRUE(functionId >= 0);
+
+	ScriptProfiler profiler(program, compiler.getCompiler().get());
+	ScriptTask scriptTask(program);
+	scriptTask.setProfiler(&profiler);
+	profiler.start(100);
+	ScriptParamBuffer paramBuffer(10000);
+#if FFSCRIPT_INSTRUMENTATION
+	auto beginTime = std::chrono::steady_clock::now();
+	while (profiler.getSampleCount() < 20 && std::chrono::steady_clock::now() - beginTime < std::chrono::seconds(10)) {
+		scriptTask.runFunction(functionId, &paramBuffer);
+		EXPECT_EQ(100010000, *(int*)scriptTask.getTaskResult());
+	}
+	profiler.stop();
+	ASSERT_TRUE(profiler.getSampleCount() >= 20);
+
+	std::stringstream foldedStacks;
+	profiler.writeFoldedStacks(foldedStacks);
+	std::string line;
+	int sampleCount = 0;
+	while (std::getline(foldedStacks, line)) {
+		auto separator = line.rfind(' ');
+		ASSERT_NE(std::string::npos, separator);
+		std::string stack = line.substr(0, separator);
+		EXPECT_EQ(0u, stack.find("int work(int)")) << stack;
+		sampleCount += std::stoi(line.substr(separator + 1));
+	}
+	EXPECT_EQ(profiler.getSampleCount(), sampleCount);
+
+	std::stringstream functionTable;
+	profiler.writeFunctionTable(functionTable);
+	std::getline(functionTable, line);
+	std::getline(functionTable, line);
+	// most of the time is spent in the loop of 'leaf'
+	EXPECT_EQ(0u, line.find("int leaf(int)\t")) << functionTable.str();
+#else
+	// the contexts do not track their call frames, so the sample requests are ignored
+	scriptTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(100010000, *(int*)scriptTask.getTaskResult());
+	profiler.stop();
+	EXPECT_EQ(0, profiler.getSampleCount());
+#endif
+}
+
+TEST(CompileSuite, Instrumentation)
+{
+	const wchar_t* scriptCode =
+		L"int leaf(int n) {"
+		L"	int sum = 0;"
+		L"	while(n > 0) {"
+		L"		sum = sum + n;"
+		L"		n = n - 1;"
+		L"	}"
+		L"	return sum;"
+		L"}"
+		L"int work(int n) {"
+		L"	return leaf(n) + leaf(n);"
+		L"}";
+
+	CompilerSuite compiler;
+	compiler.initialize(1024);
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << compiler.getCompiler()->getLastError();
+	int functionId = compiler.getCompiler()->findFunction("work", "int");
+	ASSERT_TRUE(functionId >= 0);
+
+	Context context(1024 * 1024);
+	ScriptRunner scriptRunner(program, functionId);
+	Instrumentation* instrumentation = context.getInstrumentation();
+#if FFSCRIPT_INSTRUMENTATION
+	ASSERT_NE(nullptr, instrumentation);
+	instrumentation->setTraceCapacity(16);
+
+	ScriptParamBuffer paramBuffer(10);
+	scriptRunner.runFunction(&paramBuffer);
+	EXPECT_EQ(110, *(int*)scriptRunner.getTaskResult());
+
+	ContextStatistics statistics;
+	instrumentation->getStatistics(statistics);
+	// 'work' and two calls of 'leaf'
+	EXPECT_EQ(3u, statistics.scriptCallCount);
+	EXPECT_EQ(statistics.scopeEnterCount, statistics.scopeExitCount);
+	EXPECT_TRUE(statistics.scopeEnterCount >= 3);
+
+	unsigned long long commandCount = 0;
+	for (auto it = statistics.commandCountByClass.begin(); it != statistics.commandCountByClass.end(); ++it) {
+		commandCount += it->second;
+	}
+	EXPECT_TRUE(statistics.commandCount > 20);
+	EXPECT_EQ(statistics.commandCount, commandCount);
+
+	// the ring buffer keeps the last events only
+	std::vector<TraceRecord> records;
+	instrumentation->getTraceRecords(records);
+	ASSERT_EQ(16u, records.size());
+	for (size_t i = 1; i < records.size(); i++) {
+		EXPECT_TRUE(records[i - 1].sequence <= records[i].sequence);
+	}
+	EXPECT_EQ(statistics.commandCount, records.back().sequence);
+
+	std::stringstream trace;
+	instrumentation->writeTrace(trace);
+	EXPECT_EQ(8 + sizeof(unsigned long long) + 16 * sizeof(TraceRecord), trace.str().size());
+	EXPECT_EQ(0u, trace.str().find("FFTRACE1"));
+
+	instrumentation->reset();
+	instrumentation->getStatistics(statistics);
+	EXPECT_EQ(0u, statistics.commandCount);
+	EXPECT_EQ(0u, statistics.commandCountByClass.size());
+#else
+	EXPECT_EQ(nullptr, instrumentation);
+#endif
+}
+
+static int tripleValue(int n) {
+	return n * 3;
+}
+
+TEST(CompileSuite, InstrumentationForwardedNativeCall)
+{
+	CompilerSuite compiler;
+	compiler.initialize(64);
+	compiler.setDebugInfoEnabled(true);
+	auto scriptCompiler = compiler.getCompiler();
+	FunctionRegisterHelper fb(scriptCompiler.get());
+	registerFunction<int, int>(fb, tripleValue, "triple", "int", "int");
+	scriptCompiler->beginUserLib();
+
+	// a parameter is never a known target, so the native function is called through the forwarder
+	const wchar_t* scriptCode =
+		L"int apply(function<int(int)> f, int n) {"
+		L"	return f(n);"
+		L"}"
+		L"int foo() {"
+		L"	return apply(triple, 2) + apply(triple, 3);"
+		L"}";
+
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << scriptCompiler->getLastError();
+	int functionId = scriptCompiler->findFunction("foo", "");
+	ASSERT_TRUE(functionId >= 0);
+
+	Context context(1024 * 1024);
+	ScriptRunner scriptRunner(program, functionId);
+	scriptRunner.runFunction(nullptr);
+	EXPECT_EQ(15, *(int*)scriptRunner.getTaskResult());
+#if FFSCRIPT_INSTRUMENTATION
+	ContextStatistics statistics;
+	context.getInstrumentation()->getStatistics(statistics, program->getDebugInfo());
+	// the operator + and the two calls of triple made by the forwarder
+	EXPECT_EQ(3u, statistics.nativeCallCount);
+	EXPECT_EQ(1u, statistics.nativeCallCountByName["+"]);
+#else
+	EXPECT_EQ(nullptr, context.getInstrumentation());
+#endif
+}
+
+TEST(CompileSuite, PlainCodeOptimizer)
+{
+	// the same script is compiled with and without the clean-up pass and both programs must
+	// return the same result
+	const wchar_t* scriptCode =
+		L"int foo(int n) {"
+		L"	int res = 0;"
+		L"	while(n > 0) {"
+		L"		if(n > 10) {"
+		L"			while(n > 0) {"
+		L"				n = n - 1;"
+		L"				res = res + 1;"
+		L"				break;"
+		L"			}"
+		L"		}"
+		L"		else {"
+		L"			n = n - 2;"
+		L"			res = res + 2;"
+		L"			continue;"
+		L"		}"
+		L"	}"
+		L"	return res;"
+		L"}";
+
+	CompilerSuite compiler;
+	compiler.initialize(64);
+	compiler.getGlobalScope()->setPlainCodeOptimization(false);
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << compiler.getCompiler()->getLastError();
+	int commandCount = program->getCommandCount();
+	EXPECT_EQ(0, program->getEliminatedCommandCount());
+
+	int functionId = compiler.getCompiler()->findFunction("foo", "int");
+	ScriptParamBuffer paramBuffer(15);
+	ScriptTask scriptTask(program);
+	scriptTask.runFunction(functionId, &paramBuffer);
+	int res = *(int*)scriptTask.getTaskResult();
+	delete program;
+
+	CompilerSuite optimizingCompiler;
+	optimizingCompiler.initialize(64);
+	program = optimizingCompiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << optimizingCompiler.getCompiler()->getLastError();
+	// the break command of the inner loop is replaced by its only command
+	EXPECT_EQ(35, commandCount);
+	EXPECT_EQ(34, program->getCommandCount());
+	EXPECT_EQ(1, program->getEliminatedCommandCount());
+
+	functionId = optimizingCompiler.getCompiler()->findFunction("foo", "int");
+	ScriptTask optimizedTask(program);
+	optimizedTask.runFunction(functionId, &paramBuffer);
+	EXPECT_EQ(res, *(int*)optimizedTask.getTaskResult());
+	delete program;
+}
+
+TEST(CompileSuite, PlainCodeOptimizerHandBuiltCode)
+{
+	// jump0 lands on a no-op command, so it goes to the no-op command directly.
+	// Jumps are not threaded over jump2, the scopes entered after jump2 return to the command after it
+	Jump* jump0 = new Jump();
+	MultipleCommand* noOperation = new MultipleCommand();
+	Jump* jump2 = new Jump();
+	MultipleCommand* copyCommands = new MultipleCommand();
+	PushParamOffset* copyCommand4 = new PushParamOffset();
+	copyCommand4->setCommandData(0, 4, 12);
+
+	// the copy to the same offset is removed and the nested command lists are flattened
+	std::unique_ptr<MultipleCommand> nestedCommands(new MultipleCommand());
+	std::unique_ptr<PushParamOffset> deadCopy(new PushParamOffset());
+	std::unique_ptr<PushParamOffset> copyCommand(new PushParamOffset());
+	deadCopy->setCommandData(8, 4, 8);
+	copyCommand->setCommandData(0, 4, 4);
+	nestedCommands->getCommands().push_back(deadCopy.get());
+	copyCommands->getCommands().push_back(nestedCommands.get());
+	copyCommands->getCommands().push_back(copyCommand.get());
+
+	ExecutorRef executor = std::make_shared<Executor>();
+	executor->addCommand(jump0);
+	executor->addCommand(noOperation);
+	executor->addCommand(jump2);
+	executor->addCommand(copyCommands);
+	executor->addCommand(copyCommand4);
+
+	Program program;
+	program.addExecutor(executor);
+	program.convertToPlainCode();
+	CommandPointer code = program.getFirstCommand();
+	jump0->setCommandData(code);
+	jump2->setCommandData(code + 3);
+	EXPECT_EQ(8, program.getCommandCount());
+
+	EXPECT_EQ(3, program.optimizePlainCode());
+	EXPECT_EQ(5, program.getCommandCount());
+	EXPECT_EQ(code + 1, jump0->getTargetCommand());
+	EXPECT_EQ(code + 3, jump2->getTargetCommand());
+	EXPECT_EQ(copyCommand.get(), code[3]);
+}
+
+TEST(CompileSuite, ClearUserOverloads)
+{
+	FuncLibrary functionLibrary;
+	ScriptType intType(1, "int");
+	ScriptType floatType(2, "float");
+	ASSERT_TRUE(functionLibrary.mapFunction("add", { intType, intType }, 0));
+
+	// the user library overloads a name of the system library and adds a new name
+	functionLibrary.beginUserLib();
+	ASSERT_TRUE(functionLibrary.mapFunction("add", { floatType, floatType }, 1));
+	ASSERT_TRUE(functionLibrary.mapFunction("foo", { intType }, 2));
+	EXPECT_EQ(2, functionLibrary.findOverloadingFuncRoot("add")->size());
+	functionLibrary.clearUserLib();
+
+	EXPECT_EQ(1, functionLibrary.getFunctionCount());
+	ASSERT_NE(nullptr, functionLibrary.findOverloadingFuncRoot("add"));
+	EXPECT_EQ(1, functionLibrary.findOverloadingFuncRoot("add")->size());
+	EXPECT_EQ(0, functionLibrary.findOverloadingFuncRoot("add")->front().functionId);
+	EXPECT_EQ(nullptr, functionLibrary.findFunctionInfo(1));
+	EXPECT_EQ(nullptr, functionLibrary.findOverloadingFuncRoot("foo"));
+	EXPECT_NE(nullptr, functionLibrary.findFunctionInfo(0));
+
+	// the same overload can be mapped again by the next user library
+	functionLibrary.beginUserLib();
+	EXPECT_TRUE(functionLibrary.mapFunction("add", { floatType, floatType }, 1));
+}
+
+TEST(CompileSuite, ScopeRuntimeDataSize)
+{
+	EXPECT_EQ(nullptr, ScopeRuntimeData::createRuntimeData(0));
+
+	ScopeRuntimeData* fixSizeData = ScopeRuntimeData::createRuntimeData(8);
+	ASSERT_NE(nullptr, fixSizeData);
+	EXPECT_EQ((unsigned int)sizeof(ScopeRuntimeDataFixSize), fixSizeData->getAllocatedSize());
+	delete fixSizeData;
+
+	// 20 constructor flags need 3 bytes
+	ScopeRuntimeData* dynamicSizeData = ScopeRuntimeData::createRuntimeData(20);
+	ASSERT_NE(nullptr, dynamicSizeData);
+	EXPECT_EQ((unsigned int)sizeof(ScopeRuntimeDataDynamicSize) + 3, dynamicSizeData->getAllocatedSize());
+	for (int i = 0; i < 20; i++) {
+		EXPECT_EQ(0, dynamicSizeData->isContructorExecuted(i));
+	}
+	dynamicSizeData->markContructorExecuted(19);
+	EXPECT_NE(0, dynamicSizeData->isContructorExecuted(19));
+	dynamicSizeData->markContructorNotExecuted(19);
+	EXPECT_EQ(0, dynamicSizeData->isContructorExecuted(19));
+	delete dynamicSizeData;
+}
+
+TEST(CompileSuite, StackAnalysis)
+{
+	const wchar_t* scriptCode =
+		L"int leaf(int n) {"
+		L"	int sum = 0;"
+		L"	while(n > 0) {"
+		L"		int k = n * 2;"
+		L"		sum = sum + k;"
+		L"		n = n - 1;"
+		L"	}"
+		L"	return sum;"
+		L"}"
+		L"int work(int n) {"
+		L"	int a = leaf(n);"
+		L"	return a + leaf(n + 1);"
+		L"}"
+		L"int fact(int n) {"
+		L"	if(n <= 1) {"
+		L"		return 1;"
+		L"	}"
+		L"	return n * fact(n - 1);"
+		L"}";
+
+	CompilerSuite compiler;
+	compiler.initialize(1024);
+	Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << compiler.getCompiler()->getLastError();
+	int workId = compiler.getCompiler()->findFunction("work", "int");
+	int leafId = compiler.getCompiler()->findFunction("leaf", "int");
+	int factId = compiler.getCompiler()->findFunction("fact", "int");
+	ASSERT_TRUE(workId >= 0 && leafId >= 0 && factId >= 0);
+
+	int leafStackSize = program->getFunctionStackSize(leafId);
+	int workStackSize = program->getFunctionStackSize(workId);
+	EXPECT_TRUE(leafStackSize > 0);
+	EXPECT_TRUE(workStackSize > leafStackSize);
+	EXPECT_EQ(-1, program->getFunctionStackSize(factId)) << "recursive function";
+
+	// the function runs in a context which has exactly the computed stack size
+	ScriptRunner scriptRunner(program, workId);
+	int stackSize = scriptRunner.getStackSize();
+	ASSERT_TRUE(stackSize > workStackSize);
+	EXPECT_TRUE(stackSize < 1024);
+
+	Context context(stackSize);
+	ScriptParamBuffer paramBuffer(10);
+	scriptRunner.runFunction(&paramBuffer);
+	EXPECT_EQ(110 + 132, *(int*)scriptRunner.getTaskResult());
+	EXPECT_TRUE(context.getStackHighWaterMark() >= (unsigned int)workStackSize);
+	EXPECT_TRUE(context.getStackHighWaterMark() <= (unsigned int)stackSize);
+
+	ScriptRunner factRunner(program, factId);
+	EXPECT_EQ(-1, factRunner.getStackSize());
+
+	// a task uses the computed stack size when no size is given
+	ScriptTask scriptTask(program);
+	scriptTask.runFunction(factId, ScriptParamBuffer(5));
+	EXPECT_EQ(120, *(int*)scriptTask.getTaskResult());
+	scriptTask.runFunction(workId, &paramBuffer);
+	EXPECT_EQ(110 + 132, *(int*)scriptTask.getTaskResult());
+}
+
 #if 0
 TEST(CompileSuite, TestSemiRef04)
 {
@@ -1502,4 +2443,70 @@ TEST(CompileSuite, TestSemiRef07)
 	ScriptParamBuffer paramBuffer(3);
 	scriptTask.runFunction(functionId, paramBuffer);
 }
-#endif
\ No newline at end of file
+#endif
+
+TEST(CompileSuite, DebugInfo)
+{
+	const wchar_t* scriptCode =
+		L"int add(int a, int b) {\n"
+		L"	return a + b;\n"
+		L"}\n"
+		L"int fact(int n) {\n"
+		L"	if(n <= 1) {\n"
+		L"		return 1;\n"
+		L"	}\n"
+		L"	int m = add(n, -1);\n"
+		L"	return n * fact(m);\n"
+		L"}\n";
+
+	CompilerSuite releaseCompiler;
+	releaseCompiler.initialize(1024);
+	Program* program = releaseCompiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << releaseCompiler.getCompiler()->getLastError();
+	EXPECT_EQ(nullptr, program->getDebugInfo()) << "debug info is not created by default";
+	delete program;
+
+	CompilerSuite compiler;
+	compiler.initialize(1024);
+	compiler.setDebugInfoEnabled(true);
+	program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+	ASSERT_NE(nullptr, program) << compiler.getCompiler()->getLastError();
+	DebugInfo* debugInfo = program->getDebugInfo();
+	ASSERT_NE(nullptr, debugInfo);
+	EXPECT_TRUE(debugInfo->getSourceRangeCount() > 0);
+
+	int factId = compiler.getCompiler()->findFunction("fact", "int");
+	ASSERT_TRUE(factId >= 0);
+	CodeSegmentEntry* factCode = program->getFunctionPlainCode(factId);
+	ASSERT_NE(nullptr, factCode);
+
+	// the calls are named by the table
+	std::list<std::string> commandTexts;
+	debugInfo->buildCommandText(factCode->first, factCode->second + 1, commandTexts);
+	bool addNamed = false;
+	for (auto& commandText : commandTexts) {
+		if (commandText.find("invoke (add") == 0) addNamed = true;
+	}
+	EXPECT_TRUE(addNamed);
+
+	// all positions of the function are in its lines
+	int minLine = -1, maxLine = -1;
+	for (auto command = factCode->first; command <= factCode->second; command++) {
+		auto position = debugInfo->getSourcePosition(command);
+		if (position == nullptr) continue;
+		if (minLine < 0 || position->line < minLine) minLine = position->line;
+		if (position->line > maxLine) maxLine = position->line;
+	}
+	EXPECT_EQ(4, minLine);
+	EXPECT_EQ(8, maxLine);
+
+	// a runtime error is reported at the line of the command which is running
+	ScriptRunner scriptRunner(program, factId);
+	Context context(256);
+	ScriptParamBuffer paramBuffer(1000);
+	EXPECT_THROW(scriptRunner.runFunction(&paramBuffer), std::exception);
+	auto position = debugInfo->getSourcePosition(context.getCurrentCommand());
+	ASSERT_NE(nullptr, position);
+	EXPECT_TRUE(position->line >= 4 && position->line <= 8);
+	delete program;
+}
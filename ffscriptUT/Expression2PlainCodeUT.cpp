@@ -1252,5 +1252,51 @@ namespace ffscriptUT
 			int* x = getVaribleRef<int>(*pX);
 			FF_EXPECT_TRUE(*x == stringValue.length());
 		}
+
+		//test param space of sibling sub expressions is reused
+		FF_TEST_FUNCTION(Expression2PlainCode, Expression2PlainCodeReuseLocalSpace)
+		{
+			ScriptCompiler scriptCompiler;
+			ExpressionParser parser(&scriptCompiler);
+			FunctionRegisterHelper funcLibHelper(&scriptCompiler);
+			const BasicTypes& basicType = scriptCompiler.getTypeManager()->getBasicTypes();
+			Context currentContext(1024 * 1024);
+
+			scriptCompiler.getTypeManager()->registerBasicTypes(&scriptCompiler);
+			importBasicfunction(funcLibHelper);
+
+			wstring functionString = L"(1 + 2) * (3 + 4) - (5 + 6) * (7 + 8)";
+
+			list<ExpUnitRef> units;
+			EExpressionResult eResult = parser.tokenize(functionString.c_str(), units);
+
+			FF_EXPECT_TRUE(eResult == EE_SUCCESS, L"parse string to units failed");
+
+			list<ExpressionRef> expList;
+			bool res = parser.compile(units, expList);
+			units.clear();
+
+			FF_EXPECT_TRUE(res, (L"compile '" + functionString + L"' failed!").c_str());
+
+			eResult = parser.link(expList.front().get());
+			FF_EXPECT_TRUE(eResult == EE_SUCCESS, (L"link expression '" + functionString + L"' failed.").c_str());
+
+			ExpUnitExecutor excutor(scriptCompiler.currentScope());
+			res = excutor.extractCode(&scriptCompiler, expList.front().get());
+
+			FF_EXPECT_TRUE(res, (L"convert expression '" + functionString + L"' to plain code failed!").c_str());
+
+#if REUSE_EXPRESSION_LOCAL_SPACE
+			// return data + params of '-' + params of '*' + params of '+'
+			int paramSize = scriptCompiler.getTypeSizeInStack(basicType.TYPE_INT);
+			FF_EXPECT_EQ(scriptCompiler.getTypeSize(basicType.TYPE_INT) + 3 * 2 * paramSize, excutor.getLocalSize());
+#endif
+
+			excutor.runCode();
+			void* result = excutor.getReturnData();
+
+			FF_EXPECT_TRUE(result != nullptr, (L"run expression '" + functionString + L"' failed!").c_str());
+			FF_EXPECT_EQ(-144, *(int*)result, (L"result of expression '" + functionString + L"' is not correct").c_str());
+		}
 	};
 }
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include <CompilerSuite.h>
 #include <ScriptTask.h>
 #include <Utils.h>
+#include <InstructionCommand.h>
 
 using namespace std;
 using namespace ffscript;
@@ -22,6 +23,21 @@ namespace ffscriptUT
 {		
 	namespace FunctionPointerUT
 	{
+		// count the commands that call a function through a function object
+		static int countForwardCalls(Program* program) {
+			std::list<std::string> strCommands;
+			for (auto commandPointer = program->getFirstCommand(); commandPointer != program->getEndCommand(); commandPointer++) {
+				(*commandPointer)->buildCommandText(strCommands);
+			}
+			int count = 0;
+			for (auto& strCommand : strCommands) {
+				if (strCommand.find("call (") == 0) {
+					count++;
+				}
+			}
+			return count;
+		}
+
 		FF_TEST_FUNCTION(FunctionPointer, ParseNormalTypeUT1)
 		{
 			CompilerSuite compiler;
@@ -663,5 +679,95 @@ namespace ffscriptUT
 
 			FF_EXPECT_FALSE(*funcRes, (L"program can run but return wrong value: " + std::to_wstring(*s)).c_str());
 		}
+
+		FF_TEST_FUNCTION(FunctionPointer, CallKnownTarget1)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(128);
+			GlobalScopeRef rootScope = compiler.getGlobalScope();
+			auto scriptCompiler = rootScope->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"function<long(long)> fy;"
+				L"long X(long n) {"
+				L"	if(n < 1) {"
+				L"		return 1;"
+				L"	}"
+				L"	return X(n - 1) + fy(n - 1);"
+				L"}"
+				L"long Y(long n) {"
+				L"	if(n < 1) {"
+				L"		return 1;"
+				L"	}"
+				L"	return 2 * X(n - 1) * Y(n - 1);"
+				L"}"
+				L"fy = Y;"
+				L"long foo() {"
+				L"	f2 = [](long n) -> long {"
+				L"		return n + 1;"
+				L"	};"
+				L"	function<long(long)> f3 = X;"
+				L"	return f2(1) + f3(3);"
+				L"}"
+				;
+
+			scriptCompiler->beginUserLib();
+			Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+			FF_EXPECT_NE(nullptr, program, L"Compile program failed");
+
+			// all function objects are assigned once to a known function
+			// so they must be called directly
+			EXPECT_EQ(0, countForwardCalls(program));
+
+			int functionId = scriptCompiler->findFunction("foo", "");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'foo'");
+
+			rootScope->runGlobalCode();
+			ScriptTask scriptTask(program);
+			scriptTask.runFunction(functionId, nullptr);
+			long long* funcRes = (long long*)scriptTask.getTaskResult();
+
+			EXPECT_EQ(2 + 12, *funcRes);
+			rootScope->cleanupGlobalMemory();
+		}
+
+		FF_TEST_FUNCTION(FunctionPointer, CallUnknownTarget1)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			GlobalScopeRef rootScope = compiler.getGlobalScope();
+			auto scriptCompiler = rootScope->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"int test1(int a) {"
+				L"	return a + 1;"
+				L"}"
+				L"int test2(int a) {"
+				L"	return a + 2;"
+				L"}"
+				L"int foo() {"
+				L"	function<int(int)> f = test1;"
+				L"	int res = f(1);"
+				L"	f = test2;"
+				L"	return res + f(1);"
+				L"}"
+				;
+
+			scriptCompiler->beginUserLib();
+			Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+			FF_EXPECT_NE(nullptr, program, L"Compile program failed");
+
+			// the function object refers to two functions, so it must be called through the forwarder
+			EXPECT_EQ(2, countForwardCalls(program));
+
+			int functionId = scriptCompiler->findFunction("foo", "");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'foo'");
+
+			ScriptTask scriptTask(program);
+			scriptTask.runFunction(functionId, nullptr);
+			int* funcRes = (int*)scriptTask.getTaskResult();
+
+			EXPECT_EQ(2 + 3, *funcRes);
+		}
 	};
 }
\ No newline at end of file
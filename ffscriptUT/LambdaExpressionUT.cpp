@@ -387,5 +387,80 @@ namespace ffscriptUT
 
             FF_EXPECT_TRUE(*funcRes == 1000000, L"program can run but return wrong value");
 		}
+
+		FF_TEST_FUNCTION(LambdaExpression, CompileLambdaInlineCapture)
+		{
+			CompilerSuite compiler;
+
+			//the code does not contain any global scope'code and only a variable
+			//so does not need global memory
+			compiler.initialize(8);
+			GlobalScopeRef rootScope = compiler.getGlobalScope();
+			auto scriptCompiler = rootScope->getCompiler();
+
+			// captured data of the lambda fits in the function object
+			const wchar_t* scriptCode =
+				L"int foo() {"
+				L"	int i = 0;"
+				L"	int sum = 0;"
+				L"	while(i < 10) {"
+				L"		f = [i, sum](int a) -> int { return i + sum + a; };"
+				L"		function<int(int)> g = f;"
+				L"		sum = g(1);"
+				L"		i++;"
+				L"	}"
+				L"	return sum;"
+				L"}"
+				;
+
+			Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+			FF_EXPECT_NE(nullptr, program, L"Compile program failed");
+
+			int functionId = scriptCompiler->findFunction("foo", "");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'foo'");
+
+			ScriptTask scriptTask(program);
+			scriptTask.runFunction(functionId, nullptr);
+			int* funcRes = (int*)scriptTask.getTaskResult();
+
+			FF_EXPECT_EQ(55, *funcRes, L"program can run but return wrong value");
+		}
+
+		FF_TEST_FUNCTION(LambdaExpression, CompileLambdaHeapCapture)
+		{
+			CompilerSuite compiler;
+
+			//the code does not contain any global scope'code and only a variable
+			//so does not need global memory
+			compiler.initialize(8);
+			GlobalScopeRef rootScope = compiler.getGlobalScope();
+			auto scriptCompiler = rootScope->getCompiler();
+
+			// captured data of the lambda is larger than the inline buffer of the function object
+			const wchar_t* scriptCode =
+				L"long foo() {"
+				L"	long a = 1;"
+				L"	long b = 2;"
+				L"	long c = 3;"
+				L"	long d = 4;"
+				L"	long e = 5;"
+				L"	f = [a, b, c, d, e]() -> long { return a + b + c + d + e; };"
+				L"	function<long()> g = f;"
+				L"	return f() + g();"
+				L"}"
+				;
+
+			Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+			FF_EXPECT_NE(nullptr, program, L"Compile program failed");
+
+			int functionId = scriptCompiler->findFunction("foo", "");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'foo'");
+
+			ScriptTask scriptTask(program);
+			scriptTask.runFunction(functionId, nullptr);
+			long long* funcRes = (long long*)scriptTask.getTaskResult();
+
+			FF_EXPECT_EQ(30, *funcRes, L"program can run but return wrong value");
+		}
 	};
 }
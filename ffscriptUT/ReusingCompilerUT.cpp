@@ -198,5 +198,39 @@ namespace ffscriptUT
 			FF_EXPECT_TRUE(*funcRes == n, L"program can run but return wrong value");
 			PRINT_TEST_MESSAGE(("fibonaci(fake) =" + std::to_string(*funcRes)).c_str());
 		}
+
+		FF_TEST_FUNCTION(ReusingCompiler, ClearUserLibRemovesUserFunctions)
+		{
+			ScriptCompiler scriptCompiler;
+			FunctionRegisterHelper funcLibHelper(&scriptCompiler);
+			scriptCompiler.getTypeManager()->registerBasicTypes(&scriptCompiler);
+			scriptCompiler.getTypeManager()->registerBasicTypeCastFunctions(&scriptCompiler, funcLibHelper);
+			importBasicfunction(funcLibHelper);
+
+			scriptCompiler.beginUserLib();
+
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext, &scriptCompiler);
+
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			const wchar_t* scriptCode =
+				L"int foo(int n) {"
+				L"	return n + 1;"
+				L"}"
+				;
+
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			FF_EXPECT_TRUE(res != nullptr, L"compile program failed");
+			FF_EXPECT_TRUE(scriptCompiler.findOverloadingFuncRoot("foo") != nullptr, L"cannot find function 'foo'");
+
+			scriptCompiler.clearUserLib();
+			rootScope.clear();
+
+			FF_EXPECT_TRUE(scriptCompiler.findOverloadingFuncRoot("foo") == nullptr, L"function 'foo' should be removed with user library");
+			FF_EXPECT_TRUE(scriptCompiler.findOverloadingFuncRoot("+") != nullptr, L"system functions should not be removed");
+		}
 	};
 }
\ No newline at end of file
@@ -55,6 +55,14 @@ namespace ffscriptUT
 			return sum;
 		}
 
+		static int sumVariants(const SimpleVariant* params, int paramCount) {
+			int sum = 0;
+			for (int i = 0; i < paramCount; i++) {
+				sum += *((int*)params[i].pData) * params[i].size;
+			}
+			return sum;
+		}
+
 		static int productTypes(SimpleVariantArray* params) {
 			int prod = 1;
 			for (int i = 0; i < params->size; i++) {
@@ -84,6 +92,8 @@ namespace ffscriptUT
 			funcLibHelper.getSriptCompiler()->registDynamicFunction("productTypes", dynamicFunctionFactory3);
 			funcLibHelper.addFactory(dynamicFunctionFactory3);
 
+			registerDynamicFunction<int>(funcLibHelper, sumVariants, "sumVariants", "int");
+
 			//create a static context
 			_staticContext = new StaticContext(_buffer, sizeof(_buffer));
 		}
@@ -220,5 +230,23 @@ namespace ffscriptUT
 
 			FF_EXPECT_EQ(product(4,5) * 6 + 6, *result, (L"result of expression '" + exp + L"' should be 126").c_str());
 		}
+
+		FF_TEST_METHOD(RunDynamicFunction, RunDynamicVariants1)
+		{
+			wstring exp = L"sumVariants(1,2,3)";
+			ExpUnitExecutor* pExcutor = compileExpression(&scriptCompiler, exp);
+			FF_EXPECT_TRUE(pExcutor != nullptr, (L"compile '" + exp + L"' failed!").c_str());
+
+			unique_ptr<ExpUnitExecutor> excutor(pExcutor);
+
+			// run twice to make sure the prebuilt param array is reused correctly
+			excutor->runCode();
+			excutor->runCode();
+			int* result = (int*)excutor->getReturnData();
+
+			FF_EXPECT_TRUE(result != nullptr, (L"run expression '" + exp + L"' failed!").c_str());
+
+			FF_EXPECT_EQ(6 * (int)sizeof(int), *result, (L"result of expression '" + exp + L"' should be 24").c_str());
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+/******************************************************************
+* File:        ScriptLexerUT.cpp
+* Description: Test cases for the script lexer, the SIMD scanners must
+*              give the same result as the scalar ones.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <ScriptLexer.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace ScriptLexerUT
+	{
+		static wstring generateScript(int functionCount) {
+			wstring script;
+			for (int i = 0; i < functionCount; i++) {
+				auto index = to_wstring(i);
+				script += L"// function number " + index + L"\n";
+				script += L"float compute_" + index + L"(int nValue, float fFactor) {\n";
+				script += L"\tfloat result = nValue * 1.5f + fFactor;\n";
+				script += L"\tstring message = \"result is \\\"" + index + L"\\\"\";\n";
+				script += L"\tif(result > 100) {\n\t\tresult = result - 100.0;\n\t}\n";
+				script += L"\treturn result;\n}\n\n";
+			}
+			return script;
+		}
+
+		// split the script into runs of the same class, return the end of each run
+		static vector<const wchar_t*> scanRuns(const wstring& script, bool simd) {
+			vector<const wchar_t*> runEnds;
+			bool simdEnabled = ScriptLexer::isSimdEnabled();
+			ScriptLexer::setSimdEnabled(simd);
+			auto end = script.c_str() + script.size();
+			for (auto c = ScriptLexer::skipSpaces(script.c_str(), end); c < end; c = ScriptLexer::skipSpaces(c, end)) {
+				if (iswdigit(*c)) {
+					c = ScriptLexer::skipIdentifierOrDot(c, end);
+				}
+				else if (*c == '\"') {
+					c = ScriptLexer::findEither(c + 1, end, '\"', '\n');
+					c = c < end ? c + 1 : end;
+				}
+				else {
+					auto e = ScriptLexer::skipIdentifier(c, end);
+					c = e > c ? e : c + 1;
+				}
+				runEnds.push_back(c);
+			}
+			ScriptLexer::setSimdEnabled(simdEnabled);
+			return runEnds;
+		}
+
+		FF_TEST_FUNCTION(ScriptLexer, Scanners)
+		{
+			wstring script = L"  \t\nint a_1 = 10.5f;\"x\\\"y\";";
+			auto begin = script.c_str();
+			auto end = begin + script.size();
+
+			EXPECT_EQ(begin + 4, ScriptLexer::skipSpaces(begin, end));
+			EXPECT_EQ(begin + 7, ScriptLexer::skipIdentifier(begin + 4, end));
+			EXPECT_EQ(begin + 11, ScriptLexer::skipIdentifier(begin + 8, end));
+			EXPECT_EQ(begin + 16, ScriptLexer::skipDigits(begin + 14, end));
+			EXPECT_EQ(begin + 19, ScriptLexer::skipIdentifierOrDot(begin + 14, end));
+			EXPECT_EQ(begin + 22, ScriptLexer::findEither(begin + 21, end, '\"', '\\'));
+			EXPECT_EQ(begin + 20, ScriptLexer::findChar(begin, end, '\"'));
+			EXPECT_EQ(end, ScriptLexer::findChar(begin, end, '#'));
+			EXPECT_EQ(end, ScriptLexer::skipSpaces(end, end));
+		}
+
+		FF_TEST_FUNCTION(ScriptLexer, SimdMatchesScalar)
+		{
+			wstring script = generateScript(50);
+			// non ASCII characters are never a part of an identifier
+			script += L"int x\x00e9y = 1;\n";
+
+			auto simdRuns = scanRuns(script, true);
+			auto scalarRuns = scanRuns(script, false);
+			ASSERT_EQ(scalarRuns.size(), simdRuns.size());
+			for (size_t i = 0; i < scalarRuns.size(); i++) {
+				EXPECT_EQ(scalarRuns[i], simdRuns[i]);
+			}
+
+			// scan runs from every position so all block boundaries are checked
+			auto begin = script.c_str();
+			auto end = begin + script.size();
+			for (auto c = begin; c < end; c++) {
+				ScriptLexer::setSimdEnabled(false);
+				auto spaceEnd = ScriptLexer::skipSpaces(c, end);
+				auto identifierEnd = ScriptLexer::skipIdentifier(c, end);
+				auto digitEnd = ScriptLexer::skipDigits(c, end);
+				auto quoteOrNewLine = ScriptLexer::findEither(c, end, '\"', '\n');
+				ScriptLexer::setSimdEnabled(true);
+				EXPECT_EQ(spaceEnd, ScriptLexer::skipSpaces(c, end));
+				EXPECT_EQ(identifierEnd, ScriptLexer::skipIdentifier(c, end));
+				EXPECT_EQ(digitEnd, ScriptLexer::skipDigits(c, end));
+				EXPECT_EQ(quoteOrNewLine, ScriptLexer::findEither(c, end, '\"', '\n'));
+			}
+		}
+
+		FF_TEST_FUNCTION(ScriptLexer, Throughput)
+		{
+			wstring script = generateScript(2000);
+			double megaBytes = script.size() * sizeof(wchar_t) / (1024.0 * 1024.0);
+			const int loopCount = 10;
+
+			bool simdEnabled = ScriptLexer::isSimdEnabled();
+			for (int simd = 0; simd < 2; simd++) {
+				ScriptLexer::setSimdEnabled(simd != 0);
+				vector<const wchar_t*> runEnds;
+
+				auto start = chrono::high_resolution_clock::now();
+				for (int i = 0; i < loopCount; i++) {
+					runEnds = scanRuns(script, simd != 0);
+				}
+				chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+
+				double throughput = megaBytes * loopCount / elapsed.count();
+				RecordProperty(simd ? "SimdMBps" : "ScalarMBps", (int)throughput);
+				EXPECT_LT(0u, runEnds.size());
+			}
+			ScriptLexer::setSimdEnabled(simdEnabled);
+		}
+	}
+}
@@ -1910,5 +1910,85 @@ namespace ffscriptUT
 			auto fRes = *(float*)scriptTask.getTaskResult();
 			FF_EXPECT_EQ(0.0f, fRes, L"function 'foo' return wrong");
 		}
+
+		FF_TEST_METHOD(Struct, TestStructNestedMemberAccess)
+		{
+			byte globalData[1024];
+			StaticContext staticContext(globalData, sizeof(globalData));
+			GlobalScope rootScope(&staticContext,&scriptCompiler);
+
+			importBasicfunction(funcLibHelper);
+
+			//initialize an instance of script program
+			Program theProgram;
+			scriptCompiler.bindProgram(&theProgram);
+
+			const wchar_t* scriptCode =
+				L"struct StructA {"
+				L"	int a;"
+				L"	int b;"
+				L"}"
+
+				L"struct StructB {"
+				L"	int iVal;"
+				L"	StructA a;"
+				L"}"
+
+				L"struct StructC {"
+				L"	int k;"
+				L"	ref StructB pb;"
+				L"	StructB b;"
+				L"}"
+
+				L"int test(StructC obj) {"
+				L"	obj.b.a.b = obj.b.a.b + 1;"
+				L"	obj.pb.a.b = obj.pb.a.b + 2;"
+				L"	return obj.b.a.b + obj.pb.a.b * 10 + obj.k * 100;"
+				L"}"
+				;
+#pragma pack(push)
+#pragma pack(1)
+			struct StructA
+			{
+				int a;
+				int b;
+			};
+			struct StructB
+			{
+				int iVal;
+				StructA a;
+			};
+			struct StructC
+			{
+				int k;
+				StructB* pb;
+				StructB b;
+			};
+#pragma pack(pop)
+			const wchar_t* res = rootScope.parse(scriptCode, scriptCode + wcslen(scriptCode));
+			FF_EXPECT_TRUE(res != nullptr, L"compile program failed");
+
+			bool blRes = rootScope.extractCode(&theProgram);
+			FF_EXPECT_TRUE(blRes, L"extract code failed");
+
+			int functionId = scriptCompiler.findFunction("test", "StructC");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'test'");
+
+			StructB objB = { 7, { 8, 4 } };
+			StructC obj;
+			obj.k = 3;
+			obj.pb = &objB;
+			obj.b.iVal = 1;
+			obj.b.a.a = 2;
+			obj.b.a.b = 5;
+
+			ScriptParamBuffer paramBuffer(obj);
+
+			ScriptTask scriptTask(&theProgram);
+			scriptTask.runFunction(functionId, &paramBuffer);
+			int* iRes = (int*)scriptTask.getTaskResult();
+			FF_EXPECT_EQ(6 + 6 * 10 + 3 * 100, *iRes, L"program can run but return wrong value");
+			FF_EXPECT_EQ(6, objB.a.b, L"member of referenced struct should be updated");
+		}
 	};
 }
\ No newline at end of file